@@ -0,0 +1,935 @@
+#define _POSIX_C_SOURCE 200809L
+#include "batch.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "chr.h"
+#include "compose.h"
+#include "usage.h"
+#include "tilehash.h"
+#include "export.h"
+#include "compact.h"
+#include "replace.h"
+#include "image.h"
+#include "import.h"
+#include "chrfmt.h"
+#include "par.h"
+#include "swrender.h"
+#include "trace.h"
+
+#define BATCH_MAX_WORDS 8
+#define BATCH_LINE      1024
+#define BATCH_PATH      512
+
+/* Output of one `each` job, printed in one piece when it ends. */
+typedef struct {
+    char   *text;
+    size_t  len, cap;
+} BatchLog;
+
+typedef struct {
+    ChrPage      chr;
+    PaletteState pal;
+    ComposeData  compose;
+    UsageIndex   usage;
+    TileHash     tilehash;
+    int          cols, rows;
+    int          format;        /* ChrFormat, or -1 = by extension */
+    const char  *where;         /* "argv 2", "build.txt:14" — for errors */
+    int          jobs;          /* `each` workers, 0 = one per CPU       */
+    BatchLog    *log;           /* NULL = print as we go                 */
+    bool         nested;        /* running an `each` job                 */
+} Batch;
+
+/* Append to log; on failure the text is dropped, never the run. */
+static void log_vadd(BatchLog *log, const char *fmt, va_list ap) {
+    va_list ap2;
+    va_copy(ap2, ap);
+    int n = vsnprintf(NULL, 0, fmt, ap2);
+    va_end(ap2);
+    if (n < 0) return;
+    if (log->len + (size_t)n + 1 > log->cap) {
+        size_t cap = log->cap ? log->cap : 256;
+        while (cap < log->len + (size_t)n + 1) cap *= 2;
+        char *t = realloc(log->text, cap);
+        if (!t) return;
+        log->text = t;
+        log->cap  = cap;
+    }
+    vsnprintf(log->text + log->len, (size_t)n + 1, fmt, ap);
+    log->len += (size_t)n;
+}
+
+static void log_add(BatchLog *log, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    log_vadd(log, fmt, ap);
+    va_end(ap);
+}
+
+/* A command's one-line report. */
+static void say(const Batch *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (b->log) log_vadd(b->log, fmt, ap);
+    else        vprintf(fmt, ap);
+    va_end(ap);
+}
+
+static int fail(const Batch *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (b->log) {
+        log_add(b->log, "batch: %s: ", b->where);
+        log_vadd(b->log, fmt, ap);
+        log_add(b->log, "\n");
+    } else {
+        fflush(stdout);        /* keep the log in order when both go to one file */
+        fprintf(stderr, "batch: %s: ", b->where);
+        vfprintf(stderr, fmt, ap);
+        fputc('\n', stderr);
+    }
+    va_end(ap);
+    return -1;
+}
+
+static int sheet_tiles(const Batch *b) { return b->cols * b->rows; }
+
+static ChrFormat format_for(const Batch *b, const char *path) {
+    return b->format >= 0 ? (ChrFormat)b->format : chrfmt_from_path(path);
+}
+
+/* After the sheet or the scenes change wholesale. */
+static void reindex(Batch *b) {
+    tilehash_rebuild(&b->tilehash, &b->chr);
+    usage_rebuild(&b->usage, &b->compose);
+}
+
+/* ── Commands ────────────────────────────────────────────────── */
+
+/* Load a CHR file; the sheet keeps its width and grows or shrinks to
+   the tile count, as in the editor.                               */
+static int load_chr(Batch *b, const char *path) {
+    int tiles = chrfmt_load(&b->chr, path, format_for(b, path));
+    if (tiles <= 0) {
+        const char *why = chrfmt_refuses(path);
+        return fail(b, "can't read CHR %s%s%s", path, why ? ": " : "", why ? why : "");
+    }
+    b->rows = (tiles + b->cols - 1) / b->cols;
+    tilehash_rebuild(&b->tilehash, &b->chr);
+    return tiles;
+}
+
+static int cmd_open(Batch *b, int argc, char **argv) {
+    (void)argc;
+    int tiles = load_chr(b, argv[1]);
+    if (tiles < 0) return -1;
+    char pp[260], sp[260];
+    chr_sidecar_path(pp, sizeof(pp), argv[1], ".pal");
+    chr_sidecar_path(sp, sizeof(sp), argv[1], ".scn");
+    bool pal = palette_load(&b->pal, pp) == 0;
+    if (!pal) palette_init(&b->pal);
+    bool scn = compose_load(&b->compose, sp) == 0;
+    if (!scn) { compose_free(&b->compose); compose_init(&b->compose); }
+    usage_rebuild(&b->usage, &b->compose);
+    say(b, "opened: %s (%d tiles, %dx%d)%s%s\n", argv[1], tiles, b->cols, b->rows,
+           pal ? " +pal" : "", scn ? " +scn" : "");
+    return 0;
+}
+
+static int cmd_load_chr(Batch *b, int argc, char **argv) {
+    (void)argc;
+    int tiles = load_chr(b, argv[1]);
+    if (tiles < 0) return -1;
+    say(b, "loaded: %s (%d tiles)\n", argv[1], tiles);
+    return 0;
+}
+
+static int cmd_load_pal(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (palette_load(&b->pal, argv[1]) != 0) return fail(b, "can't read palette %s", argv[1]);
+    say(b, "palette loaded: %s\n", argv[1]);
+    return 0;
+}
+
+static int cmd_load_scn(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (compose_load(&b->compose, argv[1]) != 0) return fail(b, "can't read scenes %s", argv[1]);
+    usage_rebuild(&b->usage, &b->compose);
+    say(b, "scenes loaded: %s (%d scene(s))\n", argv[1], b->compose.scene_count);
+    return 0;
+}
+
+static int save_chr(Batch *b, const char *path) {
+    ChrFormat f = format_for(b, path);
+    if (chrfmt_refuses(path)) return fail(b, "can't write %s: %s", path, chrfmt_refuses(path));
+    if (chrfmt_save(&b->chr, sheet_tiles(b), path, f) != 0)
+        return fail(b, "can't write %s CHR %s", chrfmt_name(f), path);
+    say(b, "saved: %s (%d tiles, %s)\n", path, sheet_tiles(b), chrfmt_name(f));
+    return 0;
+}
+
+static int cmd_save(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (save_chr(b, argv[1]) != 0) return -1;
+    char pp[260], sp[260];
+    chr_sidecar_path(pp, sizeof(pp), argv[1], ".pal");
+    chr_sidecar_path(sp, sizeof(sp), argv[1], ".scn");
+    if (palette_save(&b->pal, pp) != 0) return fail(b, "can't write palette %s", pp);
+    if (compose_save(&b->compose, sp) != 0) return fail(b, "can't write scenes %s", sp);
+    say(b, "saved: %s, %s\n", pp, sp);
+    return 0;
+}
+
+static int cmd_save_chr(Batch *b, int argc, char **argv) {
+    (void)argc;
+    return save_chr(b, argv[1]);
+}
+
+static int cmd_save_pal(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (palette_save(&b->pal, argv[1]) != 0) return fail(b, "can't write palette %s", argv[1]);
+    say(b, "palette saved: %s\n", argv[1]);
+    return 0;
+}
+
+static int cmd_save_scn(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (compose_save(&b->compose, argv[1]) != 0) return fail(b, "can't write scenes %s", argv[1]);
+    say(b, "scenes saved: %s (%d scene(s))\n", argv[1], b->compose.scene_count);
+    return 0;
+}
+
+static int cmd_export_nam(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (export_scenes_nam(&b->compose, argv[1]) != 0) return fail(b, "can't write %s", argv[1]);
+    say(b, "exported: %s (%d nametable(s))\n", argv[1], b->compose.scene_count);
+    return 0;
+}
+
+static int cmd_export_oam(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (export_scenes_oam(&b->compose, argv[1]) != 0) return fail(b, "can't write %s", argv[1]);
+    say(b, "exported: %s (%d OAM page(s))\n", argv[1], b->compose.scene_count);
+    return 0;
+}
+
+static int cmd_export_packed(Batch *b, int argc, char **argv) {
+    (void)argc;
+    int c = !strcmp(argv[1], "rle") ? CODEC_RLE : !strcmp(argv[1], "lz") ? CODEC_LZSS : -1;
+    if (c < 0) return fail(b, "unknown codec %s (rle, lz)", argv[1]);
+    int rc = export_scenes_packed(&b->compose, (Codec)c, argv[2]);
+    if (rc == EXPORT_OFFSET_OVERFLOW)
+        return fail(b, "%s scenes exceed the 16-bit offsets (64 KB) of %s",
+                    codec_name((Codec)c), argv[2]);
+    if (rc != 0)
+        return fail(b, "can't write %s scenes to %s", codec_name((Codec)c), argv[2]);
+    say(b, "exported: %s (%d %s nametable(s))\n", argv[2], b->compose.scene_count,
+           codec_name((Codec)c));
+    return 0;
+}
+
+static int parse_int(const char *s, int lo, int hi, int *out) {
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || v < lo || v > hi) return -1;
+    *out = (int)v;
+    return 0;
+}
+
+/* Trailing render options: gray and s16 (sheet only), xN, grid. */
+typedef struct {
+    bool gray, s16, grid;
+    int  zoom;
+} RenderOpts;
+
+static int render_opts(Batch *b, int argc, char **argv, int first, bool sheet,
+                       RenderOpts *o) {
+    *o = (RenderOpts){ false, false, false, 1 };
+    for (int k = first; k < argc; k++) {
+        const char *w = argv[k];
+        if      (sheet && !strcmp(w, "gray")) o->gray = true;
+        else if (sheet && !strcmp(w, "s16"))  o->s16  = true;
+        else if (!strcmp(w, "grid"))          o->grid = true;
+        else if (w[0] != 'x' || parse_int(w + 1, 1, 16, &o->zoom) != 0)
+            return fail(b, "%s: unknown option %s (%sxN, grid)", argv[0], w,
+                        sheet ? "gray, s16, " : "");
+    }
+    return 0;
+}
+
+/* Scale, draw the grid (every step source pixels) and save. */
+static int render_save(Batch *b, uint32_t *px, int w, int h, const RenderOpts *o,
+                       int step, uint32_t grid, const char *path) {
+    int zw = w * o->zoom, zh = h * o->zoom;
+    uint32_t *big = px;
+    if (o->zoom > 1) {
+        if (!(big = malloc((size_t)zw * zh * sizeof(*big)))) return fail(b, "out of memory");
+        swr_upscale(px, w, h, w, o->zoom, big, zw);
+    }
+    if (o->grid) swr_grid(big, zw, zw, zh, step * o->zoom, grid);
+    Image img;
+    int rc = swr_to_image(big, zw, zh, zw, &img);
+    if (big != px) free(big);
+    if (rc != 0) return fail(b, "out of memory");
+    rc = image_save(&img, path);
+    image_free(&img);
+    if (rc != 0) return fail(b, "can't write %s", path);
+    return 0;
+}
+
+static int cmd_render_sheet(Batch *b, int argc, char **argv) {
+    RenderOpts o;
+    if (render_opts(b, argc, argv, 2, true, &o) != 0) return -1;
+    int w = b->cols * TILE_W, h = b->rows * TILE_H;
+    uint32_t *px = calloc((size_t)w * h, sizeof(*px));
+    if (!px) return fail(b, "out of memory");
+    swr_sheet(&b->chr, &b->pal, b->cols, b->rows, o.gray, o.s16, px, w);
+    int rc = render_save(b, px, w, h, &o, TILE_W, SWR_GRID_TILE, argv[1]);
+    free(px);
+    if (rc != 0) return -1;
+    say(b, "rendered: %s (sheet, %dx%d px)\n", argv[1], w * o.zoom, h * o.zoom);
+    return 0;
+}
+
+static int cmd_render_scene(Batch *b, int argc, char **argv) {
+    RenderOpts o;
+    int i;
+    if (parse_int(argv[1], 0, b->compose.scene_count - 1, &i) != 0)
+        return fail(b, "no scene %s (have %d)", argv[1], b->compose.scene_count);
+    if (render_opts(b, argc, argv, 3, false, &o) != 0) return -1;
+    enum { W = COMPOSE_NT_W * TILE_W, H = COMPOSE_NT_H * TILE_H };
+    ComposeScene *tmp = malloc(sizeof(*tmp));
+    uint32_t     *px  = malloc((size_t)W * H * sizeof(*px));
+    const ComposeScene *sc = tmp && px ? compose_peek(&b->compose, i, tmp) : NULL;
+    if (sc) swr_scene(&b->chr, &b->pal, sc, 0, 0, W, H, px, W);
+    free(tmp);
+    if (!sc) { free(px); return fail(b, "can't read scene %d", i); }
+    /* The grid marks the 16×16 attribute blocks, as in compose mode. */
+    int rc = render_save(b, px, W, H, &o, 16, SWR_GRID_ATTR, argv[2]);
+    free(px);
+    if (rc != 0) return -1;
+    say(b, "rendered: %s (scene %d)\n", argv[2], i);
+    return 0;
+}
+
+static int cmd_compact(Batch *b, int argc, char **argv) {
+    (void)argc; (void)argv;
+    uint16_t map[CHR_MAX_TILES];
+    int span = compact_plan(&b->usage, map);
+    if (!compact_is_identity(map)) {
+        if (compact_remap_scenes(&b->compose, &b->usage, map) < 0) return fail(b, "out of memory");
+        compact_apply_chr(&b->chr, &b->pal, map);
+        reindex(b);
+    }
+    say(b, "compacted: used tiles take %d slot(s); fits in %d row(s)\n",
+           span, (span + b->cols - 1) / b->cols);
+    return 0;
+}
+
+/* Point every scene reference at the lowest-numbered copy of its
+   tile.  Duplicates stay in the sheet, unreferenced, until compact.
+   Cells (and 16×16 sprites) that would need a flip are left alone,
+   as with the editor's find-and-replace.                          */
+static int cmd_dedupe(Batch *b, int argc, char **argv) {
+    bool flips = argc > 1 && !strcmp(argv[1], "flips");
+    if (argc > 1 && !flips) return fail(b, "dedupe: expected \"flips\", got %s", argv[1]);
+
+    int refs, skipped;
+    int dups = replace_dedupe(&b->compose, &b->usage, &b->tilehash, sheet_tiles(b),
+                              flips, &refs, &skipped);
+    if (dups < 0) return fail(b, "out of memory");
+    say(b, "deduped: %d duplicate tile(s)%s, %d reference(s) rewritten, %d skipped\n",
+           dups, flips ? " (+flips)" : "", refs, skipped);
+    return 0;
+}
+
+static int cmd_import(Batch *b, int argc, char **argv) {
+    int budget = IMPORT_BUDGET_LONG_MS;
+    if (argc > 2 && parse_int(argv[2], 0, 600000, &budget) != 0)
+        return fail(b, "import: bad budget %s (ms)", argv[2]);
+    Image img;
+    if (image_load(&img, argv[1]) != 0) return fail(b, "can't read image %s", argv[1]);
+    ImportResult *r = malloc(sizeof(*r));
+    int first = import_first_free(&b->chr, &b->usage);
+    int rc = r ? import_build(&img, &b->chr, first, budget, r) : -1;
+    image_free(&img);
+    if (rc != 0) { free(r); return fail(b, "can't import %s: not enough free tiles", argv[1]); }
+
+    int i = b->compose.active_scene;
+    import_apply(r, &b->chr, &b->pal, compose_scene(&b->compose, i));
+    usage_sync_scene(&b->usage, i, compose_active(&b->compose));
+    tilehash_rebuild(&b->tilehash, &b->chr);
+    int end = r->first_new + r->new_count;
+    if (end > sheet_tiles(b)) b->rows = (end + b->cols - 1) / b->cols;
+    say(b, "imported: %s into scene %d (%d new tile(s) at %d, %d reused, fit %.1f%%)\n",
+           argv[1], i, r->new_count, r->first_new, r->reused, r->quality);
+    free(r);
+    return 0;
+}
+
+/* Select scene N, appending blank scenes up to it if needed. */
+static int cmd_scene(Batch *b, int argc, char **argv) {
+    (void)argc;
+    int i;
+    if (parse_int(argv[1], 0, COMPOSE_MAX_SCENES - 1, &i) != 0)
+        return fail(b, "bad scene number %s", argv[1]);
+    while (b->compose.scene_count <= i)
+        if (compose_add_scene(&b->compose) < 0) return fail(b, "too many scenes");
+    compose_set_active(&b->compose, i);
+    say(b, "scene: %d of %d\n", i, b->compose.scene_count);
+    return 0;
+}
+
+static int cmd_size(Batch *b, int argc, char **argv) {
+    (void)argc;
+    int c = 0, r = 0;
+    if (sscanf(argv[1], "%dx%d", &c, &r) != 2 || c < 1 || c > 128 || r < 1 || r > 64 ||
+        c * r > CHR_MAX_TILES)
+        return fail(b, "bad size %s (COLSxROWS, at most %d tiles)", argv[1], CHR_MAX_TILES);
+    b->cols = c;
+    b->rows = r;
+    say(b, "size: %dx%d (%d tiles)\n", c, r, c * r);
+    return 0;
+}
+
+static int cmd_format(Batch *b, int argc, char **argv) {
+    (void)argc;
+    int f = strcmp(argv[1], "auto") ? chrfmt_parse(argv[1]) : -1;
+    if (f < 0 && strcmp(argv[1], "auto"))
+        return fail(b, "unknown format %s (raw, rle, pred, auto)", argv[1]);
+    b->format = f;
+    say(b, "format: %s\n", f < 0 ? "by extension" : chrfmt_name((ChrFormat)f));
+    return 0;
+}
+
+static int cmd_info(Batch *b, int argc, char **argv) {
+    (void)argc; (void)argv;
+    int16_t rep[CHR_MAX_TILES];
+    int n     = sheet_tiles(b);
+    int dups  = tilehash_clusters(&b->tilehash, n, false, rep, NULL);
+    int fdups = tilehash_clusters(&b->tilehash, n, true,  rep, NULL);
+    int used  = 0;
+    for (int t = 0; t < CHR_MAX_TILES; t++) used += b->usage.count[t] > 0;
+    say(b, "sheet %dx%d (%d tiles), %d duplicate(s), %d with flips; "
+           "%d scene(s) using %d tile(s)\n",
+           b->cols, b->rows, n, dups, fdups, b->compose.scene_count, used);
+    return 0;
+}
+
+typedef struct {
+    const char *name;
+    int         min, max;       /* words after the name */
+    int       (*run)(Batch *b, int argc, char **argv);
+    int         out;            /* word holding the output file, 0 = none */
+    const char *usage;
+} BatchCmd;
+
+static int cmd_each(Batch *b, int argc, char **argv);
+static int cmd_jobs(Batch *b, int argc, char **argv);
+
+static const BatchCmd CMDS[] = {
+    { "open",          1, 1, cmd_open,          0, "open FILE.chr     (+ .pal/.scn sidecars)" },
+    { "load-chr",      1, 1, cmd_load_chr,      0, "load-chr FILE" },
+    { "load-pal",      1, 1, cmd_load_pal,      0, "load-pal FILE" },
+    { "load-scn",      1, 1, cmd_load_scn,      0, "load-scn FILE" },
+    { "save",          1, 1, cmd_save,          1, "save FILE.chr     (+ .pal/.scn sidecars)" },
+    { "save-chr",      1, 1, cmd_save_chr,      1, "save-chr FILE" },
+    { "save-pal",      1, 1, cmd_save_pal,      1, "save-pal FILE" },
+    { "save-scn",      1, 1, cmd_save_scn,      1, "save-scn FILE" },
+    { "export-nam",    1, 1, cmd_export_nam,    1, "export-nam FILE" },
+    { "export-oam",    1, 1, cmd_export_oam,    1, "export-oam FILE" },
+    { "export-packed", 2, 2, cmd_export_packed, 2, "export-packed rle|lz FILE" },
+    { "render-sheet",  1, 5, cmd_render_sheet,  1, "render-sheet FILE.png|.ppm [gray] [s16] [xN] [grid]" },
+    { "render-scene",  2, 4, cmd_render_scene,  2, "render-scene N FILE.png|.ppm [xN] [grid]" },
+    { "compact",       0, 0, cmd_compact,       0, "compact" },
+    { "dedupe",        0, 1, cmd_dedupe,        0, "dedupe [flips]" },
+    { "import",        1, 2, cmd_import,        0, "import IMAGE [BUDGET_MS]" },
+    { "scene",         1, 1, cmd_scene,         0, "scene N" },
+    { "size",          1, 1, cmd_size,          0, "size COLSxROWS" },
+    { "format",        1, 1, cmd_format,        0, "format raw|rle|pred|auto" },
+    { "info",          0, 0, cmd_info,          0, "info" },
+    { "each",          2, 3, cmd_each,          0, "each DIR|MANIFEST SCRIPT [CACHE]" },
+    { "jobs",          1, 1, cmd_jobs,          0, "jobs N" },
+};
+#define NCMDS ((int)(sizeof(CMDS) / sizeof(CMDS[0])))
+
+/* ── Driver ──────────────────────────────────────────────────── */
+
+/* Split line in place into words; "double quotes" group.  Returns
+   the word count, or -1 if there are too many.                    */
+static int split(char *line, char *word[BATCH_MAX_WORDS]) {
+    int n = 0;
+    char *p = line;
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0') return n;
+        if (n == BATCH_MAX_WORDS) return -1;
+        if (*p == '"') {
+            word[n++] = ++p;
+            while (*p && *p != '"') p++;
+        } else {
+            word[n++] = p;
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+        if (*p) *p++ = '\0';
+    }
+}
+
+static const BatchCmd *find_cmd(const char *name) {
+    for (int c = 0; c < NCMDS; c++)
+        if (!strcmp(name, CMDS[c].name)) return &CMDS[c];
+    return NULL;
+}
+
+static int run_line(Batch *b, char *line) {
+    char *word[BATCH_MAX_WORDS];
+    int n = split(line, word);
+    if (n < 0) return fail(b, "too many words");
+    if (n == 0 || word[0][0] == '#') return 0;
+    const BatchCmd *c = find_cmd(word[0]);
+    if (!c) {
+        fail(b, "unknown command %s; commands:", word[0]);
+        for (int k = 0; k < NCMDS; k++)
+            if (b->log) log_add(b->log, "  %s\n", CMDS[k].usage);
+            else        fprintf(stderr, "  %s\n", CMDS[k].usage);
+        return -1;
+    }
+    if (n - 1 < c->min || n - 1 > c->max) return fail(b, "usage: %s", c->usage);
+    TraceZone z = trace_begin(c->name);
+    z.detail = b->where;
+    int rc = c->run(b, n, word);
+    trace_end(z);
+    return rc < 0 ? -1 : 0;
+}
+
+static int run_script(Batch *b, const char *path) {
+    FILE *f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!f) return fail(b, "can't open script %s", path);
+    char line[BATCH_LINE], where[300];
+    const char *outer = b->where;
+    int rc = 0;
+    for (int ln = 1; rc == 0 && fgets(line, sizeof(line), f); ln++) {
+        snprintf(where, sizeof(where), "%s:%d", path, ln);
+        b->where = where;
+        rc = run_line(b, line);
+    }
+    b->where = outer;
+    if (f != stdin) fclose(f);
+    return rc;
+}
+
+static Batch *batch_new(int cols, int format) {
+    Batch *b = malloc(sizeof(*b));
+    if (!b) return NULL;
+    chr_init(&b->chr);
+    palette_init(&b->pal);
+    compose_init(&b->compose);
+    usage_init(&b->usage);
+    b->cols   = cols;
+    b->rows   = CHR_DEFAULT_ROWS;
+    b->format = format;
+    b->jobs   = 0;
+    b->where  = "";
+    b->log    = NULL;
+    b->nested = false;
+    reindex(b);
+    return b;
+}
+
+static void batch_delete(Batch *b) {
+    usage_free(&b->usage);
+    compose_free(&b->compose);
+    free(b);
+}
+
+/* ── Directory / manifest runs ───────────────────────────────────
+   `each SOURCE SCRIPT [CACHE]` runs SCRIPT once per CHR file of
+   SOURCE, in a fresh document that starts with `open FILE`.  In the
+   script {path}, {dir} and {name} stand for the file, its directory
+   and its name without extension.  Files go to a pool of `jobs`
+   workers, each holding one document at a time, so memory stays at
+   jobs × one sheet however long the list is.
+
+   With CACHE, a file is skipped when the FNV-1a hash of its CHR,
+   .pal and .scn bytes, the script text, the sheet width and the
+   format matches the entry its last successful run left there, and
+   every file the script writes still exists.                      */
+
+#define EACH_MAX_FILES 4096
+
+typedef struct {
+    char     path[BATCH_PATH];
+    uint64_t key;
+} CacheEntry;
+
+typedef struct {
+    char     path[BATCH_PATH];
+    uint64_t key;
+    bool     cached, ok;
+    double   ms;
+} EachJob;
+
+typedef struct {
+    const Batch      *parent;
+    char            **line;          /* script lines            */
+    int               nlines;
+    uint64_t          script_key;
+    const CacheEntry *cache;
+    int               ncache;
+    EachJob          *job;
+    int               njobs;
+    int               next;          /* under lock              */
+    pthread_mutex_t   lock;          /* also serialises output  */
+} EachRun;
+
+#define FNV64_INIT 14695981039346656037ull
+
+static uint64_t fnv64(uint64_t h, const void *p, size_t n) {
+    const uint8_t *s = p;
+    while (n--) h = (h ^ *s++) * 1099511628211ull;
+    return h;
+}
+
+/* Hash a file's bytes; a missing file hashes differently from an
+   empty one.                                                      */
+static uint64_t fnv64_file(uint64_t h, const char *path) {
+    FILE *f = fopen(path, "rb");
+    uint8_t tag = f != NULL;
+    h = fnv64(h, &tag, 1);
+    if (!f) return h;
+    uint8_t buf[16384];
+    size_t  n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) h = fnv64(h, buf, n);
+    fclose(f);
+    return h;
+}
+
+/* Monotonic: a wall-clock step must not stretch or skip a budget. */
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Substitute {path}, {dir} and {name} into out. */
+static void expand(const char *in, const char *path, char *out, size_t cap) {
+    const char *sl   = strrchr(path, '/');
+    const char *base = sl ? sl + 1 : path;
+    const char *dot  = strrchr(base, '.');
+    int dlen = sl ? (int)(sl - path) : 1;
+    int nlen = dot ? (int)(dot - base) : (int)strlen(base);
+    size_t o = 0;
+    while (*in && o + 1 < cap) {
+        int w = -1;
+        if      (!strncmp(in, "{path}", 6)) w = snprintf(out + o, cap - o, "%s", path),                 in += 6;
+        else if (!strncmp(in, "{dir}",  5)) w = snprintf(out + o, cap - o, "%.*s", dlen, sl ? path : "."), in += 5;
+        else if (!strncmp(in, "{name}", 6)) w = snprintf(out + o, cap - o, "%.*s", nlen, base),         in += 6;
+        else { out[o++] = *in++; continue; }
+        o += (size_t)w < cap - o ? (size_t)w : cap - o - 1;
+    }
+    out[o] = '\0';
+}
+
+/* The script's outputs for one file all exist. */
+static bool outputs_exist(const EachRun *r, const char *path) {
+    for (int k = 0; k < r->nlines; k++) {
+        char  line[BATCH_LINE], *word[BATCH_MAX_WORDS];
+        expand(r->line[k], path, line, sizeof(line));
+        int n = split(line, word);
+        const BatchCmd *c = n > 0 ? find_cmd(word[0]) : NULL;
+        if (!c || c->out == 0 || c->out >= n) continue;
+        FILE *f = fopen(word[c->out], "rb");
+        if (!f) return false;
+        fclose(f);
+    }
+    return true;
+}
+
+static uint64_t job_key(const EachRun *r, const char *path) {
+    char side[BATCH_PATH];
+    uint64_t h = fnv64(FNV64_INIT, &r->script_key, sizeof(r->script_key));
+    h = fnv64_file(h, path);
+    chr_sidecar_path(side, sizeof(side), path, ".pal");
+    h = fnv64_file(h, side);
+    chr_sidecar_path(side, sizeof(side), path, ".scn");
+    return fnv64_file(h, side);
+}
+
+static void run_job(EachRun *r, Batch *b, EachJob *j) {
+    TraceZone z = trace_begin("each file");
+    z.detail = j->path;
+    double t0 = now_ms();
+    j->key = job_key(r, j->path);
+    for (int k = 0; k < r->ncache && !j->cached; k++)
+        j->cached = r->cache[k].key == j->key && !strcmp(r->cache[k].path, j->path) &&
+                    outputs_exist(r, j->path);
+
+    BatchLog log = { NULL, 0, 0 };
+    if (!j->cached) {
+        /* A fresh document, as if chrmaker had just opened the file. */
+        chr_init(&b->chr);
+        b->cols   = r->parent->cols;
+        b->format = r->parent->format;
+        b->log    = &log;
+
+        char line[BATCH_LINE], where[BATCH_PATH + 16];
+        char *open[2] = { "open", j->path };
+        snprintf(where, sizeof(where), "%s", j->path);
+        b->where = where;
+        j->ok = cmd_open(b, 2, open) == 0;
+        for (int k = 0; k < r->nlines && j->ok; k++) {
+            snprintf(where, sizeof(where), "%s:%d", j->path, k + 1);
+            expand(r->line[k], j->path, line, sizeof(line));
+            j->ok = run_line(b, line) == 0;
+        }
+        b->log = NULL;
+    }
+    j->ms = now_ms() - t0;
+    trace_end(z);
+
+    pthread_mutex_lock(&r->lock);
+    printf("%8.1f ms  %s%s\n", j->ms, j->path,
+           j->cached ? ": cached" : j->ok ? "" : ": FAILED");
+    for (char *p = log.text, *e; p && p < log.text + log.len; p = e + 1) {
+        e = strchr(p, '\n');
+        if (!e) e = log.text + log.len;
+        printf("            %.*s\n", (int)(e - p), p);
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&r->lock);
+    free(log.text);
+}
+
+static void *each_worker(void *ctx) {
+    EachRun *r = ctx;
+    Batch *b = batch_new(r->parent->cols, r->parent->format);
+    if (!b) return NULL;     /* the other workers take its share */
+    b->nested = true;
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        int i = r->next++;
+        pthread_mutex_unlock(&r->lock);
+        if (i >= r->njobs) break;
+        run_job(r, b, &r->job[i]);
+    }
+    batch_delete(b);
+    return NULL;
+}
+
+static void *each_thread(void *ctx) {
+    trace_thread_name("each worker");
+    return each_worker(ctx);
+}
+
+static bool is_chr_name(const char *name) {
+    const char *dot = strrchr(name, '.');
+    if (!dot || dot == name) return false;
+    return !strcmp(dot, ".chr") || chrfmt_from_path(name) != CHR_FMT_RAW;
+}
+
+static int cmp_job(const void *a, const void *b) {
+    return strcmp(((const EachJob *)a)->path, ((const EachJob *)b)->path);
+}
+
+static int add_job(EachRun *r, const char *dir, const char *name) {
+    if (r->njobs == EACH_MAX_FILES) return -1;
+    EachJob *j = &r->job[r->njobs++];
+    memset(j, 0, sizeof(*j));
+    if (dir && name[0] != '/') snprintf(j->path, sizeof(j->path), "%s/%s", dir, name);
+    else                       snprintf(j->path, sizeof(j->path), "%s", name);
+    return 0;
+}
+
+/* Every CHR file directly inside a directory (sorted), or every path
+   listed in a manifest, relative to the manifest's directory.     */
+static int list_jobs(Batch *b, EachRun *r, const char *src) {
+    DIR *d = opendir(src);
+    if (d) {
+        struct dirent *de;
+        int rc = 0;
+        while (rc == 0 && (de = readdir(d)) != NULL)
+            if (de->d_name[0] != '.' && is_chr_name(de->d_name))
+                rc = add_job(r, src, de->d_name);
+        closedir(d);
+        if (rc != 0) return fail(b, "%s: more than %d files", src, EACH_MAX_FILES);
+        qsort(r->job, (size_t)r->njobs, sizeof(*r->job), cmp_job);
+        return 0;
+    }
+
+    FILE *f = fopen(src, "r");
+    if (!f) return fail(b, "can't open %s", src);
+    char dir[BATCH_PATH], line[BATCH_LINE];
+    const char *sl = strrchr(src, '/');
+    snprintf(dir, sizeof(dir), "%.*s", sl ? (int)(sl - src) : 1, sl ? src : ".");
+    int rc = 0;
+    while (rc == 0 && fgets(line, sizeof(line), f)) {
+        char *word[BATCH_MAX_WORDS];
+        if (split(line, word) > 0 && word[0][0] != '#')
+            rc = add_job(r, sl ? dir : NULL, word[0]);
+    }
+    fclose(f);
+    if (rc != 0) return fail(b, "%s: more than %d files", src, EACH_MAX_FILES);
+    return 0;
+}
+
+static int load_script(Batch *b, EachRun *r, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return fail(b, "can't open script %s", path);
+    char line[BATCH_LINE];
+    int  cap = 0;
+    r->script_key = fnv64(FNV64_INIT, &b->cols, sizeof(b->cols));
+    r->script_key = fnv64(r->script_key, &b->format, sizeof(b->format));
+    while (fgets(line, sizeof(line), f)) {
+        r->script_key = fnv64(r->script_key, line, strlen(line));
+        if (r->nlines == cap) {
+            cap = cap ? cap * 2 : 16;
+            char **l = realloc(r->line, (size_t)cap * sizeof(*l));
+            if (!l) { fclose(f); return fail(b, "out of memory"); }
+            r->line = l;
+        }
+        size_t n = strlen(line) + 1;
+        if (!(r->line[r->nlines] = malloc(n))) { fclose(f); return fail(b, "out of memory"); }
+        memcpy(r->line[r->nlines++], line, n);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Read "KEY PATH" lines; a missing cache is an empty one. */
+static CacheEntry *load_cache(const char *path, int *n) {
+    *n = 0;
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    CacheEntry *c = malloc(EACH_MAX_FILES * sizeof(*c));
+    char line[BATCH_PATH + 32];
+    while (c && *n < EACH_MAX_FILES && fgets(line, sizeof(line), f)) {
+        unsigned long long key;
+        int at;
+        if (sscanf(line, "%16llx %n", &key, &at) != 1) continue;
+        line[strcspn(line, "\n")] = '\0';
+        c[*n].key = key;
+        snprintf(c[*n].path, sizeof(c[*n].path), "%s", line + at);
+        (*n)++;
+    }
+    fclose(f);
+    return c;
+}
+
+/* Rewrite the cache: this run's good files, plus older entries for
+   files it didn't list.  Temp file + rename, so a crash leaves the
+   old cache intact.                                               */
+static int save_cache(const EachRun *r, const char *path) {
+    char tmp[BATCH_PATH + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    for (int k = 0; k < r->ncache; k++) {
+        bool listed = false;
+        for (int i = 0; i < r->njobs && !listed; i++)
+            listed = !strcmp(r->job[i].path, r->cache[k].path);
+        if (!listed)
+            fprintf(f, "%016llx %s\n", (unsigned long long)r->cache[k].key, r->cache[k].path);
+    }
+    for (int i = 0; i < r->njobs; i++)
+        if (r->job[i].cached || r->job[i].ok)
+            fprintf(f, "%016llx %s\n", (unsigned long long)r->job[i].key, r->job[i].path);
+    if (fclose(f) != 0 || rename(tmp, path) != 0) { remove(tmp); return -1; }
+    return 0;
+}
+
+static int cmd_each(Batch *b, int argc, char **argv) {
+    if (b->nested) return fail(b, "each can't run inside each");
+    EachRun *r = calloc(1, sizeof(*r));
+    if (!r || !(r->job = malloc(EACH_MAX_FILES * sizeof(*r->job)))) {
+        free(r);
+        return fail(b, "out of memory");
+    }
+    r->parent = b;
+    const char *cache = argc > 3 ? argv[3] : NULL;
+    int rc = list_jobs(b, r, argv[1]);
+    if (rc == 0) rc = load_script(b, r, argv[2]);
+    if (rc == 0 && cache) r->cache = load_cache(cache, &r->ncache);
+
+    if (rc == 0) {
+        double t0 = now_ms();
+        int want = b->jobs > 0 ? b->jobs : par_threads();
+        if (want > r->njobs) want = r->njobs;
+        fflush(stdout);
+        pthread_mutex_init(&r->lock, NULL);
+
+        /* `jobs N` means N threads even beyond the CPU count (workers
+           often wait on disk), so they are started here rather than
+           through par_for.  The caller is one of them; a thread that
+           fails to start just leaves its share to the others.     */
+        pthread_t tid[PAR_MAX_THREADS];
+        int workers = 0;
+        for (int i = 1; i < want; i++)
+            if (pthread_create(&tid[workers], NULL, each_thread, r) == 0) workers++;
+        if (want > 0) each_worker(r);
+        for (int i = 0; i < workers; i++) pthread_join(tid[i], NULL);
+        workers += want > 0;
+        pthread_mutex_destroy(&r->lock);
+
+        int built = 0, cached = 0, failed = 0;
+        double work = 0;
+        for (int i = 0; i < r->njobs; i++) {
+            cached += r->job[i].cached;
+            built  += !r->job[i].cached && r->job[i].ok;
+            work   += r->job[i].ms;
+        }
+        failed = r->njobs - built - cached;
+        if (cache && save_cache(r, cache) != 0) rc = fail(b, "can't write cache %s", cache);
+        say(b, "each: %d file(s): %d built, %d cached, %d failed; "
+               "%.1f ms on %d worker(s), %.1f ms of work\n",
+            r->njobs, built, cached, failed, now_ms() - t0, workers, work);
+        if (failed) rc = fail(b, "%d file(s) failed", failed);
+    }
+
+    for (int k = 0; k < r->nlines; k++) free(r->line[k]);
+    free(r->line);
+    free((void *)r->cache);
+    free(r->job);
+    free(r);
+    return rc;
+}
+
+static int cmd_jobs(Batch *b, int argc, char **argv) {
+    (void)argc;
+    if (parse_int(argv[1], 0, PAR_MAX_THREADS, &b->jobs) != 0)
+        return fail(b, "jobs: expected 0-%d, got %s", PAR_MAX_THREADS, argv[1]);
+    say(b, "jobs: %d\n", b->jobs ? b->jobs : par_threads());
+    return 0;
+}
+
+int batch_main(int argc, char **argv) {
+    Batch *b = batch_new(CHR_DEFAULT_COLS, -1);
+    if (!b) { fprintf(stderr, "batch: out of memory\n"); return 1; }
+
+    int rc = 0;
+    for (int i = 1; i < argc && rc == 0; i++) {
+        if (!strcmp(argv[i], "--batch")) continue;
+        if (!strncmp(argv[i], "--format=", 9)) {
+            b->format = chrfmt_parse(argv[i] + 9);
+            continue;   /* main() has already rejected bad names */
+        }
+        if (!strncmp(argv[i], "--trace=", 8)) continue;   /* opened by main() */
+        char where[32], line[BATCH_LINE];
+        snprintf(where, sizeof(where), "argv %d", i);
+        b->where = where;
+        if (argv[i][0] == '@') {
+            rc = run_script(b, argv[i] + 1);
+        } else {
+            snprintf(line, sizeof(line), "%s", argv[i]);
+            rc = run_line(b, line);
+        }
+    }
+
+    batch_delete(b);
+    return rc == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+/* ── Headless batch mode ─────────────────────────────────────────
+   `chrmaker --batch CMD...` runs editor operations without opening
+   a window (SDL video is never initialised).  Every argument after
+   the flags is one command line — quote it so the shell keeps the
+   words together — and "@FILE" runs a script of them, one per line
+   ("@-" reads stdin; blank lines and lines starting with # are
+   skipped).  Words may be double-quoted to hold spaces.
+
+   The commands share one document, as in the editor: a sheet of
+   COLS×ROWS tiles, its palettes and its scenes.  Each success
+   prints one line; the first failure prints "batch: ..." to stderr
+   and stops the run with exit status 1.  `each` runs a script over a
+   directory or manifest of CHR files on a worker pool, skipping files
+   whose inputs hash the same as on their last run.  The command list
+   is in batch.c and the README.                                   */
+
+/* argv as given to main(); "--batch", --format= and --trace= are
+   skipped. */
+int batch_main(int argc, char **argv);
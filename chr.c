@@ -2,6 +2,47 @@
 #include <string.h>
 #include <stdio.h>
 
+/* ── NES master palette (NTSC 2C02) ──────────────────────────────
+   64 hardware-defined colours. Indices $0E/$0F/$1E/$1F/$2E/$2F/
+   $3E/$3F are black on real hardware; kept as black here.         */
+const uint8_t NES_MASTER_RGB[64][3] = {
+    /* $00 */ {  84,  84,  84 }, /* $01 */ {   0,  30, 116 },
+    /* $02 */ {   8,  16, 144 }, /* $03 */ {  48,   0, 136 },
+    /* $04 */ {  68,   0, 100 }, /* $05 */ {  92,   0,  48 },
+    /* $06 */ {  84,   4,   0 }, /* $07 */ {  60,  24,   0 },
+    /* $08 */ {  32,  42,   0 }, /* $09 */ {   8,  58,   0 },
+    /* $0A */ {   0,  64,   0 }, /* $0B */ {   0,  60,   0 },
+    /* $0C */ {   0,  50,  60 }, /* $0D */ {   0,   0,   0 },
+    /* $0E */ {   0,   0,   0 }, /* $0F */ {   0,   0,   0 },
+
+    /* $10 */ { 152, 150, 152 }, /* $11 */ {   8,  76, 196 },
+    /* $12 */ {  48,  50, 236 }, /* $13 */ {  92,  30, 228 },
+    /* $14 */ { 136,  20, 176 }, /* $15 */ { 160,  20, 100 },
+    /* $16 */ { 152,  34,  32 }, /* $17 */ { 120,  60,   0 },
+    /* $18 */ {  84,  90,   0 }, /* $19 */ {  40, 114,   0 },
+    /* $1A */ {   8, 124,   0 }, /* $1B */ {   0, 118,  40 },
+    /* $1C */ {   0, 102, 120 }, /* $1D */ {   0,   0,   0 },
+    /* $1E */ {   0,   0,   0 }, /* $1F */ {   0,   0,   0 },
+
+    /* $20 */ { 236, 238, 236 }, /* $21 */ {  76, 154, 236 },
+    /* $22 */ { 120, 124, 236 }, /* $23 */ { 176,  98, 236 },
+    /* $24 */ { 228,  84, 236 }, /* $25 */ { 236,  88, 180 },
+    /* $26 */ { 236, 106, 100 }, /* $27 */ { 212, 136,  32 },
+    /* $28 */ { 160, 170,   0 }, /* $29 */ { 116, 196,   0 },
+    /* $2A */ {  76, 208,  32 }, /* $2B */ {  56, 204, 108 },
+    /* $2C */ {  56, 180, 204 }, /* $2D */ {  60,  60,  60 },
+    /* $2E */ {   0,   0,   0 }, /* $2F */ {   0,   0,   0 },
+
+    /* $30 */ { 236, 238, 236 }, /* $31 */ { 168, 204, 236 },
+    /* $32 */ { 188, 188, 236 }, /* $33 */ { 212, 178, 236 },
+    /* $34 */ { 236, 174, 236 }, /* $35 */ { 236, 174, 212 },
+    /* $36 */ { 236, 180, 176 }, /* $37 */ { 228, 196, 144 },
+    /* $38 */ { 204, 210, 120 }, /* $39 */ { 180, 222, 120 },
+    /* $3A */ { 168, 226, 144 }, /* $3B */ { 152, 226, 180 },
+    /* $3C */ { 160, 214, 228 }, /* $3D */ { 160, 162, 160 },
+    /* $3E */ {   0,   0,   0 }, /* $3F */ {   0,   0,   0 },
+};
+
 void chr_init(ChrPage *c) {
     memset(c, 0, sizeof(ChrPage));
 }
@@ -59,6 +100,19 @@ int chr_load(ChrPage *c, const char *path) {
     return num_tiles;
 }
 
+void chr_sidecar_path(char *out, int outlen, const char *chr_path,
+                      const char *ext) {
+    snprintf(out, outlen, "%s", chr_path);
+    char *dot = strrchr(out, '.');
+    char *sl  = strrchr(out, '/');
+    if (dot && (!sl || dot > sl))
+        snprintf(dot, outlen - (int)(dot - out), "%s", ext);
+    else {
+        int len = (int)strlen(out);
+        snprintf(out + len, outlen - len, "%s", ext);
+    }
+}
+
 int palette_save(const PaletteState *p, const char *path) {
     FILE *f = fopen(path, "wb");
     if (!f) return -1;
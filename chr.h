@@ -45,6 +45,9 @@ typedef struct {
     uint8_t    tile_pal[CHR_MAX_TILES]; /* sub-palette index per tile   */
 } PaletteState;
 
+/* NES master palette as 8-bit RGB, indexed by $00-$3F. */
+extern const uint8_t NES_MASTER_RGB[64][3];
+
 /* ── Functions ────────────────────────────────────────────────── */
 
 void chr_init(ChrPage *c);
@@ -58,6 +61,12 @@ void chr_fill_debug(ChrPage *c);
    Loads at most CHR_MAX_TILES tiles; larger files are truncated. */
 int  chr_load(ChrPage *c, const char *path);
 
+/* Derive a sidecar path from a .chr path by swapping the extension.
+   ("output.chr", ".pal") → "output.pal"; "/p/f.chr" → "/p/f.pal";
+   files without an extension get ext appended.                 */
+void chr_sidecar_path(char *out, int outlen, const char *chr_path,
+                      const char *ext);
+
 /* Save/load editor palette state to/from a binary .pal sidecar file.
    Format v2: magic "NPL2" (4B) + count (1B) + reserved (1B) +
               count × SubPalette (4B each) + tile_pal[CHR_MAX_TILES] (1024B).
@@ -0,0 +1,5 @@
+#include "chrcore.h"
+
+int chrcore_version(void) {
+    return CHRCORE_VERSION;
+}
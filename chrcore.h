@@ -0,0 +1,41 @@
+#pragma once
+
+/* ── libchrcore ──────────────────────────────────────────────────
+   The SDL-free half of chrmaker: tiles and palettes (chr.h), scenes
+   (compose.h), codecs and compressed CHR files (compress.h,
+   chrfmt.h), NES export (export.h), analysis (tilehash.h, usage.h,
+   compact.h, replace.h, chrsize.h), image import (image.h,
+   import.h, palopt.h), the software renderer (swrender.h), the
+   thread helper (par.h), trace zones (trace.h) and batch mode
+   (batch.h).  `make libchrcore.a libchrcore.so` builds it; the
+   editor links the static archive.
+
+   Within one major version, existing functions keep their
+   signatures and struct layouts only grow at the end; a minor bump
+   adds API.  Check chrcore_version() against the header you built
+   with when loading the shared library.                           */
+
+#define CHRCORE_VERSION_MAJOR 1
+#define CHRCORE_VERSION_MINOR 3
+#define CHRCORE_VERSION (CHRCORE_VERSION_MAJOR * 100 + CHRCORE_VERSION_MINOR)
+
+#include "chr.h"
+#include "compose.h"
+#include "compress.h"
+#include "chrfmt.h"
+#include "export.h"
+#include "tilehash.h"
+#include "usage.h"
+#include "compact.h"
+#include "replace.h"
+#include "chrsize.h"
+#include "image.h"
+#include "import.h"
+#include "palopt.h"
+#include "par.h"
+#include "swrender.h"
+#include "trace.h"
+#include "batch.h"
+
+/* CHRCORE_VERSION of the library actually linked. */
+int chrcore_version(void);
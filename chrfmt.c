@@ -0,0 +1,361 @@
+#include "chrfmt.h"
+#include "export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+const char *chrfmt_name(ChrFormat f) {
+    switch (f) {
+        case CHR_FMT_RAW:      return "RAW";
+        case CHR_FMT_RLE:      return "RLE";
+        case CHR_FMT_PRED:     return "PRED";
+        default:               return "?";
+    }
+}
+
+static bool ext_is(const char *dot, const char *ext) {
+    size_t n = strlen(ext);
+    if (strlen(dot) != n) return false;
+    for (size_t i = 0; i < n; i++)
+        if (tolower((unsigned char)dot[i]) != ext[i]) return false;
+    return true;
+}
+
+ChrFormat chrfmt_from_path(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (!dot) return CHR_FMT_RAW;
+    if (ext_is(dot, ".rle"))  return CHR_FMT_RLE;
+    if (ext_is(dot, ".pred")) return CHR_FMT_PRED;
+    return CHR_FMT_RAW;
+}
+
+const char *chrfmt_refuses(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (dot && (ext_is(dot, ".tok") || ext_is(dot, ".tkm")))
+        return "Tokumaru-compressed CHR is not supported";
+    return NULL;
+}
+
+int chrfmt_parse(const char *name) {
+    if (!strcmp(name, "raw")) return CHR_FMT_RAW;
+    if (!strcmp(name, "rle")) return CHR_FMT_RLE;
+    if (!strcmp(name, "pred")) return CHR_FMT_PRED;
+    return -1;
+}
+
+/* ── RLE ──────────────────────────────────────────────────────── */
+
+typedef struct {
+    FILE   *f;
+    int     tag;
+    int     b, run;     /* pending run, b = -1 when none */
+} RleOut;
+
+static void rle_flush(RleOut *o) {
+    if (o->b < 0) return;
+    putc(o->b, o->f);
+    int rest = o->run - 1;
+    if (rest >= 2)      { putc(o->tag, o->f); putc(rest, o->f); }
+    else if (rest == 1) putc(o->b, o->f);
+    o->b = -1;
+}
+
+/* Same stream as codec_compress(CODEC_RLE, ...), built byte by byte. */
+static void rle_put(RleOut *o, int v) {
+    if (v == o->b && o->run < 256) { o->run++; return; }
+    rle_flush(o);
+    o->b   = v;
+    o->run = 1;
+}
+
+static int rle_save(const ChrPage *chr, int ntiles, FILE *f) {
+    bool seen[256] = { false };
+    uint8_t buf[16];
+    for (int t = 0; t < ntiles; t++) {
+        export_encode_tile(chr->px[t], buf);
+        for (int i = 0; i < 16; i++) seen[buf[i]] = true;
+    }
+    int tag = -1;
+    for (int v = 0; v < 256 && tag < 0; v++)
+        if (!seen[v]) tag = v;
+    if (tag < 0) return -1;
+
+    RleOut o = { f, tag, -1, 0 };
+    putc(tag, f);
+    for (int t = 0; t < ntiles; t++) {
+        export_encode_tile(chr->px[t], buf);
+        for (int i = 0; i < 16; i++) rle_put(&o, buf[i]);
+    }
+    rle_flush(&o);
+    putc(tag, f);
+    putc(0, f);
+    return ferror(f) ? -1 : 0;
+}
+
+static int rle_load(ChrPage *c, FILE *f) {
+    int tag = getc(f);
+    if (tag == EOF) return -1;
+    uint8_t buf[16];
+    int n = 0, tiles = 0, prev = -1;
+    for (;;) {
+        int b = getc(f), cnt = 1;
+        if (b == EOF) return -1;   /* missing end marker */
+        if (b == tag) {
+            cnt = getc(f);
+            if (cnt == EOF || (cnt > 0 && prev < 0)) return -1;
+            if (cnt == 0) break;
+            b = prev;
+        }
+        prev = b;
+        while (cnt-- > 0 && tiles < CHR_MAX_TILES) {
+            buf[n++] = (uint8_t)b;
+            if (n == 16) { export_decode_tile(buf, c->px[tiles++]); n = 0; }
+        }
+    }
+    return tiles;   /* a trailing partial tile is dropped */
+}
+
+/* ── Colour prediction ─────────────────────────────────────────── */
+
+typedef struct {
+    FILE    *f;        /* NULL = only count */
+    uint32_t acc;
+    int      nacc;
+    long     bytes;
+} BitOut;
+
+static void bits_put(BitOut *o, unsigned v, int n) {
+    while (n-- > 0) {
+        o->acc = (o->acc << 1) | ((v >> n) & 1);
+        if (++o->nacc == 8) {
+            if (o->f) putc((int)o->acc, o->f);
+            o->bytes++;
+            o->acc = o->nacc = 0;
+        }
+    }
+}
+
+static void bits_align(BitOut *o) {
+    if (o->nacc) bits_put(o, 0, 8 - o->nacc);
+}
+
+typedef struct {
+    FILE *f;
+    int   acc, nacc;
+    bool  eof;
+} BitIn;
+
+static unsigned bits_get(BitIn *in, int n) {
+    unsigned v = 0;
+    while (n-- > 0) {
+        if (in->nacc == 0) {
+            in->acc = getc(in->f);
+            if (in->acc == EOF) { in->eof = true; in->acc = 0; }
+            in->nacc = 8;
+        }
+        v = (v << 1) | ((unsigned)(in->acc >> --in->nacc) & 1);
+    }
+    return v;
+}
+
+/* trans[a][b]: how often colour b follows colour a (a == b included). */
+typedef struct { uint32_t trans[4][4]; } TkStats;
+
+typedef struct {
+    int     n[4];
+    uint8_t next[4][3];
+} TkTable;
+
+static bool row_repeats(const uint8_t px[TILE_H][TILE_W], int r) {
+    return r > 0 && memcmp(px[r], px[r - 1], TILE_W) == 0;
+}
+
+static void tile_stats(const uint8_t px[TILE_H][TILE_W], TkStats *s) {
+    memset(s, 0, sizeof(*s));
+    for (int r = 0; r < TILE_H; r++) {
+        if (row_repeats(px, r)) continue;
+        if (r > 0) s->trans[px[r - 1][0]][px[r][0]]++;
+        for (int x = 1; x < TILE_W; x++) s->trans[px[r][x - 1]][px[r][x]]++;
+    }
+}
+
+static void table_from(const TkStats *s, TkTable *t) {
+    for (int a = 0; a < 4; a++) {
+        t->n[a] = 0;
+        for (int b = 0; b < 4; b++) {
+            if (b == a || s->trans[a][b] == 0) continue;
+            int k = t->n[a]++;
+            /* insertion by count, most frequent first */
+            while (k > 0 && s->trans[a][t->next[a][k - 1]] < s->trans[a][b]) {
+                t->next[a][k] = t->next[a][k - 1];
+                k--;
+            }
+            t->next[a][k] = (uint8_t)b;
+        }
+    }
+}
+
+/* Code length of the i-th follow colour (-1 = repeat) with n listed. */
+static int code_len(int n, int i) {
+    if (n == 0) return 0;
+    if (i < 0)  return 1;
+    if (n == 1) return 1;
+    if (n == 2) return 2;
+    return i == 0 ? 2 : 3;
+}
+
+/* Bits for a block with stats s: its table plus every coded pixel. */
+static long block_bits(const TkStats *s) {
+    TkTable t;
+    table_from(s, &t);
+    long bits = 0;
+    for (int a = 0; a < 4; a++) {
+        bits += 2 + 2 * t.n[a];
+        bits += (long)s->trans[a][a] * code_len(t.n[a], -1);
+        for (int i = 0; i < t.n[a]; i++)
+            bits += (long)s->trans[a][t.next[a][i]] * code_len(t.n[a], i);
+    }
+    return bits;
+}
+
+static void put_pixel(BitOut *o, const TkTable *t, int p, int v) {
+    int n = t->n[p];
+    if (n == 0) return;
+    if (v == p) { bits_put(o, 0, 1); return; }
+    int i = 0;
+    while (t->next[p][i] != v) i++;
+    if (n == 1)      bits_put(o, 1, 1);
+    else if (n == 2) bits_put(o, 2 | (unsigned)i, 2);
+    else if (i == 0) bits_put(o, 2, 2);
+    else             bits_put(o, 6 | (unsigned)(i - 1), 3);
+}
+
+static int get_pixel(BitIn *in, const TkTable *t, int p) {
+    int n = t->n[p];
+    if (n == 0 || bits_get(in, 1) == 0) return p;
+    if (n == 1 || bits_get(in, 1) == 0) return t->next[p][0];
+    if (n == 2) return t->next[p][1];
+    return t->next[p][1 + (int)bits_get(in, 1)];
+}
+
+static void pred_segment(BitOut *o, const uint8_t (*px)[TILE_H][TILE_W], int n) {
+    bits_put(o, (unsigned)(n & 0xFF), 8);
+
+    TkTable table;
+    int     end = 0;   /* first tile past the current block */
+    for (int i = 0; i < n; i++) {
+        if (i < end) {
+            bits_put(o, 0, 1);
+        } else {
+            /* New block: grow it while widening its table costs less
+               than giving the next tile a table of its own.          */
+            TkStats block, next, merged;
+            tile_stats(px[i], &block);
+            for (end = i + 1; end < n; end++) {
+                tile_stats(px[end], &next);
+                merged = block;
+                for (int a = 0; a < 4; a++)
+                    for (int b = 0; b < 4; b++) merged.trans[a][b] += next.trans[a][b];
+                if (block_bits(&merged) - block_bits(&block) > block_bits(&next)) break;
+                block = merged;
+            }
+            if (i > 0) bits_put(o, 1, 1);
+            table_from(&block, &table);
+            for (int a = 0; a < 4; a++) {
+                bits_put(o, (unsigned)table.n[a], 2);
+                for (int k = 0; k < table.n[a]; k++) bits_put(o, table.next[a][k], 2);
+            }
+        }
+
+        const uint8_t (*t)[TILE_W] = px[i];
+        for (int r = 0; r < TILE_H; r++) {
+            if (r > 0) {
+                bool rep = row_repeats(t, r);
+                bits_put(o, rep, 1);
+                if (rep) continue;
+                put_pixel(o, &table, t[r - 1][0], t[r][0]);
+            } else {
+                bits_put(o, t[0][0], 2);
+            }
+            for (int x = 1; x < TILE_W; x++) put_pixel(o, &table, t[r][x - 1], t[r][x]);
+        }
+    }
+    bits_align(o);
+}
+
+static int pred_load(ChrPage *c, FILE *f) {
+    int tiles = 0;
+    for (;;) {
+        int cnt = getc(f);
+        if (cnt == EOF) break;
+        int n = cnt ? cnt : 256;
+        BitIn   in = { f, 0, 0, false };
+        TkTable table;
+        for (int i = 0; i < n; i++) {
+            if (i == 0 || bits_get(&in, 1)) {
+                for (int a = 0; a < 4; a++) {
+                    table.n[a] = (int)bits_get(&in, 2);
+                    for (int k = 0; k < table.n[a]; k++)
+                        table.next[a][k] = (uint8_t)bits_get(&in, 2);
+                }
+            }
+            uint8_t px[TILE_H][TILE_W];
+            for (int r = 0; r < TILE_H; r++) {
+                if (r > 0 && bits_get(&in, 1)) {
+                    memcpy(px[r], px[r - 1], TILE_W);
+                    continue;
+                }
+                px[r][0] = r > 0 ? (uint8_t)get_pixel(&in, &table, px[r - 1][0])
+                                 : (uint8_t)bits_get(&in, 2);
+                for (int x = 1; x < TILE_W; x++)
+                    px[r][x] = (uint8_t)get_pixel(&in, &table, px[r][x - 1]);
+            }
+            if (in.eof) return -1;   /* truncated segment */
+            if (tiles < CHR_MAX_TILES) memcpy(c->px[tiles++], px, sizeof(px));
+        }
+    }
+    return tiles > 0 ? tiles : -1;
+}
+
+static int pred_save(const ChrPage *chr, int ntiles, FILE *f) {
+    BitOut o = { f, 0, 0, 0 };
+    for (int i = 0; i < ntiles; i += 256)
+        pred_segment(&o, chr->px + i, ntiles - i < 256 ? ntiles - i : 256);
+    return ferror(f) ? -1 : 0;
+}
+
+long chrfmt_pred_size(const uint8_t (*px)[TILE_H][TILE_W], int ntiles) {
+    BitOut o = { NULL, 0, 0, 0 };
+    for (int i = 0; i < ntiles; i += 256)
+        pred_segment(&o, px + i, ntiles - i < 256 ? ntiles - i : 256);
+    return o.bytes;
+}
+
+/* ── Entry points ─────────────────────────────────────────────── */
+
+int chrfmt_load(ChrPage *c, const char *path, ChrFormat f) {
+    if (chrfmt_refuses(path)) return -1;
+    if (f == CHR_FMT_RAW) return chr_load(c, path);
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+    ChrPage *tmp = calloc(1, sizeof(*tmp));   /* keep *c intact on a bad stream */
+    int tiles = -1;
+    if (tmp) tiles = f == CHR_FMT_RLE ? rle_load(tmp, fp) : pred_load(tmp, fp);
+    fclose(fp);
+    if (tiles >= 1) memcpy(c->px, tmp->px, sizeof(c->px));
+    free(tmp);
+    return tiles >= 1 ? tiles : -1;
+}
+
+int chrfmt_save(const ChrPage *chr, int ntiles, const char *path, ChrFormat f) {
+    if (chrfmt_refuses(path)) return -1;
+    if (f == CHR_FMT_RAW) return export_chr(chr, ntiles, path);
+    if (ntiles < 1 || ntiles > CHR_MAX_TILES) return -1;
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return -1;
+    int rc = f == CHR_FMT_RLE ? rle_save(chr, ntiles, fp) : pred_save(chr, ntiles, fp);
+    if (fclose(fp) != 0) rc = -1;
+    return rc;
+}
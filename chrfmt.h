@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include "chr.h"
+
+/* ── Compressed CHR files ────────────────────────────────────────
+   Companions to chr_load / export_chr for sheets stored compressed.
+   Both directions stream a tile at a time through stdio; no
+   whole-file buffer is built.
+
+   CHR_FMT_RAW       plain planar CHR (.chr and anything unknown but
+                     .tok/.tkm, which are refused).
+   CHR_FMT_RLE       the planar bytes as one CODEC_RLE stream (.rle):
+                     tag byte, data, "tag n" = repeat previous byte
+                     n times, "tag 0" = end.  Decodes with neslib's
+                     vram_unrle straight into the PPU.
+   CHR_FMT_PRED      chrmaker's own colour-prediction coding (.pred).
+                     The idea is that of Tokumaru's tile compressor,
+                     but the bit stream is not his; .tok/.tkm files
+                     from that tool are refused (chrfmt_refuses).
+                     A file is a run of segments of up to 256 tiles:
+
+       byte   tile count (0 = 256); the bit stream follows, MSB
+              first, and is padded to a byte at the end of the segment.
+       block  colour table: for colours 0-3, 2 bits n (0-3), then n
+              2-bit colours that may follow it, most likely first.
+              Before every tile but a segment's first, 1 bit: 1 = a
+              new table follows, 0 = keep the current one.
+       tile   8 rows.  Rows 1-7 start with 1 bit: 1 = repeat the row
+              above.  Otherwise pixels are coded left to right, each
+              from the one before it (a row's first pixel from the
+              first pixel of the row above; row 0's first pixel is 2
+              raw bits).  From colour p with follow list L:
+                n = 0: no bits, the pixel stays p
+                "0" = p, then L[0], L[1], L[2] as "1" (n = 1),
+                "10" "11" (n = 2), or "10" "110" "111" (n = 3).
+
+   The encoder starts a new table whenever that is cheaper than
+   widening the current one for the next tile.                      */
+
+typedef enum {
+    CHR_FMT_RAW,
+    CHR_FMT_RLE,
+    CHR_FMT_PRED,
+    CHR_FMT_COUNT
+} ChrFormat;
+
+/* Short upper-case label for status text, e.g. "RLE". */
+const char *chrfmt_name(ChrFormat f);
+
+/* Format implied by a file extension (case-insensitive). */
+ChrFormat   chrfmt_from_path(const char *path);
+
+/* Why chrfmt_load and chrfmt_save refuse path, or NULL.  Refused:
+   .tok/.tkm, the files of Tokumaru's own compressor.  Its stream
+   isn't implemented, and reading one as raw CHR would show garbage
+   and a save would overwrite the compressed file with raw bytes.  */
+const char *chrfmt_refuses(const char *path);
+
+/* "raw", "rle", "pred" → format, or -1. */
+int         chrfmt_parse(const char *name);
+
+/* Same contracts as chr_load (tiles loaded, or -1) and export_chr
+   (0, or -1; RLE also fails when all 256 byte values occur).  Both
+   fail without touching the file for a path chrfmt_refuses.       */
+int  chrfmt_load(ChrPage *c, const char *path, ChrFormat f);
+int  chrfmt_save(const ChrPage *chr, int ntiles, const char *path, ChrFormat f);
+
+/* Size in bytes of ntiles tiles from px encoded as CHR_FMT_PRED,
+   without writing anything (for the size estimator).               */
+long chrfmt_pred_size(const uint8_t (*px)[TILE_H][TILE_W], int ntiles);
@@ -0,0 +1,386 @@
+/* chrgen — NES CHR generator (stdin → tiles in a raw CHR file)
+
+   Usage:
+       chrgen [--fill] [--tiles=N] OUTPUT.chr
+
+   Reads sprite definitions from stdin and writes their tiles into
+   OUTPUT.chr, which is created if missing.  Definitions are JSON
+   objects, either in one array or one after another (one per line
+   suits a generator feeding a pipe); each is encoded and queued for
+   writing as soon as it has been read, so input of any length runs
+   in constant memory:
+
+       [
+         { "size": 8,  "pixels": [ "00111100", ... ] },   8 rows × 8
+         { "size": 16, "pixels": [ "0011111111110000", ... ] }
+       ]
+
+   Pixel values 0-3 (0 = background); spaces inside a row are
+   ignored, as are keys other than "size" (default 8) and "pixels".
+   A 16×16 sprite becomes four tiles stored TL, BL, TR, BR, the order
+   chrmaker's Sprite-16 mode draws as [TL][TR] / [BL][BR].
+
+   New tiles go after the last non-blank tile in the file, or with
+   --fill into the first blank slots (a 16×16 sprite needs four in a
+   row).  The file is read once, to find the free slots, into a copy
+   next to it that takes the new tiles and replaces it only once all
+   the input has been read; bad input leaves the file as it was.  The
+   copy is extended with blank tiles to N tiles (--tiles, default 256
+   or the file's current size, whichever is larger); tiles that don't
+   fit in N are dropped with a warning.  Status goes to stderr.     */
+
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "chr.h"
+#include "export.h"
+
+#define CHRGEN_TILES     256        /* default size: one pattern table   */
+#define CHRGEN_MAX_TILES 65536      /* 1 MB, the largest CHR ROM         */
+#define CHRGEN_RUN       256        /* tiles gathered per write          */
+#define CHRGEN_ROW_MAX   64         /* characters per pixel row, spaces included */
+
+/* ── Input ───────────────────────────────────────────────────── */
+
+typedef struct {
+    FILE *f;
+    long  line;         /* for messages */
+} Reader;
+
+static int peek(Reader *r) {
+    int c = getc_unlocked(r->f);
+    if (c != EOF) ungetc(c, r->f);
+    return c;
+}
+
+static int next(Reader *r) {
+    int c = getc_unlocked(r->f);
+    if (c == '\n') r->line++;
+    return c;
+}
+
+static int skip_ws(Reader *r) {
+    int c;
+    while ((c = peek(r)) == ' ' || c == '\t' || c == '\r' || c == '\n') next(r);
+    return c;
+}
+
+static int fail(const Reader *r, const char *what) {
+    fprintf(stderr, "stdin:%ld: %s\n", r->line, what);
+    return -1;
+}
+
+/* A JSON string into out (at most cap-1 characters kept; escapes
+   are taken literally, none occur in pixel rows).  Returns its
+   length, or -1.                                                  */
+static int read_string(Reader *r, char *out, int cap) {
+    if (skip_ws(r) != '"') return fail(r, "expected a string");
+    next(r);
+    int n = 0, c;
+    while ((c = next(r)) != '"') {
+        if (c == EOF || c == '\n') return fail(r, "unterminated string");
+        if (c == '\\' && (c = next(r)) == EOF) return fail(r, "unterminated string");
+        if (n < cap - 1) out[n++] = (char)c;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+/* Any JSON value, for keys we don't use. */
+static int skip_value(Reader *r) {
+    int c = skip_ws(r);
+    if (c == '"') {
+        char tmp[1];
+        return read_string(r, tmp, 1) < 0 ? -1 : 0;
+    }
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        do {
+            c = skip_ws(r);
+            if (c == '"') { if (skip_value(r) != 0) return -1; continue; }
+            if (c == EOF) return fail(r, "unexpected end of input");
+            next(r);
+            if (c == '{' || c == '[') depth++;
+            if (c == '}' || c == ']') depth--;
+        } while (depth > 0);
+        return 0;
+    }
+    while ((c = peek(r)) != EOF && c != ',' && c != '}' && c != ']' &&
+           c != ' ' && c != '\t' && c != '\r' && c != '\n')
+        next(r);
+    return 0;
+}
+
+typedef struct {
+    int     size;                       /* 8 or 16                   */
+    int     rows;
+    uint8_t width[16];                  /* pixels in each row        */
+    uint8_t px[16][16];                 /* 0-3                       */
+} Sprite;
+
+static int read_rows(Reader *r, Sprite *sp) {
+    if (skip_ws(r) != '[') return fail(r, "\"pixels\" must be an array of strings");
+    next(r);
+    sp->rows = 0;
+    for (;;) {
+        int c = skip_ws(r);
+        if (c == ']') { next(r); return 0; }
+        if (c == ',') { next(r); continue; }
+        char row[CHRGEN_ROW_MAX];
+        if (read_string(r, row, sizeof(row)) < 0) return -1;
+        if (sp->rows == 16) return fail(r, "more than 16 pixel rows");
+        int n = 0;
+        for (const char *p = row; *p; p++) {
+            if (*p == ' ') continue;
+            if (*p < '0' || *p > '3') return fail(r, "pixels must be 0-3");
+            if (n == 16) return fail(r, "pixel row longer than 16");
+            sp->px[sp->rows][n++] = (uint8_t)(*p - '0');
+        }
+        sp->width[sp->rows++] = (uint8_t)n;
+    }
+}
+
+/* The next sprite object: 1, 0 at the end of the input (or of the
+   array), -1 on error.                                           */
+static int read_sprite(Reader *r, Sprite *sp) {
+    int c;
+    while ((c = skip_ws(r)) == ',' || c == '[') next(r);
+    if (c == EOF || c == ']') return 0;
+    if (c != '{') return fail(r, "expected a sprite object");
+    next(r);
+
+    sp->size = 8;
+    sp->rows = -1;
+    for (;;) {
+        c = skip_ws(r);
+        if (c == '}') { next(r); break; }
+        if (c == ',') { next(r); continue; }
+        char key[16];
+        if (read_string(r, key, sizeof(key)) < 0) return -1;
+        if (skip_ws(r) != ':') return fail(r, "expected ':'");
+        next(r);
+        if (!strcmp(key, "pixels")) {
+            if (read_rows(r, sp) != 0) return -1;
+        } else if (!strcmp(key, "size")) {
+            skip_ws(r);
+            if (fscanf(r->f, "%d", &sp->size) != 1) return fail(r, "\"size\" must be a number");
+        } else if (skip_value(r) != 0) {
+            return -1;
+        }
+    }
+
+    if (sp->size != 8 && sp->size != 16) return fail(r, "size must be 8 or 16");
+    if (sp->rows < 0) return fail(r, "sprite has no \"pixels\"");
+    if (sp->rows != sp->size) return fail(r, sp->size == 8 ? "tile must have 8 rows"
+                                                           : "16x16 sprite must have 16 rows");
+    for (int y = 0; y < sp->rows; y++)
+        if (sp->width[y] != sp->size)
+            return fail(r, sp->size == 8 ? "row must be 8 pixels" : "16x16 row must be 16 pixels");
+    return 1;
+}
+
+/* Sprite → planar tiles (1, or 4 in TL, BL, TR, BR order). */
+static int encode_sprite(const Sprite *sp, uint8_t out[4][16]) {
+    int n = sp->size == 16 ? 4 : 1;
+    for (int q = 0; q < n; q++) {
+        uint8_t px[TILE_H][TILE_W];
+        int y0 = (q & 1) * TILE_H, x0 = (q >> 1) * TILE_W;
+        for (int y = 0; y < TILE_H; y++)
+            memcpy(px[y], &sp->px[y0 + y][x0], TILE_W);
+        export_encode_tile(px, out[q]);
+    }
+    return n;
+}
+
+/* ── Output ──────────────────────────────────────────────────── */
+
+typedef struct {
+    int      fd;                        /* the copy being written     */
+    int      cap;                       /* tiles the file may hold    */
+    uint8_t *used;                      /* per slot: non-blank        */
+    int      next;                      /* where the search starts    */
+    bool     fill;
+    int      run_first, run_n;          /* tiles gathered in buf      */
+    uint8_t  buf[CHRGEN_RUN * 16];
+} Out;
+
+static int write_at(int fd, const uint8_t *buf, size_t len, off_t at) {
+    for (size_t done = 0; done < len; ) {
+        ssize_t w = pwrite(fd, buf + done, len - done, at + (off_t)done);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        done += (size_t)w;
+    }
+    return 0;
+}
+
+static int flush_run(Out *o) {
+    if (write_at(o->fd, o->buf, (size_t)o->run_n * 16, (off_t)o->run_first * 16) != 0)
+        return -1;
+    o->run_n = 0;
+    return 0;
+}
+
+/* First slot of n free ones in a row, or -1. */
+static int find_slots(Out *o, int n) {
+    for (int at = o->next; at + n <= o->cap; at++) {
+        int k = 0;
+        while (k < n && !o->used[at + k]) k++;
+        if (k == n) return at;
+        at += k;                        /* skip past the used slot */
+    }
+    return -1;
+}
+
+static int put_tile(Out *o, int slot, const uint8_t tile[16]) {
+    if (o->run_n && (slot != o->run_first + o->run_n || o->run_n == CHRGEN_RUN) &&
+        flush_run(o) != 0) return -1;
+    if (o->run_n == 0) o->run_first = slot;
+    memcpy(o->buf + (size_t)o->run_n * 16, tile, 16);
+    o->run_n++;
+    o->used[slot] = 1;
+    return 0;
+}
+
+/* Copy the file (src, -1 if there is none yet) into o->fd, marking
+   its non-blank slots.  Returns the number of whole tiles in it, or
+   -1.                                                             */
+static long scan(Out *o, int src) {
+    static uint8_t chunk[CHRGEN_RUN * 16];
+    long tiles = 0;
+    int  last  = -1;
+    while (src >= 0) {
+        ssize_t n = pread(src, chunk, sizeof(chunk), (off_t)tiles * 16);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (write_at(o->fd, chunk, (size_t)n, (off_t)tiles * 16) != 0) return -1;
+        for (ssize_t i = 0; i + 16 <= n; i += 16, tiles++) {
+            bool blank = true;
+            for (int b = 0; b < 16 && blank; b++) blank = chunk[i + b] == 0;
+            if (!blank && tiles < o->cap) {
+                o->used[tiles] = 1;
+                last = (int)tiles;
+            }
+        }
+        if (n < (ssize_t)sizeof(chunk)) break;
+    }
+    o->next = o->fill ? 0 : last + 1;
+    return tiles;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    long want = 0;
+    bool fill = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--fill"))              fill = true;
+        else if (!strncmp(argv[i], "--tiles=", 8))   want = strtol(argv[i] + 8, NULL, 10);
+        else if (!path && argv[i][0] != '-')         path = argv[i];
+        else                                         path = NULL, i = argc;
+    }
+    if (!path || want < 0 || want > CHRGEN_MAX_TILES) {
+        fprintf(stderr, "usage: %s [--fill] [--tiles=N] <output.chr>  (N up to %d)\n",
+                argv[0], CHRGEN_MAX_TILES);
+        return 1;
+    }
+
+    static Out o;
+    o.fill = fill;
+    struct stat st = { 0 };
+    int src = open(path, O_RDONLY);
+    if (src < 0 ? errno != ENOENT : fstat(src, &st) != 0) {
+        fprintf(stderr, "can't open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (src < 0) {                      /* new file: 0644 less the umask */
+        mode_t mask = umask(0);
+        umask(mask);
+        st.st_mode = 0644 & ~mask;
+    }
+
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp)) {
+        fprintf(stderr, "can't open %s: path too long\n", path);
+        return 1;
+    }
+    o.fd = mkstemp(tmp);
+    if (o.fd < 0 || fchmod(o.fd, st.st_mode & 07777) != 0) {
+        fprintf(stderr, "can't create a copy of %s: %s\n", path, strerror(errno));
+        if (o.fd >= 0) { close(o.fd); unlink(tmp); }
+        return 1;
+    }
+
+    long have = (long)(st.st_size / 16);
+    long cap  = want ? want : have > CHRGEN_TILES ? have : CHRGEN_TILES;
+    o.cap  = (int)(cap < CHRGEN_MAX_TILES ? cap : CHRGEN_MAX_TILES);
+    o.used = calloc((size_t)o.cap, 1);
+    if (!o.used || scan(&o, src) < 0) {
+        fprintf(stderr, "can't copy %s: %s\n", path, o.used ? strerror(errno) : "out of memory");
+        close(o.fd);
+        unlink(tmp);
+        free(o.used);
+        return 1;
+    }
+    if (src >= 0) close(src);
+
+    Reader r = { stdin, 1 };
+    Sprite sp;
+    int  sprites = 0, written = 0, dropped = 0, first = -1, rc;
+    while ((rc = read_sprite(&r, &sp)) > 0) {
+        uint8_t tiles[4][16];
+        int n    = encode_sprite(&sp, tiles);
+        /* Once something is dropped, later sprites only go into holes
+           with --fill; appending them would break the input order.  */
+        int slot = dropped && !o.fill ? -1 : find_slots(&o, n);
+        sprites++;
+        if (slot < 0) { dropped += n; continue; }
+        for (int k = 0; k < n; k++)
+            if (put_tile(&o, slot + k, tiles[k]) != 0) goto write_error;
+        if (first < 0) first = slot;
+        if (!o.fill) o.next = slot + n;
+        while (o.next < o.cap && o.used[o.next]) o.next++;
+        written += n;
+    }
+    if (rc < 0) {
+        fprintf(stderr, "sprite %d: bad input, %s left as it was\n", sprites, path);
+        close(o.fd);
+        unlink(tmp);
+        free(o.used);
+        return 1;
+    }
+    if (o.run_n && flush_run(&o) != 0) goto write_error;
+
+    /* Pad with blank tiles; never shortens the file. */
+    if (st.st_size < (off_t)o.cap * 16 && ftruncate(o.fd, (off_t)o.cap * 16) != 0)
+        goto write_error;
+    if (close(o.fd) != 0) {
+        o.fd = -1;
+        goto write_error;
+    }
+    if (rename(tmp, path) != 0) goto write_error;
+    free(o.used);
+
+    if (dropped)
+        fprintf(stderr, "warning: no free slots left in %d tile(s), dropped %d new tile(s)\n",
+                o.cap, dropped);
+    fprintf(stderr, "%d sprite(s) → %d tile(s) @ slot %d → %s\n",
+            sprites, written, first < 0 ? 0 : first, path);
+    return 0;
+
+write_error:
+    fprintf(stderr, "can't write %s: %s\n", path, strerror(errno));
+    if (o.fd >= 0) close(o.fd);
+    unlink(tmp);
+    free(o.used);
+    return 1;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/* ── libchrmaker ─────────────────────────────────────────────────
+   A small, stable C ABI over libchrcore for scripts and other
+   languages (ctypes, cffi, FFI in general).  Only fixed-width
+   integers, plain pointers and one opaque handle cross it; there are
+   no structs to mirror, and within one CHRMAKER_ABI every function
+   keeps its signature.  Only the cm_ symbols are exported.
+
+   Buffers are the caller's and are never copied: pass a pointer into
+   a bytearray or numpy array and the results land there.  Layouts:
+
+       pixels   one byte per pixel, value 0-3, 64 per tile
+                (tile, row, column) — an n × 8 × 8 array
+       planar   NES CHR, 16 bytes per tile: 8 bytes bitplane 0,
+                8 bytes bitplane 1 (the .chr file layout)
+       sprite16 256 bytes per 16×16 sprite, row-major
+       argb     uint32 0xAARRGGBB per pixel (B, G, R, A in memory on
+                little-endian machines), rows stride pixels apart
+
+   Functions return a count or 0 on success and -1 on error;
+   cm_error() then says why.  A project may be used by one thread at
+   a time; separate projects and the bulk tile functions are safe to
+   use from several threads at once.                               */
+
+#define CHRMAKER_ABI 1
+
+#define CM_TILE_PIXELS  64
+#define CM_TILE_BYTES   16
+#define CM_MAX_TILES    1024    /* tiles a project's sheet holds       */
+#define CM_PALETTES     32      /* sub-palettes of 4 master-palette indices */
+#define CM_SCENE_W      32      /* nametable size in tiles             */
+#define CM_SCENE_H      30
+#define CM_SCREEN_W     256     /* rendered scene size in pixels       */
+#define CM_SCREEN_H     240
+
+/* CHRMAKER_ABI of the library actually loaded. */
+int cm_abi_version(void);
+
+/* Why the calling thread's last failing call failed. */
+const char *cm_error(void);
+
+/* ── Bulk tile kernels ───────────────────────────────────────── */
+
+/* n tiles between pixels and planar.  Large batches are split across
+   CPUs.  Encoding fails on a pixel value over 3 (nothing written).  */
+int cm_decode_tiles(const uint8_t *planar, int64_t n, uint8_t *pixels);
+int cm_encode_tiles(const uint8_t *pixels, int64_t n, uint8_t *planar);
+
+/* n 16×16 sprites → 4n tiles of pixels in Sprite-16 order: top-left,
+   bottom-left, top-right, bottom-right.                            */
+int cm_split_sprites16(const uint8_t *sprite16, int64_t n, uint8_t *pixels);
+
+/* Group n planar tiles by content.  rep[t] gets the lowest-numbered
+   tile with the same pixels — with flips, the same up to an H/V
+   flip — and flip[t] (may be NULL) the flip taking rep[t] to t:
+   bit 0 horizontal, bit 1 vertical.  Returns the number of tiles
+   that repeat an earlier one.                                     */
+int64_t cm_dedupe_tiles(const uint8_t *planar, int64_t n, int flips,
+                        int32_t *rep, uint8_t *flip);
+
+/* ── Projects ────────────────────────────────────────────────────
+   A sheet of tiles with its palettes and scenes, as the editor holds
+   it.  The CHR format follows the file extension (.chr, .rle, .pred;
+   Tokumaru .tok/.tkm files are refused); .pal and .scn sidecars are
+   read and written alongside.                                     */
+
+typedef struct CmProject CmProject;
+
+/* A blank cols × rows sheet (cols*rows <= CM_MAX_TILES) with the
+   default palettes and one empty scene; NULL on error.             */
+CmProject *cm_project_new(int cols, int rows);
+
+/* Load a CHR file and any sidecars.  The sheet is cols wide (0 = 16)
+   and as tall as the file needs.  NULL on error.                   */
+CmProject *cm_project_open(const char *chr_path, int cols);
+
+/* Write the sheet's cols × rows tiles and both sidecars. */
+int  cm_project_save(CmProject *p, const char *chr_path);
+void cm_project_free(CmProject *p);
+
+int  cm_project_cols(const CmProject *p);
+int  cm_project_rows(const CmProject *p);
+
+/* Change the sheet's shape (cols*rows <= CM_MAX_TILES); the tiles
+   stay where they are in storage.                                  */
+int  cm_project_set_size(CmProject *p, int cols, int rows);
+
+/* The project's own storage, valid until cm_project_free: pixels of
+   all CM_MAX_TILES tiles, the sub-palette of each tile, and the
+   CM_PALETTES × 4 palette table.  Write to them directly.          */
+uint8_t *cm_project_pixels(CmProject *p);
+uint8_t *cm_project_tile_palettes(CmProject *p);
+uint8_t *cm_project_palettes(CmProject *p);
+
+int  cm_project_scene_count(const CmProject *p);
+
+/* Append a blank scene; its index, or -1 at the scene limit. */
+int  cm_project_add_scene(CmProject *p);
+
+/* Scene storage: CM_SCENE_H × CM_SCENE_W tile numbers, and 15 × 16
+   attribute palettes (0-3, one per 2×2 block of cells).  Valid until
+   the next cm_project_save or cm_project_add_scene.  The _read_
+   versions are for looking only and don't mark the scene edited.  */
+uint16_t *cm_project_nametable(CmProject *p, int scene);
+uint8_t  *cm_project_attributes(CmProject *p, int scene);
+const uint16_t *cm_project_read_nametable(CmProject *p, int scene);
+const uint8_t  *cm_project_read_attributes(CmProject *p, int scene);
+
+/* Draw scene (CM_SCREEN_W × CM_SCREEN_H) or the whole sheet
+   ((cols*8) × (rows*8), in each tile's sub-palette, or grey) into
+   argb.  stride is in pixels, 0 = the image width.                 */
+int  cm_project_render_scene(CmProject *p, int scene, uint32_t *argb, int stride);
+int  cm_project_render_sheet(CmProject *p, int gray, uint32_t *argb, int stride);
+
+/* Point every scene reference at the lowest-numbered copy of its
+   tile, as batch mode's dedupe does.  Returns the number of
+   duplicate tiles; *refs (may be NULL) gets the references
+   rewritten.                                                      */
+int  cm_project_dedupe(CmProject *p, int flips, int *refs);
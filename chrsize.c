@@ -0,0 +1,181 @@
+#include "chrsize.h"
+#include "export.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ChrSizeWorker {
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_t       tid;
+    bool            threaded;
+
+    /* Main thread only: the bytes last handed over, per bank. */
+    uint8_t  sent[CHRSIZE_BANKS][CHRSIZE_BANK_BYTES];
+    int      sent_len[CHRSIZE_BANKS];
+
+    /* Shared, under lock. */
+    bool     quit;
+    int      nbanks;
+    uint8_t  in[CHRSIZE_BANKS][CHRSIZE_BANK_BYTES];
+    int      in_len[CHRSIZE_BANKS];
+    bool     dirty[CHRSIZE_BANKS];   /* in[] newer than size[]      */
+    int      busy;                   /* bank being compressed, or -1 */
+    long     size[CHRSIZE_BANKS][CHRSIZE_CODECS];
+};
+
+static void bank_sizes(const uint8_t *src, int n, long out[CHRSIZE_CODECS]) {
+    uint8_t dst[CODEC_BOUND(CHRSIZE_BANK_BYTES)];
+    for (int c = 0; c < CODEC_COUNT; c++)
+        out[c] = n > 0 ? codec_compress((Codec)c, src, (size_t)n, dst) : 0;
+
+    /* The CHR coder works on pixels: unpack the planes again. */
+    uint8_t px[CHRSIZE_BANK_TILES][TILE_H][TILE_W];
+    int ntiles = n / 16;
+    for (int t = 0; t < ntiles; t++)
+        for (int row = 0; row < TILE_H; row++)
+            for (int col = 0; col < TILE_W; col++) {
+                int bit = 7 - col;
+                px[t][row][col] = (uint8_t)(((src[t * 16 + row] >> bit) & 1) |
+                                            (((src[t * 16 + 8 + row] >> bit) & 1) << 1));
+            }
+    out[CHRSIZE_PRED] = ntiles > 0
+        ? chrfmt_pred_size((const uint8_t (*)[TILE_H][TILE_W])px, ntiles) : 0;
+}
+
+size_t chrsize_mem(const ChrSize *cs) {
+    return cs->w ? sizeof(*cs->w) : 0;
+}
+
+const char *chrsize_codec_name(int c) {
+    return c == CHRSIZE_PRED ? chrfmt_name(CHR_FMT_PRED) : codec_name((Codec)c);
+}
+
+static void *chrsize_worker(void *arg) {
+    struct ChrSizeWorker *w = arg;
+    uint8_t buf[CHRSIZE_BANK_BYTES];
+    trace_thread_name("chrsize");
+    pthread_mutex_lock(&w->lock);
+    while (!w->quit) {
+        int b = 0;
+        while (b < CHRSIZE_BANKS && !w->dirty[b]) b++;
+        if (b == CHRSIZE_BANKS) { pthread_cond_wait(&w->wake, &w->lock); continue; }
+
+        int n = w->in_len[b];
+        memcpy(buf, w->in[b], (size_t)n);
+        w->dirty[b] = false;
+        w->busy     = b;
+        pthread_mutex_unlock(&w->lock);
+
+        long sz[CHRSIZE_CODECS];
+        TraceZone z = trace_begin("chrsize bank");
+        bank_sizes(buf, n, sz);
+        trace_end(z);
+
+        pthread_mutex_lock(&w->lock);
+        w->busy = -1;
+        if (!w->dirty[b])                /* not superseded meanwhile */
+            memcpy(w->size[b], sz, sizeof(sz));
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+void chrsize_init(ChrSize *cs) {
+    memset(cs, 0, sizeof(*cs));
+    cs->ntiles = -1;
+    struct ChrSizeWorker *w = calloc(1, sizeof(*w));
+    if (!w) return;
+    w->busy = -1;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->wake, NULL);
+    w->threaded = pthread_create(&w->tid, NULL, chrsize_worker, w) == 0;
+    cs->w = w;
+}
+
+void chrsize_free(ChrSize *cs) {
+    struct ChrSizeWorker *w = cs->w;
+    if (!w) return;
+    if (w->threaded) {
+        pthread_mutex_lock(&w->lock);
+        w->quit = true;
+        pthread_cond_signal(&w->wake);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->tid, NULL);
+    }
+    pthread_cond_destroy(&w->wake);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+    cs->w = NULL;
+}
+
+void chrsize_update(ChrSize *cs, const ChrPage *chr, int ntiles,
+                    uint32_t edit_rev, uint32_t chr_rev,
+                    const uint32_t tile_rev[CHR_MAX_TILES]) {
+    struct ChrSizeWorker *w = cs->w;
+    if (!w) return;
+    if (ntiles < 0) ntiles = 0;
+    if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+
+    bool all = ntiles != cs->ntiles || edit_rev != cs->edit_rev;
+    if (!all && chr_rev == cs->chr_rev) return;
+
+    int  nbanks = (ntiles + CHRSIZE_BANK_TILES - 1) / CHRSIZE_BANK_TILES;
+    bool want[CHRSIZE_BANKS] = { false };
+    for (int t = 0; t < ntiles; t++)
+        if (all || tile_rev[t] > cs->chr_rev) want[t / CHRSIZE_BANK_TILES] = true;
+    cs->ntiles   = ntiles;
+    cs->edit_rev = edit_rev;
+    cs->chr_rev  = chr_rev;
+
+    uint8_t buf[CHRSIZE_BANK_BYTES];
+    bool    queued = false;
+    for (int b = 0; b < nbanks; b++) {
+        if (!want[b]) continue;
+        int first = b * CHRSIZE_BANK_TILES;
+        int count = ntiles - first < CHRSIZE_BANK_TILES ? ntiles - first : CHRSIZE_BANK_TILES;
+        for (int i = 0; i < count; i++)
+            export_encode_tile(chr->px[first + i], buf + i * 16);
+        int n = count * 16;
+        if (n == w->sent_len[b] && memcmp(buf, w->sent[b], (size_t)n) == 0) continue;
+        memcpy(w->sent[b], buf, (size_t)n);
+        w->sent_len[b] = n;
+
+        if (!w->threaded) {
+            w->in_len[b] = n;
+            bank_sizes(buf, n, w->size[b]);
+            continue;
+        }
+        pthread_mutex_lock(&w->lock);
+        memcpy(w->in[b], buf, (size_t)n);
+        w->in_len[b] = n;
+        w->dirty[b]  = true;
+        pthread_mutex_unlock(&w->lock);
+        queued = true;
+    }
+
+    if (w->threaded) pthread_mutex_lock(&w->lock);
+    w->nbanks = nbanks;
+    if (queued) pthread_cond_signal(&w->wake);
+    if (w->threaded) pthread_mutex_unlock(&w->lock);
+}
+
+void chrsize_report(const ChrSize *cs, ChrSizeReport *out) {
+    memset(out, 0, sizeof(*out));
+    struct ChrSizeWorker *w = cs->w;
+    if (!w) return;
+    if (w->threaded) pthread_mutex_lock(&w->lock);
+    out->nbanks = w->nbanks;
+    for (int b = 0; b < w->nbanks; b++) {
+        out->raw[b]     = w->in_len[b];
+        out->raw_total += w->in_len[b];
+        out->pending   += w->dirty[b] || w->busy == b;
+        for (int c = 0; c < CHRSIZE_CODECS; c++) {
+            out->size[b][c] = w->size[b][c];
+            if (out->total[c] >= 0)
+                out->total[c] = w->size[b][c] < 0 ? -1 : out->total[c] + w->size[b][c];
+        }
+    }
+    if (w->threaded) pthread_mutex_unlock(&w->lock);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "chr.h"
+#include "compress.h"
+#include "chrfmt.h"
+
+/* ── Compressed-size estimator ───────────────────────────────────
+   Keeps the size of the sheet under every codec (compress.h, plus
+   the colour-prediction CHR coding of chrfmt.h), per 4 KB bank — one
+   pattern table, compressed on its own so banks can be swapped
+   independently — and in total.  chrsize_update runs on
+   the main loop: it encodes only banks whose tiles were stamped since
+   the last call (all banks after an edit_rev change), and hands the
+   ones whose bytes really differ to a worker thread.  The renderer
+   reads the latest figures with chrsize_report; a bank being
+   recompressed keeps its previous numbers and is counted as pending. */
+
+#define CHRSIZE_BANK_TILES 256
+#define CHRSIZE_BANK_BYTES (CHRSIZE_BANK_TILES * 16)
+#define CHRSIZE_BANKS      (CHR_MAX_TILES / CHRSIZE_BANK_TILES)
+
+/* Columns of the report: the Codec values, then CHR_FMT_PRED. */
+#define CHRSIZE_PRED        CODEC_COUNT
+#define CHRSIZE_CODECS     (CODEC_COUNT + 1)
+
+typedef struct {
+    int  nbanks;                         /* banks covering the sheet      */
+    int  raw[CHRSIZE_BANKS];             /* uncompressed bytes per bank   */
+    long size[CHRSIZE_BANKS][CHRSIZE_CODECS];  /* -1 = can't encode it */
+    long raw_total;
+    long total[CHRSIZE_CODECS];          /* -1 if any bank is -1          */
+    int  pending;                        /* banks not yet recompressed    */
+} ChrSizeReport;
+
+typedef struct {
+    struct ChrSizeWorker *w;
+    int      ntiles;                     /* sheet size last handed over   */
+    uint32_t edit_rev, chr_rev;
+} ChrSize;
+
+/* chrsize_init expects uninitialised (or freed) memory.  If no worker
+   thread can be started, updates compress inline instead.         */
+void chrsize_init(ChrSize *cs);
+void chrsize_free(ChrSize *cs);
+
+/* Pass the editor's change stamps (see EditorState); ntiles is the
+   number of tiles that a save writes.                             */
+void chrsize_update(ChrSize *cs, const ChrPage *chr, int ntiles,
+                    uint32_t edit_rev, uint32_t chr_rev,
+                    const uint32_t tile_rev[CHR_MAX_TILES]);
+
+void chrsize_report(const ChrSize *cs, ChrSizeReport *out);
+
+/* Bytes held by the worker (0 if none). */
+size_t chrsize_mem(const ChrSize *cs);
+
+/* Label of a report column, e.g. "LZ". */
+const char *chrsize_codec_name(int c);
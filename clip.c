@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+#include "clip.h"
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CLIP_MAGIC   0x50494c43u    /* "CLIP" */
+#define CLIP_VERSION 1
+#define CLIP_SPINS   1000000        /* tries before a stuck writer is ignored */
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    size;               /* sizeof(ClipShm) of the creator */
+    atomic_uint seq;                /* odd while a copy is being written */
+    ClipData    data;
+} ClipShm;
+
+static ClipShm  *shm;               /* mapped segment, or private buffer */
+static bool      shm_mapped;
+static ClipData *snap;              /* local copy handed out by clip_get */
+static unsigned  snap_seq;          /* seq that snap was taken at        */
+
+/* Copy only the parts of src that are in use. */
+static void copy_used(ClipData *dst, const ClipData *src) {
+    int n = src->w * src->h;
+    dst->kind = src->kind;
+    dst->w    = src->w;
+    dst->h    = src->h;
+    dst->sprite_count = 0;
+    if (src->kind == CLIP_TILES && n > 0 && n <= CLIP_MAX_TILES) {
+        memcpy(dst->px, src->px, (size_t)n * sizeof(src->px[0]));
+        memcpy(dst->tile_pal, src->tile_pal, (size_t)n);
+    } else if (src->kind == CLIP_CELLS && n > 0 && n <= CLIP_MAX_CELLS) {
+        int sc = src->sprite_count;
+        if (sc < 0 || sc > COMPOSE_MAX_SPR) sc = 0;
+        memcpy(dst->cell_tile, src->cell_tile, (size_t)n * sizeof(src->cell_tile[0]));
+        memcpy(dst->cell_attr, src->cell_attr, (size_t)n);
+        memcpy(dst->sprites, src->sprites, (size_t)sc * sizeof(src->sprites[0]));
+        dst->sprite_count = sc;
+    } else {
+        dst->kind = CLIP_EMPTY;
+        dst->w = dst->h = 0;
+    }
+}
+
+static ClipShm *map_shared(void) {
+    char name[64];
+    snprintf(name, sizeof(name), "/chrmaker-clip-%u", (unsigned)getuid());
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (st.st_size < (off_t)sizeof(ClipShm) && ftruncate(fd, sizeof(ClipShm)) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, sizeof(ClipShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+
+    /* A fresh segment is all zeroes: take it.  One made by another
+       build with a different layout is left alone.                 */
+    ClipShm *m = p;
+    if (m->magic == 0) {
+        m->version = CLIP_VERSION;
+        m->size    = sizeof(ClipShm);
+        m->magic   = CLIP_MAGIC;
+    }
+    if (m->magic != CLIP_MAGIC || m->version != CLIP_VERSION || m->size != sizeof(ClipShm)) {
+        munmap(p, sizeof(ClipShm));
+        return NULL;
+    }
+    return m;
+}
+
+int clip_open(bool shared) {
+    snap = calloc(1, sizeof(*snap));
+    if (!snap) return -1;
+    shm = shared ? map_shared() : NULL;
+    if (shm) {
+        shm_mapped = true;
+    } else {
+        if (shared)
+            fprintf(stderr, "shared clipboard unavailable; copy/paste stays in this window\n");
+        shm = calloc(1, sizeof(*shm));
+        if (!shm) { free(snap); snap = NULL; return -1; }
+    }
+    snap_seq = 0;       /* anything already in the segment is picked up */
+    return 0;
+}
+
+void clip_close(void) {
+    if (shm_mapped) munmap(shm, sizeof(ClipShm));
+    else            free(shm);
+    free(snap);
+    shm  = NULL;
+    snap = NULL;
+    shm_mapped = false;
+}
+
+static unsigned put_seq;            /* seq claimed by clip_begin          */
+
+ClipData *clip_begin(void) {
+    if (!shm) return NULL;
+    /* Claim the segment by making seq odd.  A writer that died half
+       way leaves it odd for good; after CLIP_SPINS tries, take over. */
+    unsigned v = atomic_load(&shm->seq);
+    for (int spins = 0; ; spins++) {
+        if (v & 1) {
+            if (spins < CLIP_SPINS) { v = atomic_load(&shm->seq); continue; }
+            v++;                    /* treat as even; the CAS below claims it */
+            atomic_store(&shm->seq, v);
+        }
+        if (atomic_compare_exchange_weak(&shm->seq, &v, v + 1)) break;
+    }
+    put_seq = v + 2;
+    return &shm->data;
+}
+
+void clip_end(void) {
+    if (!shm) return;
+    copy_used(snap, &shm->data);    /* before anyone else can write */
+    snap_seq = put_seq;
+    atomic_store(&shm->seq, put_seq);
+}
+
+const ClipData *clip_get(void) {
+    if (!shm) return NULL;
+    for (int tries = 0; tries < CLIP_SPINS; tries++) {
+        unsigned v = atomic_load_explicit(&shm->seq, memory_order_acquire);
+        if (v == snap_seq) break;
+        if (v & 1) continue;
+        copy_used(snap, &shm->data);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shm->seq, memory_order_relaxed) == v) {
+            snap_seq = v;
+            break;
+        }
+    }
+    return snap;
+}
+
+size_t clip_mem(void) {
+    if (!snap) return 0;
+    return sizeof(ClipData) + sizeof(ClipShm);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "chr.h"
+#include "compose.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ── Shared clipboard ────────────────────────────────────────────
+   Tile copy/paste between running editors goes through one POSIX
+   shared-memory segment per user (/dev/shm/chrmaker-clip-UID).  It
+   holds either a rectangle of tiles with their sub-palettes, as laid
+   out on screen, or a rectangle of nametable cells with their
+   attribute palettes and the sprites whose origin lies inside it.
+
+   A sequence counter guards the segment: a copy makes it odd while it
+   writes and even again when done, and readers retry if it moved
+   under them.  clip_get only copies out of the segment when the
+   counter differs from the last one it saw, so checking for new
+   content is a single load.  If the segment can't be opened the
+   clipboard still works, private to this instance.               */
+
+typedef enum {
+    CLIP_EMPTY = 0,
+    CLIP_TILES,             /* w×h tiles: px + tile_pal, row-major  */
+    CLIP_CELLS,             /* w×h cells: cell_tile + cell_attr     */
+} ClipKind;
+
+#define CLIP_MAX_TILES CHR_MAX_TILES
+#define CLIP_MAX_CELLS (COMPOSE_NT_W * COMPOSE_NT_H)
+
+typedef struct {
+    uint8_t       kind;                 /* ClipKind                    */
+    uint16_t      w, h;                 /* in tiles or cells           */
+    uint8_t       px[CLIP_MAX_TILES][TILE_H][TILE_W];
+    uint8_t       tile_pal[CLIP_MAX_TILES];
+    uint16_t      cell_tile[CLIP_MAX_CELLS];
+    uint8_t       cell_attr[CLIP_MAX_CELLS];   /* palette 0-3 per cell */
+    /* Sprites with x/y relative to the rectangle's top-left pixel. */
+    ComposeSprite sprites[COMPOSE_MAX_SPR];
+    int           sprite_count;
+} ClipData;
+
+/* Map the shared segment, or fall back to a private buffer (with a
+   note on stderr).  With shared false the buffer is always private,
+   as replays need.  0, or -1 if not even that could be allocated;
+   the clipboard is then off (clip_get returns NULL).              */
+int  clip_open(bool shared);
+void clip_close(void);
+
+/* A copy: clip_begin claims the clipboard and returns it for filling
+   in place (NULL if the clipboard is off); clip_end publishes it.
+   Keep the two close together, other windows wait in between.  Only
+   the first w×h entries of each array need be set.                */
+ClipData *clip_begin(void);
+void      clip_end(void);
+
+/* The latest clipboard contents, refreshed from the segment if
+   another copy happened since the last call.  Never NULL after a
+   successful clip_open; kind is CLIP_EMPTY before the first copy. */
+const ClipData *clip_get(void);
+
+/* Bytes held by the local snapshot and the mapping. */
+size_t clip_mem(void);
@@ -0,0 +1,146 @@
+#include "compact.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ── Planning ────────────────────────────────────────────────── */
+
+/* Tile t is the first tile of some 16×16 sprite: one of its usage
+   nodes is a sprite's quadrant 0 whose quadrant 1 is also indexed. */
+static bool starts_group(const UsageIndex *u, int t) {
+    for (int n = usage_first(u, t); n != USAGE_NONE; n = usage_next(u, n)) {
+        int slot = n % USAGE_SLOTS;
+        if (slot >= USAGE_CELLS && (slot - USAGE_CELLS) % 4 == 0 &&
+            u->scene[n / USAGE_SLOTS]->tile[slot + 1] != USAGE_NO_TILE)
+            return true;
+    }
+    return false;
+}
+
+int compact_plan(const UsageIndex *u, uint16_t map[CHR_MAX_TILES]) {
+    bool group[CHR_MAX_TILES];
+    for (int t = 0; t < CHR_MAX_TILES; t++) group[t] = starts_group(u, t);
+
+    /* Units in tile order: runs of overlapping 16×16 groups, which
+       move as one block, and single used tiles.                   */
+    int16_t run_start[CHR_MAX_TILES], run_len[CHR_MAX_TILES];
+    int16_t single[CHR_MAX_TILES], spare[CHR_MAX_TILES];
+    int nruns = 0, nsingle = 0, nspare = 0;
+    for (int t = 0; t < CHR_MAX_TILES; ) {
+        if (t == 0 && !group[0]) { t++; continue; }   /* pinned below */
+        if (group[t]) {
+            int end = t + 4;
+            for (int k = t + 1; k < end && k < CHR_MAX_TILES; k++)
+                if (group[k] && k + 4 > end) end = k + 4;
+            if (end > CHR_MAX_TILES) end = CHR_MAX_TILES;
+            run_start[nruns] = (int16_t)t;
+            run_len[nruns++] = (int16_t)(end - t);
+            t = end;
+        } else {
+            if (u->count[t] > 0) single[nsingle++] = (int16_t)t;
+            else                 spare[nspare++] = (int16_t)t;
+            t++;
+        }
+    }
+
+    /* Runs first so they land on multiples of 4; a run whose length
+       isn't one (or pinned tile 0) is followed by single tiles to
+       realign the next, or by unused tiles once the singles run out. */
+    bool placed[CHR_MAX_TILES] = { false };
+    int  next = 0, si = 0, pi = 0;
+#define PUT(t) do { int t_ = (t); map[t_] = (uint16_t)next++; placed[t_] = true; } while (0)
+    if (!group[0]) PUT(0);      /* else the first run starts at 0 anyway */
+    for (int r = 0; r < nruns; r++) {
+        while (next % 4 && si < nsingle) PUT(single[si++]);
+        while (next % 4 && pi < nspare)  PUT(spare[pi++]);
+        for (int k = 0; k < run_len[r]; k++) PUT(run_start[r] + k);
+    }
+    while (si < nsingle) PUT(single[si++]);
+    int span = next;
+    for (int t = 0; t < CHR_MAX_TILES; t++)
+        if (!placed[t]) PUT(t);
+#undef PUT
+    return span;
+}
+
+bool compact_is_identity(const uint16_t map[CHR_MAX_TILES]) {
+    for (int t = 0; t < CHR_MAX_TILES; t++)
+        if (map[t] != t) return false;
+    return true;
+}
+
+void compact_invert(const uint16_t map[CHR_MAX_TILES],
+                    uint16_t inv[CHR_MAX_TILES]) {
+    for (int t = 0; t < CHR_MAX_TILES; t++) inv[map[t]] = (uint16_t)t;
+}
+
+/* ── Applying ────────────────────────────────────────────────── */
+
+/* In place, one permutation cycle at a time. */
+void compact_apply_chr(ChrPage *c, PaletteState *p,
+                       const uint16_t map[CHR_MAX_TILES]) {
+    bool done[CHR_MAX_TILES] = { false };
+    for (int t = 0; t < CHR_MAX_TILES; t++) {
+        if (done[t]) continue;
+        uint8_t px[TILE_H][TILE_W], tmp[TILE_H][TILE_W];
+        uint8_t pal = p->tile_pal[t];
+        memcpy(px, c->px[t], sizeof(px));
+        int j = t;
+        do {
+            int d = map[j];
+            memcpy(tmp, c->px[d], sizeof(tmp));
+            memcpy(c->px[d], px, sizeof(px));
+            memcpy(px, tmp, sizeof(px));
+            uint8_t tp = p->tile_pal[d];
+            p->tile_pal[d] = pal;
+            pal = tp;
+            done[j] = true;
+            j = d;
+        } while (j != t);
+    }
+}
+
+static bool remap_scene(ComposeScene *sc, const uint16_t map[CHR_MAX_TILES]) {
+    bool changed = false;
+    for (int y = 0; y < COMPOSE_NT_H; y++)
+        for (int x = 0; x < COMPOSE_NT_W; x++) {
+            uint16_t *v = &sc->nametable[y][x];
+            if (*v < CHR_MAX_TILES && map[*v] != *v) { *v = map[*v]; changed = true; }
+        }
+    for (int k = 0; k < sc->sprite_count; k++) {
+        uint16_t *v = &sc->sprites[k].tile;
+        if (*v < CHR_MAX_TILES && map[*v] != *v) { *v = map[*v]; changed = true; }
+    }
+    return changed;
+}
+
+/* Scene i references a tile that map moves. */
+static bool scene_moves(const UsageIndex *u, int i, const int16_t *moved, int n) {
+    for (int k = 0; k < n; k++)
+        if (usage_scene_refs(u, i, moved[k]) > 0) return true;
+    return false;
+}
+
+int compact_remap_scenes(ComposeData *d, const UsageIndex *u,
+                         const uint16_t map[CHR_MAX_TILES]) {
+    int16_t moved[CHR_MAX_TILES];
+    int nmoved = 0;
+    for (int t = 0; t < CHR_MAX_TILES; t++)
+        if (map[t] != t && u->count[t] > 0) moved[nmoved++] = (int16_t)t;
+    if (nmoved == 0) return 0;
+
+    ComposeScene *tmp = malloc(sizeof(*tmp));
+    if (!tmp) return -1;
+    int changed = 0;
+    for (int i = 0; i < d->scene_count; i++) {
+        if (!scene_moves(u, i, moved, nmoved)) continue;
+        const ComposeScene *sc = compose_peek(d, i, tmp);
+        if (!sc) continue;   /* unreadable chunk: usage_rebuild skips it too */
+        if (sc != tmp) *tmp = *sc;
+        if (remap_scene(tmp, map)) {
+            *compose_scene(d, i) = *tmp;
+            changed++;
+        }
+    }
+    free(tmp);
+    return changed;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include "chr.h"
+#include "compose.h"
+#include "usage.h"
+
+/* ── Unused-tile compaction ──────────────────────────────────────
+   A compaction is a permutation of all CHR_MAX_TILES tiles, given as
+   map[old] = new.  Tile 0, the blank that empty cells point at,
+   stays in slot 0.  Tiles referenced by any scene move to the front:
+   16×16 sprite groups (four consecutive tiles) first, contiguous and
+   each starting on a multiple of 4, with single used tiles filling
+   the gaps between them and then following; groups and singles each
+   keep their relative order.  Unused tiles come last, in order,
+   except those needed to pad a gap when no single is left for it.
+   Because nothing is dropped, applying the inverse map restores the
+   sheet exactly.                                                   */
+
+/* Fill map from the usage index.  Returns how many slots at the
+   front the used tiles now take: tile 0, which always counts, the
+   used tiles and any unused ones padding a gap between them.      */
+int  compact_plan(const UsageIndex *u, uint16_t map[CHR_MAX_TILES]);
+
+/* True if map moves no tile. */
+bool compact_is_identity(const uint16_t map[CHR_MAX_TILES]);
+
+void compact_invert(const uint16_t map[CHR_MAX_TILES],
+                    uint16_t inv[CHR_MAX_TILES]);
+
+/* Move pixel data and tile_pal entries along map. */
+void compact_apply_chr(ChrPage *c, PaletteState *p,
+                       const uint16_t map[CHR_MAX_TILES]);
+
+/* Rewrite nametable cells and sprite tiles in every scene.  u must
+   index the scenes as they are now: scenes it shows no moved
+   reference in are neither decoded nor dirtied, and unreadable
+   chunks (which usage_rebuild skips) are never visited.
+   Returns the number of scenes rewritten, or -1 if out of memory. */
+int  compact_remap_scenes(ComposeData *d, const UsageIndex *u,
+                          const uint16_t map[CHR_MAX_TILES]);
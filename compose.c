@@ -1,139 +1,450 @@
 #include "compose.h"
 #include <string.h>
-#include <stdio.h>
+#include <stdlib.h>
 
 void compose_init(ComposeData *d) {
     memset(d, 0, sizeof(ComposeData));
     d->scene_count  = 1;
     d->active_scene = 0;
+    d->scenes[0]    = calloc(1, sizeof(ComposeScene));
+}
+
+void compose_free(ComposeData *d) {
+    for (int i = 0; i < COMPOSE_MAX_SCENES; i++) {
+        free(d->scenes[i]);
+        d->scenes[i] = NULL;
+    }
+    if (d->src) { fclose(d->src); d->src = NULL; }
 }
 
 /* ── Scene file format (.scn) ────────────────────────────────────
-   Header:
-     "NSCN"       4 bytes (magic)
-     version      1 byte  (= 1)
-     scene_count  1 byte  (1-16)
-   Per scene:
-     nametable    960 bytes (32x30 tile indices)
+   v3 (written by compose_save):
+     "NSCN"        4 bytes (magic)
+     version       1 byte  (= 3)
+     flags         1 byte  (0)
+     scene_count   2 bytes LE (1-COMPOSE_MAX_SCENES)
+     active_scene  2 bytes LE
+     reserved      2 bytes
+     index         scene_count × 12 bytes:
+       offset u32 LE, stored size u32 LE, raw size u16 LE,
+       codec u8 (0 = raw, 1 = PackBits RLE), reserved u8
+     chunks        one per scene, at the indexed offsets; each
+                   decodes to a v2 scene record (below).
+
+   v1/v2 (read only):
+     "NSCN", version 1 byte, scene_count 1 byte (1-255), then
+     scene_count scene records back to back.
+
+   Scene record:
+     nametable    v1: 960 bytes (32x30 tile indices)
+                  v2: 1920 bytes (32x30 × uint16 LE)
      attributes   240 bytes (15x16 palette indices)
      sprite_count 1 byte
      sprites      sprite_count * 6 bytes each:
        x, y, tile_lo, tile_hi, palette, flags
-       flags: bit 0 = hflip, bit 1 = vflip, bit 2 = behind_bg
+       flags: bit 0 = hflip, bit 1 = vflip, bit 2 = behind_bg,
+              bit 3 = 16×16
    ─────────────────────────────────────────────────────────────── */
 
-int compose_save(const ComposeData *d, const char *path) {
-    FILE *f = fopen(path, "wb");
-    if (!f) return -1;
+#define SCN_HDR_SIZE    12
+#define SCN_INDEX_SIZE  12
+#define SCN_RAW_MAX     (COMPOSE_NT_H * COMPOSE_NT_W * 2 + 15 * 16 + 1 \
+                         + COMPOSE_MAX_SPR * 6)
+/* PackBits worst case: one header byte per 128 literals. */
+#define SCN_STORED_MAX  (SCN_RAW_MAX + SCN_RAW_MAX / 128 + 1)
+
+static void put16(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+}
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, v); put16(p + 2, v >> 16);
+}
+static uint32_t get16(const uint8_t *p) {
+    return p[0] | ((uint32_t)p[1] << 8);
+}
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | (get16(p + 2) << 16);
+}
+
+/* Serialise one scene as a v2 record.  Returns the byte count. */
+static size_t scene_encode(const ComposeScene *s, uint8_t *out) {
+    uint8_t *p = out;
+    for (int r = 0; r < COMPOSE_NT_H; r++)
+        for (int c = 0; c < COMPOSE_NT_W; c++, p += 2)
+            put16(p, s->nametable[r][c]);
 
-    /* Header — version 2: uint16_t nametable entries */
-    fwrite("NSCN", 1, 4, f);
-    uint8_t ver = 2;
-    fwrite(&ver, 1, 1, f);
-    uint8_t sc = (uint8_t)d->scene_count;
-    fwrite(&sc, 1, 1, f);
-
-    for (int i = 0; i < d->scene_count; i++) {
-        const ComposeScene *s = &d->scenes[i];
-
-        /* Nametable: 1920 bytes (32×30 × 2 bytes, little-endian) */
-        for (int r = 0; r < COMPOSE_NT_H; r++) {
-            for (int c = 0; c < COMPOSE_NT_W; c++) {
-                uint8_t lo = (uint8_t)(s->nametable[r][c] & 0xFF);
-                uint8_t hi = (uint8_t)((s->nametable[r][c] >> 8) & 0xFF);
-                fwrite(&lo, 1, 1, f);
-                fwrite(&hi, 1, 1, f);
-            }
+    memcpy(p, s->attr, 15 * 16);
+    p += 15 * 16;
+
+    *p++ = (uint8_t)s->sprite_count;
+    for (int j = 0; j < s->sprite_count; j++) {
+        const ComposeSprite *sp = &s->sprites[j];
+        p[0] = sp->x;
+        p[1] = sp->y;
+        put16(p + 2, sp->tile);
+        p[4] = sp->palette;
+        p[5] = (sp->hflip ? 1 : 0)
+             | (sp->vflip ? 2 : 0)
+             | (sp->behind_bg ? 4 : 0)
+             | (sp->s16 ? 8 : 0);
+        p += 6;
+    }
+    return (size_t)(p - out);
+}
+
+/* Parse one v1/v2 scene record from buf.
+   Returns the number of bytes consumed, or -1 if buf is too short. */
+static long scene_decode(const uint8_t *buf, size_t len, int ver, ComposeScene *s) {
+    const uint8_t *p   = buf;
+    const uint8_t *end = buf + len;
+    size_t nt_bytes = (size_t)COMPOSE_NT_H * COMPOSE_NT_W * (ver == 1 ? 1 : 2);
+
+    memset(s, 0, sizeof(*s));
+    if ((size_t)(end - p) < nt_bytes + 15 * 16 + 1) return -1;
+
+    for (int r = 0; r < COMPOSE_NT_H; r++) {
+        for (int c = 0; c < COMPOSE_NT_W; c++) {
+            if (ver == 1) { s->nametable[r][c] = *p; p += 1; }
+            else          { s->nametable[r][c] = (uint16_t)get16(p); p += 2; }
         }
+    }
+
+    memcpy(s->attr, p, 15 * 16);
+    p += 15 * 16;
+
+    int spr_cnt = *p++;
+    if ((size_t)(end - p) < (size_t)spr_cnt * 6) return -1;
+    /* Extra sprites beyond the limit are skipped, not loaded. */
+    s->sprite_count = (spr_cnt > COMPOSE_MAX_SPR) ? COMPOSE_MAX_SPR : spr_cnt;
+
+    for (int j = 0; j < spr_cnt; j++, p += 6) {
+        if (j >= COMPOSE_MAX_SPR) continue;
+        ComposeSprite *sp = &s->sprites[j];
+        sp->x         = p[0];
+        sp->y         = p[1];
+        sp->tile      = (uint16_t)get16(p + 2);
+        sp->palette   = p[4];
+        sp->hflip     = (p[5] & 1) != 0;
+        sp->vflip     = (p[5] & 2) != 0;
+        sp->behind_bg = (p[5] & 4) != 0;
+        sp->s16       = (p[5] & 8) != 0;
+    }
+    return (long)(p - buf);
+}
 
-        /* Attributes: 240 bytes */
-        fwrite(s->attr, 1, 15 * 16, f);
-
-        /* Sprites */
-        uint8_t spr_cnt = (uint8_t)s->sprite_count;
-        fwrite(&spr_cnt, 1, 1, f);
-
-        for (int j = 0; j < s->sprite_count; j++) {
-            const ComposeSprite *sp = &s->sprites[j];
-            uint8_t buf[6];
-            buf[0] = sp->x;
-            buf[1] = sp->y;
-            buf[2] = (uint8_t)(sp->tile & 0xFF);
-            buf[3] = (uint8_t)((sp->tile >> 8) & 0xFF);
-            buf[4] = sp->palette;
-            buf[5] = (sp->hflip ? 1 : 0)
-                    | (sp->vflip ? 2 : 0)
-                    | (sp->behind_bg ? 4 : 0)
-                    | (sp->s16 ? 8 : 0);
-            fwrite(buf, 1, 6, f);
+/* ── PackBits RLE (chunk codec 1) ────────────────────────────────
+   Header byte n: 0-127 → copy the next n+1 bytes literally;
+   129-255 → repeat the next byte 257-n times (2-128).            */
+static size_t packbits_encode(const uint8_t *src, size_t n, uint8_t *dst) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 128 && src[i + run] == src[i]) run++;
+        if (run >= 2) {
+            dst[o++] = (uint8_t)(257 - run);
+            dst[o++] = src[i];
+            i += run;
+            continue;
         }
+        /* Literal span: stop before the next run of 2+. */
+        size_t lit = 1;
+        while (i + lit < n && lit < 128 &&
+               !(i + lit + 1 < n && src[i + lit] == src[i + lit + 1]))
+            lit++;
+        dst[o++] = (uint8_t)(lit - 1);
+        memcpy(dst + o, src + i, lit);
+        o += lit;
+        i += lit;
     }
+    return o;
+}
 
-    fclose(f);
-    return 0;
+/* Returns decoded size, or -1 on malformed input / overflow. */
+static long packbits_decode(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        uint8_t h = src[i++];
+        if (h < 128) {
+            size_t lit = (size_t)h + 1;
+            if (i + lit > n || o + lit > cap) return -1;
+            memcpy(dst + o, src + i, lit);
+            i += lit; o += lit;
+        } else if (h > 128) {
+            size_t run = 257 - (size_t)h;
+            if (i >= n || o + run > cap) return -1;
+            memset(dst + o, src[i++], run);
+            o += run;
+        }
+    }
+    return (long)o;
 }
 
-int compose_load(ComposeData *d, const char *path) {
-    FILE *f = fopen(path, "rb");
-    if (!f) return -1;
+/* ── Lazy scene access ────────────────────────────────────────── */
 
-    char magic[4];
-    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, "NSCN", 4) != 0) {
-        fclose(f); return -1;
+/* Decode chunk i from the source file into *out. */
+static int chunk_read(const ComposeData *d, int i, ComposeScene *out) {
+    const ComposeChunk *c = &d->chunk[i];
+    if (!d->src || c->size == 0) return -1;
+
+    uint8_t stored[SCN_STORED_MAX], raw[SCN_RAW_MAX];
+    if (fseek(d->src, (long)c->offset, SEEK_SET) != 0) return -1;
+    if (fread(stored, 1, c->size, d->src) != c->size) return -1;
+
+    const uint8_t *rec = stored;
+    size_t         len = c->size;
+    if (c->codec == SCN_CODEC_RLE) {
+        long n = packbits_decode(stored, c->size, raw, sizeof(raw));
+        if (n != c->raw_size) return -1;
+        rec = raw;
+        len = (size_t)n;
     }
+    return scene_decode(rec, len, 2, out) < 0 ? -1 : 0;
+}
 
-    uint8_t ver, sc;
-    if (fread(&ver, 1, 1, f) != 1 || (ver != 1 && ver != 2)) { fclose(f); return -1; }
-    if (fread(&sc, 1, 1, f) != 1 || sc < 1 || sc > COMPOSE_MAX_SCENES) {
-        fclose(f); return -1;
+/* Make scene i resident.  Returns false if it could not be allocated. */
+static bool scene_materialise(ComposeData *d, int i) {
+    if (d->scenes[i]) return true;
+    ComposeScene *s = malloc(sizeof(ComposeScene));
+    if (!s) return false;
+    if (chunk_read(d, i, s) != 0)
+        memset(s, 0, sizeof(*s));   /* never-saved or unreadable → blank */
+    d->scenes[i] = s;
+    return true;
+}
+
+ComposeScene *compose_scene(ComposeData *d, int i) {
+    static ComposeScene scratch;   /* out-of-memory fallback */
+    if (i < 0 || i >= d->scene_count || !scene_materialise(d, i)) {
+        memset(&scratch, 0, sizeof(scratch));
+        return &scratch;
     }
+    d->dirty[i] = true;
+    return d->scenes[i];
+}
 
-    compose_init(d);
-    d->scene_count = sc;
+const ComposeScene *compose_view(ComposeData *d, int i) {
+    if (i < 0 || i >= d->scene_count) return NULL;
+    if (!d->scenes[i]) {
+        ComposeScene *s = malloc(sizeof(ComposeScene));
+        if (!s) return NULL;
+        if (d->chunk[i].size == 0)           memset(s, 0, sizeof(*s));
+        else if (chunk_read(d, i, s) != 0) { free(s); return NULL; }
+        d->scenes[i] = s;
+    }
+    return d->scenes[i];
+}
 
-    for (int i = 0; i < sc; i++) {
-        ComposeScene *s = &d->scenes[i];
-
-        if (ver == 1) {
-            /* v1: 1 byte per nametable entry */
-            uint8_t nt8[COMPOSE_NT_H * COMPOSE_NT_W];
-            if (fread(nt8, 1, sizeof(nt8), f) != sizeof(nt8)) { fclose(f); return -1; }
-            for (int r = 0; r < COMPOSE_NT_H; r++)
-                for (int c = 0; c < COMPOSE_NT_W; c++)
-                    s->nametable[r][c] = nt8[r * COMPOSE_NT_W + c];
+const ComposeScene *compose_peek(const ComposeData *d, int i, ComposeScene *tmp) {
+    if (i < 0 || i >= d->scene_count) return NULL;
+    if (d->scenes[i]) return d->scenes[i];
+    if (d->chunk[i].size == 0) { memset(tmp, 0, sizeof(*tmp)); return tmp; }
+    return chunk_read(d, i, tmp) == 0 ? tmp : NULL;
+}
+
+const ComposeScene *compose_active(const ComposeData *d) {
+    static const ComposeScene blank;
+    const ComposeScene *s = d->scenes[d->active_scene];
+    return s ? s : &blank;
+}
+
+void compose_set_active(ComposeData *d, int i) {
+    if (i < 0) i = 0;
+    if (i >= d->scene_count) i = d->scene_count - 1;
+    d->active_scene = i;
+
+    for (int j = i - 1; j <= i + 1; j++)
+        if (j >= 0 && j < d->scene_count) scene_materialise(d, j);
+
+    /* Evict far-away scenes that can be re-read unchanged. */
+    for (int j = 0; j < d->scene_count; j++) {
+        if (j >= i - 1 && j <= i + 1) continue;
+        if (d->scenes[j] && !d->dirty[j] && d->src && d->chunk[j].size > 0) {
+            free(d->scenes[j]);
+            d->scenes[j] = NULL;
+        }
+    }
+}
+
+int compose_add_scene(ComposeData *d) {
+    if (d->scene_count >= COMPOSE_MAX_SCENES) return -1;
+    int idx = d->scene_count++;
+    memset(&d->chunk[idx], 0, sizeof(d->chunk[idx]));
+    free(d->scenes[idx]);
+    d->scenes[idx] = calloc(1, sizeof(ComposeScene));
+    d->dirty[idx]  = true;
+    compose_set_active(d, idx);
+    return idx;
+}
+
+/* ── Save ─────────────────────────────────────────────────────── */
+
+int compose_save(ComposeData *d, const char *path) {
+    char tmp_path[300];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    int n = d->scene_count;
+    size_t hdr_len = SCN_HDR_SIZE + (size_t)n * SCN_INDEX_SIZE;
+    uint8_t      *hdr = calloc(1, hdr_len);
+    ComposeChunk *out = calloc((size_t)n, sizeof(ComposeChunk));
+    FILE         *f   = fopen(tmp_path, "wb");
+    if (!hdr || !out || !f) goto fail;
+
+    memcpy(hdr, "NSCN", 4);
+    hdr[4] = 3;
+    put16(hdr + 6, (uint32_t)n);
+    put16(hdr + 8, (uint32_t)d->active_scene);
+    if (fwrite(hdr, 1, hdr_len, f) != hdr_len) goto fail;
+
+    uint32_t pos = (uint32_t)hdr_len;
+    uint8_t  raw[SCN_RAW_MAX], stored[SCN_STORED_MAX];
+    for (int i = 0; i < n; i++) {
+        ComposeChunk *c = &out[i];
+        const uint8_t *data;
+
+        if (!d->scenes[i] && d->src && d->chunk[i].size > 0) {
+            /* Untouched and not resident: copy the stored chunk as-is. */
+            *c = d->chunk[i];
+            if (fseek(d->src, (long)c->offset, SEEK_SET) != 0 ||
+                fread(stored, 1, c->size, d->src) != c->size) goto fail;
+            data = stored;
         } else {
-            /* v2: 2 bytes per nametable entry (little-endian) */
-            for (int r = 0; r < COMPOSE_NT_H; r++) {
-                for (int c = 0; c < COMPOSE_NT_W; c++) {
-                    uint8_t pair[2];
-                    if (fread(pair, 1, 2, f) != 2) { fclose(f); return -1; }
-                    s->nametable[r][c] = pair[0] | ((uint16_t)pair[1] << 8);
-                }
-            }
+            static const ComposeScene blank;
+            const ComposeScene *sc = d->scenes[i] ? d->scenes[i] : &blank;
+            size_t rn = scene_encode(sc, raw);
+            size_t pn = packbits_encode(raw, rn, stored);
+            c->raw_size = (uint16_t)rn;
+            if (pn < rn) { c->codec = SCN_CODEC_RLE; c->size = (uint32_t)pn; data = stored; }
+            else         { c->codec = SCN_CODEC_RAW; c->size = (uint32_t)rn; data = raw;    }
         }
 
-        if (fread(s->attr, 1, 15 * 16, f) != 15 * 16) { fclose(f); return -1; }
-
-        uint8_t spr_cnt;
-        if (fread(&spr_cnt, 1, 1, f) != 1) { fclose(f); return -1; }
-        if (spr_cnt > COMPOSE_MAX_SPR) spr_cnt = COMPOSE_MAX_SPR;
-        s->sprite_count = spr_cnt;
-
-        for (int j = 0; j < spr_cnt; j++) {
-            uint8_t buf[6];
-            if (fread(buf, 1, 6, f) != 6) { fclose(f); return -1; }
-            ComposeSprite *sp = &s->sprites[j];
-            sp->x         = buf[0];
-            sp->y         = buf[1];
-            sp->tile      = buf[2] | ((uint16_t)buf[3] << 8);
-            sp->palette   = buf[4];
-            sp->hflip     = (buf[5] & 1) != 0;
-            sp->vflip     = (buf[5] & 2) != 0;
-            sp->behind_bg = (buf[5] & 4) != 0;
-            sp->s16       = (buf[5] & 8) != 0;
+        c->offset = pos;
+        if (fwrite(data, 1, c->size, f) != c->size) goto fail;
+        pos += c->size;
+
+        uint8_t *e = hdr + SCN_HDR_SIZE + (size_t)i * SCN_INDEX_SIZE;
+        put32(e,     c->offset);
+        put32(e + 4, c->size);
+        put16(e + 8, c->raw_size);
+        e[10] = c->codec;
+    }
+
+    if (fseek(f, 0, SEEK_SET) != 0 ||
+        fwrite(hdr, 1, hdr_len, f) != hdr_len) goto fail;
+    int closed = fclose(f);
+    f = NULL;
+    if (closed != 0 || rename(tmp_path, path) != 0) goto fail;
+
+    /* Re-point lazy loading at the new file.  If it can't be opened the
+       old handle (still valid on the replaced inode) keeps working.   */
+    FILE *nf = fopen(path, "rb");
+    if (nf) {
+        if (d->src) fclose(d->src);
+        d->src = nf;
+        memcpy(d->chunk, out, (size_t)n * sizeof(ComposeChunk));
+        memset(d->dirty, 0, sizeof(d->dirty));
+    }
+    free(out);
+    free(hdr);
+    return 0;
+
+fail:
+    if (f) { fclose(f); remove(tmp_path); }
+    free(out);
+    free(hdr);
+    return -1;
+}
+
+/* ── Load ─────────────────────────────────────────────────────── */
+
+/* v1/v2: small files holding every scene inline — parsed from one
+   buffered read, all scenes resident.                             */
+static int load_inline(ComposeData *nd, FILE *f, int ver) {
+    if (fseek(f, 0, SEEK_END) != 0) return -1;
+    long sz = ftell(f);
+    if (sz < 6 || fseek(f, 0, SEEK_SET) != 0) return -1;
+
+    uint8_t *buf = malloc((size_t)sz);
+    if (!buf) return -1;
+    if (fread(buf, 1, (size_t)sz, f) != (size_t)sz) { free(buf); return -1; }
+
+    int sc = buf[5];
+    if (sc < 1) { free(buf); return -1; }
+    nd->scene_count = sc;
+
+    size_t pos = 6;
+    for (int i = 0; i < sc; i++) {
+        nd->scenes[i] = malloc(sizeof(ComposeScene));
+        if (!nd->scenes[i]) { free(buf); return -1; }
+        long used = scene_decode(buf + pos, (size_t)sz - pos, ver, nd->scenes[i]);
+        if (used < 0) { free(buf); return -1; }
+        pos += (size_t)used;
+        nd->dirty[i] = true;
+    }
+    free(buf);
+    return 0;
+}
+
+/* v3: read header + index only; scenes stream in on demand. */
+static int load_indexed(ComposeData *nd, FILE *f) {
+    uint8_t hdr[SCN_HDR_SIZE];
+    if (fseek(f, 0, SEEK_END) != 0) return -1;
+    long fsz = ftell(f);
+    if (fseek(f, 0, SEEK_SET) != 0 ||
+        fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) return -1;
+
+    int n = (int)get16(hdr + 6);
+    if (n < 1 || n > COMPOSE_MAX_SCENES) return -1;
+
+    size_t   idx_len = (size_t)n * SCN_INDEX_SIZE;
+    uint8_t *idx     = malloc(idx_len);
+    if (!idx) return -1;
+    if (fread(idx, 1, idx_len, f) != idx_len) { free(idx); return -1; }
+
+    for (int i = 0; i < n; i++) {
+        const uint8_t *e = idx + (size_t)i * SCN_INDEX_SIZE;
+        ComposeChunk  *c = &nd->chunk[i];
+        c->offset   = get32(e);
+        c->size     = get32(e + 4);
+        c->raw_size = (uint16_t)get16(e + 8);
+        c->codec    = e[10];
+        if (c->size == 0 || c->size > SCN_STORED_MAX ||
+            c->raw_size > SCN_RAW_MAX || c->codec > SCN_CODEC_RLE ||
+            (uint64_t)c->offset + c->size > (uint64_t)fsz) {
+            free(idx); return -1;
         }
     }
+    free(idx);
+
+    nd->scene_count = n;
+    nd->src         = f;
+    compose_set_active(nd, (int)get16(hdr + 8));
+    if (!nd->scenes[nd->active_scene]) { nd->src = NULL; return -1; }
+    return 0;
+}
+
+int compose_load(ComposeData *d, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    uint8_t head[5];
+    if (fread(head, 1, 5, f) != 5 || memcmp(head, "NSCN", 4) != 0 ||
+        head[4] < 1 || head[4] > 3) {
+        fclose(f); return -1;
+    }
+
+    ComposeData *nd = calloc(1, sizeof(ComposeData));
+    if (!nd) { fclose(f); return -1; }
+
+    int rc = (head[4] == 3) ? load_indexed(nd, f) : load_inline(nd, f, head[4]);
+    if (rc != 0 || nd->src != f) fclose(f);   /* v3 keeps f open as nd->src */
+    if (rc != 0) {
+        compose_free(nd);
+        free(nd);
+        return -1;
+    }
 
-    fclose(f);
+    compose_free(d);
+    *d = *nd;
+    free(nd);
     return 0;
 }
@@ -1,12 +1,13 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 /* ── NES screen constants ────────────────────────────────────── */
 #define COMPOSE_NT_W       32   /* nametable width in tiles  */
 #define COMPOSE_NT_H       30   /* nametable height in tiles */
 #define COMPOSE_MAX_SPR    64   /* max sprites per scene     */
-#define COMPOSE_MAX_SCENES 16
+#define COMPOSE_MAX_SCENES 1024 /* v1/v2 files hold at most 255 */
 
 /* ── Sprite entry ────────────────────────────────────────────── */
 typedef struct {
@@ -26,14 +27,68 @@ typedef struct {
     int           sprite_count;
 } ComposeScene;
 
-/* ── Multi-scene container ───────────────────────────────────── */
+/* ── Scene chunk in a v3 file (see compose.c for the layout) ─── */
 typedef struct {
-    ComposeScene  scenes[COMPOSE_MAX_SCENES];
+    uint32_t offset;        /* byte offset of the stored chunk  */
+    uint32_t size;          /* stored bytes (0 = no chunk)      */
+    uint16_t raw_size;      /* bytes after decoding             */
+    uint8_t  codec;         /* SCN_CODEC_*                      */
+} ComposeChunk;
+
+#define SCN_CODEC_RAW  0
+#define SCN_CODEC_RLE  1    /* PackBits */
+
+/* ── Multi-scene container ───────────────────────────────────────
+   Scenes are heap-allocated on first use.  After loading a v3 file
+   only the active scene and its neighbours are resident; the rest
+   are decoded from the still-open source file on demand.  A scene
+   that has been handed out for writing is marked dirty and is never
+   evicted until the next save.                                   */
+typedef struct {
+    ComposeScene *scenes[COMPOSE_MAX_SCENES];  /* NULL = not resident */
     int           scene_count;    /* >= 1 */
     int           active_scene;
+
+    FILE         *src;            /* v3 file backing non-resident scenes */
+    ComposeChunk  chunk[COMPOSE_MAX_SCENES];
+    bool          dirty[COMPOSE_MAX_SCENES];
 } ComposeData;
 
 /* ── Functions ───────────────────────────────────────────────── */
+
+/* compose_init expects uninitialised (or freed) memory; compose_free
+   releases every resident scene and the source file.              */
 void compose_init(ComposeData *d);
-int  compose_save(const ComposeData *d, const char *path);
+void compose_free(ComposeData *d);
+
+/* Scene i for editing: loads it if needed and marks it dirty.
+   Never returns NULL for 0 <= i < scene_count (falls back to a blank
+   scene if the source chunk is unreadable).                        */
+ComposeScene *compose_scene(ComposeData *d, int i);
+
+/* Scene i for reading: made resident but left clean, so the next
+   compose_set_active may evict it again.  NULL if it can't be read. */
+const ComposeScene *compose_view(ComposeData *d, int i);
+
+/* Read-only access without side effects.  Returns the resident copy,
+   or decodes scene i into *tmp and returns tmp.  NULL on error.    */
+const ComposeScene *compose_peek(const ComposeData *d, int i, ComposeScene *tmp);
+
+/* Active scene for drawing.  compose_set_active keeps it resident;
+   returns a blank scene if that invariant is ever broken.          */
+const ComposeScene *compose_active(const ComposeData *d);
+
+/* Switch scenes: materialises i-1..i+1 and evicts clean scenes that
+   can be re-read from the source file.                             */
+void compose_set_active(ComposeData *d, int i);
+
+/* Append a blank scene and make it active.  Returns its index, or -1
+   when COMPOSE_MAX_SCENES is reached.                              */
+int  compose_add_scene(ComposeData *d);
+
+/* Save always writes v3 (via a temp file + rename, so chunks of
+   non-resident scenes can be copied straight from the old file).
+   Load reads v1, v2 and v3; on failure *d is left untouched.
+   Both return 0 on success, -1 on error.                           */
+int  compose_save(ComposeData *d, const char *path);
 int  compose_load(ComposeData *d, const char *path);
@@ -0,0 +1,157 @@
+#include "compress.h"
+#include <string.h>
+
+const char *codec_name(Codec c) {
+    switch (c) {
+        case CODEC_RLE:  return "RLE";
+        case CODEC_LZSS: return "LZ";
+        default:         return "?";
+    }
+}
+
+size_t codec_bound(size_t n) {
+    return CODEC_BOUND(n);
+}
+
+/* ── RLE ──────────────────────────────────────────────────────── */
+
+static long rle_compress(const uint8_t *src, size_t n, uint8_t *dst) {
+    size_t hist[256] = {0};
+    for (size_t i = 0; i < n; i++) hist[src[i]]++;
+    int tag = -1;
+    for (int v = 0; v < 256 && tag < 0; v++)
+        if (hist[v] == 0) tag = v;
+    if (tag < 0) return -1;
+
+    size_t o = 0;
+    dst[o++] = (uint8_t)tag;
+    for (size_t i = 0; i < n; ) {
+        uint8_t b   = src[i];
+        size_t  run = 1;
+        while (i + run < n && run < 256 && src[i + run] == b) run++;
+        i += run;
+
+        dst[o++] = b;
+        size_t rest = run - 1;
+        if (rest >= 2) {            /* "tag n" beats repeating the byte */
+            dst[o++] = (uint8_t)tag;
+            dst[o++] = (uint8_t)rest;
+        } else if (rest == 1) {
+            dst[o++] = b;
+        }
+    }
+    dst[o++] = (uint8_t)tag;
+    dst[o++] = 0;
+    return (long)o;
+}
+
+static long rle_decompress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    if (n < 1) return -1;
+    uint8_t tag  = src[0];
+    uint8_t prev = 0;
+    size_t  o    = 0;
+    for (size_t i = 1; i < n; ) {
+        uint8_t b = src[i++];
+        if (b != tag) {
+            if (o >= cap) return -1;
+            dst[o++] = prev = b;
+            continue;
+        }
+        if (i >= n) return -1;
+        uint8_t cnt = src[i++];
+        if (cnt == 0) return (long)o;
+        if (o == 0 || o + cnt > cap) return -1;
+        memset(dst + o, prev, cnt);
+        o += cnt;
+    }
+    return -1;   /* missing end marker */
+}
+
+/* ── LZSS ─────────────────────────────────────────────────────── */
+
+#define LZ_WINDOW   256
+#define LZ_MIN_LEN    3
+#define LZ_MAX_LEN  (LZ_MIN_LEN + 254)
+
+static long lzss_compress(const uint8_t *src, size_t n, uint8_t *dst) {
+    size_t o    = 0;
+    size_t flag = 0;    /* position of the current flag byte */
+    int    bit  = 8;    /* items written under it            */
+
+    for (size_t i = 0; i <= n; ) {
+        if (bit == 8) { flag = o++; dst[flag] = 0; bit = 0; }
+
+        if (i == n) {   /* end marker: a match with length byte $FF */
+            dst[o++] = 0xFF;
+            dst[o++] = 0;
+            break;
+        }
+
+        /* Greedy longest match in the last LZ_WINDOW bytes. */
+        size_t best_len = 0, best_dist = 0;
+        size_t lo = (i > LZ_WINDOW) ? i - LZ_WINDOW : 0;
+        size_t max = n - i;
+        if (max > LZ_MAX_LEN) max = LZ_MAX_LEN;
+        for (size_t j = lo; j < i; j++) {
+            size_t len = 0;
+            while (len < max && src[j + len] == src[i + len]) len++;
+            if (len > best_len) {
+                best_len = len; best_dist = i - j;
+                if (len == max) break;
+            }
+        }
+
+        if (best_len >= LZ_MIN_LEN) {
+            dst[o++] = (uint8_t)(best_len - LZ_MIN_LEN);
+            dst[o++] = (uint8_t)(best_dist - 1);
+            i += best_len;
+        } else {
+            dst[flag] |= (uint8_t)(1u << bit);
+            dst[o++] = src[i++];
+        }
+        bit++;
+    }
+    return (long)o;
+}
+
+static long lzss_decompress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        uint8_t flags = src[i++];
+        for (int bit = 0; bit < 8; bit++) {
+            if (flags & (1u << bit)) {
+                if (i >= n || o >= cap) return -1;
+                dst[o++] = src[i++];
+                continue;
+            }
+            if (i + 2 > n) return -1;
+            uint8_t lb = src[i++];
+            size_t  dist = (size_t)src[i++] + 1;
+            if (lb == 0xFF) return (long)o;
+            size_t len = (size_t)lb + LZ_MIN_LEN;
+            if (dist > o || o + len > cap) return -1;
+            for (size_t k = 0; k < len; k++, o++)   /* may overlap */
+                dst[o] = dst[o - dist];
+        }
+    }
+    return -1;   /* missing end marker */
+}
+
+/* ── Dispatch ─────────────────────────────────────────────────── */
+
+long codec_compress(Codec c, const uint8_t *src, size_t n, uint8_t *dst) {
+    switch (c) {
+        case CODEC_RLE:  return rle_compress(src, n, dst);
+        case CODEC_LZSS: return lzss_compress(src, n, dst);
+        default:         return -1;
+    }
+}
+
+long codec_decompress(Codec c, const uint8_t *src, size_t n,
+                      uint8_t *dst, size_t cap) {
+    switch (c) {
+        case CODEC_RLE:  return rle_decompress(src, n, dst, cap);
+        case CODEC_LZSS: return lzss_decompress(src, n, dst, cap);
+        default:         return -1;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ── NES-friendly byte codecs ────────────────────────────────────
+   Both formats decode with a few dozen bytes of 6502 code and need
+   no RAM beyond the output buffer (LZSS reads back from it).
+
+   CODEC_RLE   NES Screen Tool / neslib vram_unrle format:
+               tag byte (a value absent from the data), then data;
+               "tag n" repeats the previous byte n times (n >= 1),
+               "tag 0" ends the stream.
+   CODEC_LZSS  flag byte per 8 items, LSB first: 1 = literal byte,
+               0 = match: [len-3 (0-254)] [distance-1 (0-255)],
+               copied from the bytes already output.  A match whose
+               length byte is $FF ends the stream.                 */
+typedef enum {
+    CODEC_RLE,
+    CODEC_LZSS,
+    CODEC_COUNT
+} Codec;
+
+/* Short upper-case label for status text, e.g. "RLE". */
+const char *codec_name(Codec c);
+
+/* Worst-case compressed size for n input bytes (any codec).
+   RLE: tag + every byte + end pair.  LZSS: one flag byte per 8
+   literals + end marker.  Both fit in n + n/8 + 4.               */
+#define CODEC_BOUND(n) ((n) + (n) / 8 + 4)
+size_t codec_bound(size_t n);
+
+/* Compress n bytes into dst (at least codec_bound(n) bytes).
+   Returns the compressed size, or -1 if the input cannot be
+   represented (RLE when all 256 byte values occur).          */
+long codec_compress(Codec c, const uint8_t *src, size_t n, uint8_t *dst);
+
+/* Decompress into dst (cap bytes).  Returns the decoded size, or -1
+   on malformed input or overflow.                                  */
+long codec_decompress(Codec c, const uint8_t *src, size_t n,
+                      uint8_t *dst, size_t cap);
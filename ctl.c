@@ -0,0 +1,608 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ctl.h"
+#include "input.h"
+#include "export.h"
+#include "trace.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define CTL_MAX_CLIENTS 8
+#define CTL_MAX_WORDS   8
+#define CTL_LINE_MAX    (64 * 1024)         /* longest request           */
+#define CTL_OUT_MAX     (4 * 1024 * 1024)   /* unread output before a client is dropped */
+#define CTL_EV_TILES    256                 /* tiles listed in one ev line */
+
+typedef struct {
+    int     fd;             /* -1 = free slot                        */
+    char   *in;
+    size_t  in_len, in_cap;
+    char   *out;
+    size_t  out_len, out_cap, out_off;
+    bool    subscribed;
+    bool    waiting;        /* save/load queued; ctl_result replies  */
+    bool    eof;            /* peer closed its end                   */
+    bool    broken;         /* drop at the end of this poll          */
+} CtlClient;
+
+static int       listen_fd = -1;
+static char      sock_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static CtlClient clients[CTL_MAX_CLIENTS];
+static bool      seen_valid;
+static uint32_t  seen_chr_rev, seen_edit_rev;
+
+/* Monotonic: a wall-clock step must not stretch or skip a budget. */
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* ── Output ──────────────────────────────────────────────────── */
+
+static bool out_reserve(CtlClient *c, size_t n) {
+    if (c->out_off == c->out_len) c->out_off = c->out_len = 0;
+    if (c->out_len + n <= c->out_cap) return true;
+    if (c->out_len - c->out_off + n > CTL_OUT_MAX) {
+        c->broken = true;           /* not reading its replies */
+        return false;
+    }
+    size_t cap = c->out_cap ? c->out_cap : 4096;
+    while (cap < c->out_len + n) cap *= 2;
+    char *p = realloc(c->out, cap);
+    if (!p) { c->broken = true; return false; }
+    c->out     = p;
+    c->out_cap = cap;
+    return true;
+}
+
+static void out_printf(CtlClient *c, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || !out_reserve(c, (size_t)n + 1)) return;
+    va_start(ap, fmt);
+    vsnprintf(c->out + c->out_len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    c->out_len += (size_t)n;
+}
+
+static void out_hex(CtlClient *c, const uint8_t *b, size_t n) {
+    static const char HEX[] = "0123456789abcdef";
+    if (!out_reserve(c, 2 * n)) return;
+    for (size_t i = 0; i < n; i++) {
+        c->out[c->out_len++] = HEX[b[i] >> 4];
+        c->out[c->out_len++] = HEX[b[i] & 15];
+    }
+}
+
+static int err(CtlClient *c, const char *fmt, ...) {
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    out_printf(c, "err %s\n", msg);
+    return -1;
+}
+
+static void flush(CtlClient *c) {
+    while (c->out_off < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) { c->out_off += (size_t)n; continue; }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n < 0 && errno == EINTR) continue;
+        c->broken = true;
+        return;
+    }
+}
+
+/* ── Parsing ─────────────────────────────────────────────────── */
+
+static int parse_int(const char *w, int lo, int hi, int *out) {
+    char *end;
+    long v = strtol(w, &end, 10);
+    if (*w == '\0' || *end != '\0' || v < lo || v > hi) return -1;
+    *out = (int)v;
+    return 0;
+}
+
+static int hex_digit(int ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    ch = tolower(ch);
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    return -1;
+}
+
+/* Hex digits to bytes: the byte count, or -1 if w isn't whole bytes
+   of hex or holds more than max.                                  */
+static int unhex(const char *w, uint8_t *out, int max) {
+    int n = 0;
+    for (; w[0]; w += 2) {
+        int hi = hex_digit((unsigned char)w[0]);
+        int lo = w[1] ? hex_digit((unsigned char)w[1]) : -1;
+        if (hi < 0 || lo < 0 || n == max) return -1;
+        out[n++] = (uint8_t)(hi << 4 | lo);
+    }
+    return n;
+}
+
+static int sheet_tiles(const EditorState *s) {
+    int n = s->chr_cols * s->chr_rows;
+    return n < CHR_MAX_TILES ? n : CHR_MAX_TILES;
+}
+
+/* ── Commands ────────────────────────────────────────────────── */
+
+typedef struct {
+    const char *name;
+    int         min, max;       /* argument count */
+    int       (*run)(CtlClient *c, EditorState *s, int argc, char **argv);
+    bool        writes;         /* changes the document: undo checkpoint */
+    bool        file_op;        /* reply comes from ctl_result           */
+    const char *usage;
+} CtlCmd;
+
+static uint8_t scratch[CTL_LINE_MAX / 2];
+
+static int cmd_info(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)argc; (void)argv;
+    out_printf(c, "ok %d %d %d %d %s\n", s->chr_cols, s->chr_rows,
+               s->compose.scene_count, s->compose.active_scene, s->current_path);
+    return 0;
+}
+
+static int cmd_get_tiles(CtlClient *c, EditorState *s, int argc, char **argv) {
+    int first, count = 1, n = sheet_tiles(s);
+    if (parse_int(argv[1], 0, n - 1, &first) != 0)
+        return err(c, "tile out of range: %s", argv[1]);
+    if (argc > 2 && parse_int(argv[2], 1, n - first, &count) != 0)
+        return err(c, "bad count: %s", argv[2]);
+    out_printf(c, "ok %d %d ", first, count);
+    for (int t = first; t < first + count; t++) {
+        uint8_t b[16];
+        export_encode_tile(s->chr.px[t], b);
+        out_hex(c, b, 16);
+    }
+    out_printf(c, "\n");
+    return 0;
+}
+
+static int cmd_set_tiles(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)argc;
+    int first, n = sheet_tiles(s);
+    if (parse_int(argv[1], 0, n - 1, &first) != 0)
+        return err(c, "tile out of range: %s", argv[1]);
+    int bytes = unhex(argv[2], scratch, (n - first) * 16);
+    if (bytes <= 0 || bytes % 16)
+        return err(c, "need whole tiles of hex, at most %d", n - first);
+    for (int k = 0; k < bytes / 16; k++) {
+        uint8_t px[TILE_H][TILE_W];
+        export_decode_tile(scratch + 16 * k, px);
+        if (memcmp(px, s->chr.px[first + k], sizeof(px)) == 0) continue;
+        memcpy(s->chr.px[first + k], px, sizeof(px));
+        input_mark_tile(s, first + k);
+    }
+    out_printf(c, "ok %d\n", bytes / 16);
+    return 0;
+}
+
+static int cmd_get_pal(CtlClient *c, EditorState *s, int argc, char **argv) {
+    int first = 0, count = PAL_COUNT;
+    if (argc > 1) {
+        count = 1;
+        if (parse_int(argv[1], 0, PAL_COUNT - 1, &first) != 0)
+            return err(c, "palette out of range: %s", argv[1]);
+    }
+    if (argc > 2 && parse_int(argv[2], 1, PAL_COUNT - first, &count) != 0)
+        return err(c, "bad count: %s", argv[2]);
+    out_printf(c, "ok %d %d ", first, count);
+    out_hex(c, s->pal.sub[first].idx, (size_t)count * 4);
+    out_printf(c, "\n");
+    return 0;
+}
+
+static int cmd_set_pal(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)argc;
+    int first;
+    if (parse_int(argv[1], 0, PAL_COUNT - 1, &first) != 0)
+        return err(c, "palette out of range: %s", argv[1]);
+    int bytes = unhex(argv[2], scratch, (PAL_COUNT - first) * 4);
+    if (bytes <= 0 || bytes % 4)
+        return err(c, "need 8 hex digits per palette, at most %d", PAL_COUNT - first);
+    for (int i = 0; i < bytes; i++)
+        if (scratch[i] > 0x3F) return err(c, "colour %02x is not a NES colour", scratch[i]);
+    memcpy(s->pal.sub[first].idx, scratch, (size_t)bytes);
+    s->edit_rev++;
+    out_printf(c, "ok %d\n", bytes / 4);
+    return 0;
+}
+
+static int cmd_get_tile_pal(CtlClient *c, EditorState *s, int argc, char **argv) {
+    int first, count = 1, n = sheet_tiles(s);
+    if (parse_int(argv[1], 0, n - 1, &first) != 0)
+        return err(c, "tile out of range: %s", argv[1]);
+    if (argc > 2 && parse_int(argv[2], 1, n - first, &count) != 0)
+        return err(c, "bad count: %s", argv[2]);
+    out_printf(c, "ok %d %d ", first, count);
+    out_hex(c, &s->pal.tile_pal[first], (size_t)count);
+    out_printf(c, "\n");
+    return 0;
+}
+
+static int cmd_set_tile_pal(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)argc;
+    int first, n = sheet_tiles(s);
+    if (parse_int(argv[1], 0, n - 1, &first) != 0)
+        return err(c, "tile out of range: %s", argv[1]);
+    int bytes = unhex(argv[2], scratch, n - first);
+    if (bytes <= 0) return err(c, "need one hex byte per tile, at most %d", n - first);
+    for (int i = 0; i < bytes; i++)
+        if (scratch[i] >= PAL_COUNT) return err(c, "palette %d out of range", scratch[i]);
+    memcpy(&s->pal.tile_pal[first], scratch, (size_t)bytes);
+    s->edit_rev++;
+    out_printf(c, "ok %d\n", bytes);
+    return 0;
+}
+
+/* SCENE X Y W: the scene number and a rectangle's corner and width. */
+static int cells_args(CtlClient *c, const EditorState *s, char **argv,
+                      int *scene, int *x, int *y, int *w) {
+    if (parse_int(argv[1], 0, s->compose.scene_count - 1, scene) != 0)
+        return err(c, "no scene %s", argv[1]);
+    if (parse_int(argv[2], 0, COMPOSE_NT_W - 1, x) != 0 ||
+        parse_int(argv[3], 0, COMPOSE_NT_H - 1, y) != 0)
+        return err(c, "cell out of range: %s,%s", argv[2], argv[3]);
+    if (parse_int(argv[4], 1, COMPOSE_NT_W - *x, w) != 0)
+        return err(c, "bad width: %s", argv[4]);
+    return 0;
+}
+
+static int cmd_get_cells(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)argc;
+    int scene, x0, y0, w, h;
+    if (cells_args(c, s, argv, &scene, &x0, &y0, &w) != 0) return -1;
+    if (parse_int(argv[5], 1, COMPOSE_NT_H - y0, &h) != 0)
+        return err(c, "bad height: %s", argv[5]);
+    static ComposeScene tmp;
+    const ComposeScene *sc = compose_peek(&s->compose, scene, &tmp);
+    if (!sc) return err(c, "can't read scene %d", scene);
+    out_printf(c, "ok %d %d %d %d %d ", scene, x0, y0, w, h);
+    for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++) {
+            int v = (sc->attr[y / 2][x / 2] & 3) << 12 | sc->nametable[y][x];
+            out_printf(c, "%04x", v);
+        }
+    out_printf(c, "\n");
+    return 0;
+}
+
+static int cmd_set_cells(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)argc;
+    int scene, x0, y0, w;
+    if (cells_args(c, s, argv, &scene, &x0, &y0, &w) != 0) return -1;
+    int bytes = unhex(argv[5], scratch, (int)sizeof(scratch));
+    if (bytes <= 0 || bytes % 2) return err(c, "need 4 hex digits per cell");
+    int cells = bytes / 2;
+    if (y0 + (cells + w - 1) / w > COMPOSE_NT_H) return err(c, "cells run off the screen");
+    for (int i = 0; i < cells; i++) {
+        int v = scratch[2 * i] << 8 | scratch[2 * i + 1];
+        if ((v >> 12) > 3 || (v & 0xFFF) >= CHR_MAX_TILES)
+            return err(c, "bad cell %04x", v);
+    }
+    /* The frame's undo step holds only the active scene; others are
+       added to it before their first write.                        */
+    if (scene != s->compose.active_scene && !input_checkpoint_scene(s, scene))
+        return err(c, "out of memory saving scene %d for undo", scene);
+    ComposeScene *sc = compose_scene(&s->compose, scene);
+    for (int i = 0; i < cells; i++) {
+        int v = scratch[2 * i] << 8 | scratch[2 * i + 1];
+        int x = x0 + i % w, y = y0 + i / w;
+        sc->nametable[y][x]    = (uint16_t)(v & 0xFFF);
+        sc->attr[y / 2][x / 2] = (uint8_t)(v >> 12);
+    }
+    usage_sync_scene(&s->usage, scene, sc);
+    s->edit_rev++;
+    out_printf(c, "ok %d\n", cells);
+    return 0;
+}
+
+static int cmd_save(CtlClient *c, EditorState *s, int argc, char **argv) {
+    if (argc > 1) snprintf(s->current_path, sizeof(s->current_path), "%s", argv[1]);
+    s->want_save = true;
+    c->waiting   = true;
+    return 0;
+}
+
+static int cmd_load(CtlClient *c, EditorState *s, int argc, char **argv) {
+    if (argc > 1) snprintf(s->current_path, sizeof(s->current_path), "%s", argv[1]);
+    s->want_load = true;
+    c->waiting   = true;
+    return 0;
+}
+
+static int cmd_subscribe(CtlClient *c, EditorState *s, int argc, char **argv) {
+    (void)s; (void)argc;
+    c->subscribed = !strcmp(argv[0], "subscribe");
+    out_printf(c, "ok\n");
+    return 0;
+}
+
+static const CtlCmd CMDS[] = {
+    { "info",         0, 0, cmd_info,         0, 0, "info" },
+    { "get-tiles",    1, 2, cmd_get_tiles,    0, 0, "get-tiles FIRST [COUNT]" },
+    { "set-tiles",    2, 2, cmd_set_tiles,    1, 0, "set-tiles FIRST HEX" },
+    { "get-pal",      0, 2, cmd_get_pal,      0, 0, "get-pal [FIRST [COUNT]]" },
+    { "set-pal",      2, 2, cmd_set_pal,      1, 0, "set-pal FIRST HEX" },
+    { "get-tile-pal", 1, 2, cmd_get_tile_pal, 0, 0, "get-tile-pal FIRST [COUNT]" },
+    { "set-tile-pal", 2, 2, cmd_set_tile_pal, 1, 0, "set-tile-pal FIRST HEX" },
+    { "get-cells",    5, 5, cmd_get_cells,    0, 0, "get-cells SCENE X Y W H" },
+    { "set-cells",    5, 5, cmd_set_cells,    1, 0, "set-cells SCENE X Y W HEX" },
+    { "save",         0, 1, cmd_save,         0, 1, "save [FILE.chr]" },
+    { "load",         0, 1, cmd_load,         0, 1, "load [FILE.chr]" },
+    { "subscribe",    0, 0, cmd_subscribe,    0, 0, "subscribe" },
+    { "unsubscribe",  0, 0, cmd_subscribe,    0, 0, "unsubscribe" },
+};
+#define NCMDS ((int)(sizeof(CMDS) / sizeof(CMDS[0])))
+
+/* ── Driver ──────────────────────────────────────────────────── */
+
+/* Split line in place into words; "double quotes" group.  Returns
+   the word count, or -1 if there are too many.                    */
+static int split(char *line, char *word[CTL_MAX_WORDS]) {
+    int n = 0;
+    char *p = line;
+    for (;;) {
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0') return n;
+        if (n == CTL_MAX_WORDS) return -1;
+        if (*p == '"') {
+            word[n++] = ++p;
+            while (*p && *p != '"') p++;
+        } else {
+            word[n++] = p;
+            while (*p && !isspace((unsigned char)*p)) p++;
+        }
+        if (*p) *p++ = '\0';
+    }
+}
+
+static bool file_op_pending(void) {
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++)
+        if (clients[i].fd >= 0 && clients[i].waiting) return true;
+    return false;
+}
+
+/* Run c's next complete line: 1 if one ran, 0 if there is none or it
+   has to wait for another client's save or load.                  */
+static int run_next(CtlClient *c, EditorState *s, bool *checkpointed) {
+    char *nl = memchr(c->in, '\n', c->in_len);
+    if (!nl) return 0;
+    size_t used = (size_t)(nl - c->in) + 1;
+    *nl = '\0';
+
+    /* One save or load in flight at a time: they share the main loop's
+       want_* flags and their replies come back in order.            */
+    if (file_op_pending()) {
+        const char *p = c->in + strspn(c->in, " \t\r");
+        size_t len = strcspn(p, " \t\r");
+        for (int k = 0; k < NCMDS; k++)
+            if (CMDS[k].file_op && strlen(CMDS[k].name) == len &&
+                !strncmp(p, CMDS[k].name, len)) {
+                *nl = '\n';
+                return 0;
+            }
+    }
+
+    char *word[CTL_MAX_WORDS];
+    int n = split(c->in, word);
+    const CtlCmd *cmd = NULL;
+    if (n > 0)
+        for (int k = 0; k < NCMDS && !cmd; k++)
+            if (!strcmp(word[0], CMDS[k].name)) cmd = &CMDS[k];
+
+    if (used > CTL_LINE_MAX) {
+        err(c, "request longer than %d bytes", CTL_LINE_MAX);
+    } else if (n < 0) {
+        err(c, "too many words");
+    } else if (n == 0) {
+        err(c, "empty request");
+    } else if (!cmd) {
+        err(c, "unknown command %s", word[0]);
+    } else if (n - 1 < cmd->min || n - 1 > cmd->max) {
+        err(c, "usage: %s", cmd->usage);
+    } else if (cmd->writes && !*checkpointed && !input_checkpoint(s)) {
+        err(c, "out of memory saving an undo step; %s not run", cmd->name);
+    } else {
+        if (cmd->writes) *checkpointed = true;
+        TraceZone z = trace_begin("ctl request");
+        z.detail = cmd->name;
+        cmd->run(c, s, n, word);
+        trace_end(z);
+    }
+    c->in_len -= used;
+    memmove(c->in, c->in + used, c->in_len);
+    return 1;
+}
+
+static void drop(CtlClient *c) {
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+/* Read what the socket has.  A line longer than CTL_LINE_MAX gets an
+   error and the connection closed.                                 */
+static void read_input(CtlClient *c) {
+    for (;;) {
+        if (c->in_cap - c->in_len < 4096) {
+            if (c->in_cap >= CTL_LINE_MAX && !memchr(c->in, '\n', c->in_len)) {
+                err(c, "request longer than %d bytes", CTL_LINE_MAX);
+                c->eof = true;
+                c->in_len = 0;
+                return;
+            }
+            if (c->in_cap >= 4 * CTL_LINE_MAX) return;  /* drain first */
+            size_t cap = c->in_cap ? c->in_cap * 2 : 8192;
+            char *p = realloc(c->in, cap);
+            if (!p) { c->broken = true; return; }
+            c->in     = p;
+            c->in_cap = cap;
+        }
+        ssize_t n = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, MSG_DONTWAIT);
+        if (n > 0) { c->in_len += (size_t)n; continue; }
+        if (n == 0) { c->eof = true; return; }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) c->broken = true;
+        return;
+    }
+}
+
+int ctl_open(const char *path) {
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++) clients[i].fd = -1;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "control socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    /* A socket left by an editor that didn't exit cleanly is replaced;
+       anything else at path is left alone and bind fails.            */
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe >= 0 &&
+                    connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) {
+            fprintf(stderr, "control socket %s is in use\n", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 ||
+        bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, CTL_MAX_CLIENTS) != 0 ||
+        fcntl(listen_fd, F_SETFL, O_NONBLOCK) != 0) {
+        fprintf(stderr, "can't listen on %s: %s\n", path, strerror(errno));
+        if (listen_fd >= 0) close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    snprintf(sock_path, sizeof(sock_path), "%s", path);
+    return 0;
+}
+
+void ctl_close(void) {
+    if (listen_fd < 0) return;
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++)
+        if (clients[i].fd >= 0) drop(&clients[i]);
+    close(listen_fd);
+    unlink(sock_path);
+    listen_fd = -1;
+}
+
+void ctl_poll(EditorState *s, double budget_ms) {
+    if (listen_fd < 0) return;
+    double t0 = now_ms();
+
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) break;
+        int slot = -1;
+        for (int i = 0; i < CTL_MAX_CLIENTS && slot < 0; i++)
+            if (clients[i].fd < 0) slot = i;
+        if (slot < 0) { close(fd); continue; }     /* full */
+        memset(&clients[slot], 0, sizeof(clients[slot]));
+        clients[slot].fd = fd;
+    }
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++)
+        if (clients[i].fd >= 0 && !clients[i].eof) read_input(&clients[i]);
+
+    /* One request per client per pass, so a bulk upload can't starve
+       the others, until the queues empty or the budget runs out.   */
+    bool checkpointed = false;
+    for (int ran = 1; ran; ) {
+        ran = 0;
+        for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+            CtlClient *c = &clients[i];
+            if (c->fd < 0 || c->waiting || c->broken) continue;
+            ran += run_next(c, s, &checkpointed);
+            if (now_ms() - t0 >= budget_ms) { ran = 0; break; }
+        }
+    }
+
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+        CtlClient *c = &clients[i];
+        if (c->fd < 0) continue;
+        flush(c);
+        bool idle = !c->waiting && !memchr(c->in, '\n', c->in_len) &&
+                    c->out_off == c->out_len;
+        if (c->broken || (c->eof && idle)) drop(c);
+    }
+}
+
+void ctl_result(const char *msg) {
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+        CtlClient *c = &clients[i];
+        if (c->fd < 0 || !c->waiting) continue;
+        c->waiting = false;
+        if (!strncmp(msg, "ERROR ", 6)) out_printf(c, "err %s\n", msg + 6);
+        else                            out_printf(c, "ok %s\n", msg);
+        flush(c);
+        return;
+    }
+}
+
+void ctl_notify(const EditorState *s) {
+    if (listen_fd < 0) return;
+    if (!seen_valid) {
+        seen_chr_rev  = s->chr_rev;
+        seen_edit_rev = s->edit_rev;
+        seen_valid    = true;
+        return;
+    }
+    bool tiles = s->chr_rev != seen_chr_rev, edit = s->edit_rev != seen_edit_rev;
+    if (!tiles && !edit) return;
+
+    int list[CTL_EV_TILES], n = 0;
+    bool all = false;
+    for (int t = 0; tiles && t < CHR_MAX_TILES && !all; t++)
+        if (s->tile_rev[t] - seen_chr_rev - 1 < s->chr_rev - seen_chr_rev) {
+            if (n == CTL_EV_TILES) all = true;
+            else                   list[n++] = t;
+        }
+    seen_chr_rev  = s->chr_rev;
+    seen_edit_rev = s->edit_rev;
+
+    for (int i = 0; i < CTL_MAX_CLIENTS; i++) {
+        CtlClient *c = &clients[i];
+        if (c->fd < 0 || !c->subscribed) continue;
+        if (tiles && n > 0) {
+            out_printf(c, "ev tiles");
+            if (all) out_printf(c, " *");
+            else for (int k = 0; k < n; k++) out_printf(c, " %d", list[k]);
+            out_printf(c, "\n");
+        }
+        if (edit) out_printf(c, "ev edit\n");
+        flush(c);
+    }
+}
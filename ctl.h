@@ -0,0 +1,40 @@
+#pragma once
+#include "main.h"
+
+/* ── Control socket ──────────────────────────────────────────────
+   --listen=PATH opens a Unix-domain stream socket that scripts and
+   tools can drive the editor through.  Each request is one line of
+   words; each gets exactly one reply line, in order:
+
+       get-tiles 16 2            ok 16 2 <64 hex digits>
+       set-tiles 16 <hex>        ok 2
+       frob                      err unknown command frob
+
+   Tiles travel as NES planar data (16 bytes each), palettes as
+   master-palette indices, cells as four hex digits "PTTT" (palette
+   0-3, tile 000-3FF).  After "subscribe" the client also receives
+   "ev ..." lines when the document changes, once a frame, between
+   whole replies.  The command list is in ctl.c and the README.
+
+   Requests are run between frames, up to a time budget per frame;
+   the rest wait for the next one, so a bulk update never stalls
+   drawing.  The writes made in one frame are one undo step.  save
+   and load reply once the main loop has run them.                 */
+
+#define CTL_BUDGET_MS 4.0       /* request time per frame */
+
+/* Listen on path (replacing a stale socket there): 0, or -1 with a
+   message on stderr.                                              */
+int  ctl_open(const char *path);
+void ctl_close(void);
+
+/* Accept clients and run queued requests for up to budget_ms. */
+void ctl_poll(EditorState *s, double budget_ms);
+
+/* Send subscribers what changed since the last call; call once a
+   frame after the file operations.                                */
+void ctl_notify(const EditorState *s);
+
+/* Result of a file operation (the window title text): the reply to
+   a waiting save or load, if any.                                 */
+void ctl_result(const char *msg);
@@ -1,35 +1,47 @@
 #include "export.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-/* Writes raw NES CHR data to path.
-   Output is ntiles * 16 bytes, no header.
-
-   NES planar format per tile:
+/* NES planar format per tile:
      bytes  0- 7: bitplane 0 — bit 0 of each pixel, MSB = leftmost pixel
      bytes  8-15: bitplane 1 — bit 1 of each pixel, MSB = leftmost pixel
 
    Pixel value v at column c contributes:
      bp0 row byte |= (v & 1)        << (7 - c)
-     bp1 row byte |= ((v >> 1) & 1) << (7 - c)
+     bp1 row byte |= ((v >> 1) & 1) << (7 - c)                   */
+void export_encode_tile(const uint8_t px[TILE_H][TILE_W], uint8_t out[16]) {
+    for (int row = 0; row < TILE_H; row++) {
+        uint8_t bp0 = 0, bp1 = 0;
+        for (int col = 0; col < TILE_W; col++) {
+            uint8_t v = px[row][col] & 3;
+            bp0 |= (uint8_t)( (v & 1)        << (7 - col) );
+            bp1 |= (uint8_t)( ((v >> 1) & 1) << (7 - col) );
+        }
+        out[row]     = bp0;
+        out[8 + row] = bp1;
+    }
+}
+
+void export_decode_tile(const uint8_t in[16], uint8_t px[TILE_H][TILE_W]) {
+    for (int row = 0; row < TILE_H; row++)
+        for (int col = 0; col < TILE_W; col++) {
+            int bit = 7 - col;
+            px[row][col] = (uint8_t)(((in[row] >> bit) & 1) |
+                                     (((in[8 + row] >> bit) & 1) << 1));
+        }
+}
 
+/* Writes raw NES CHR data to path.
+   Output is ntiles * 16 bytes, no header (see export_encode_tile).
    Returns 0 on success, -1 on I/O error.                         */
 int export_chr(const ChrPage *chr, int ntiles, const char *path) {
     FILE *f = fopen(path, "wb");
     if (!f) return -1;
 
     for (int tile = 0; tile < ntiles; tile++) {
-        uint8_t buf[16] = {0};
-
-        for (int row = 0; row < TILE_H; row++) {
-            uint8_t bp0 = 0, bp1 = 0;
-            for (int col = 0; col < TILE_W; col++) {
-                uint8_t v = chr->px[tile][row][col] & 3;
-                bp0 |= (uint8_t)( (v & 1)        << (7 - col) );
-                bp1 |= (uint8_t)( ((v >> 1) & 1) << (7 - col) );
-            }
-            buf[row]     = bp0;
-            buf[8 + row] = bp1;
-        }
+        uint8_t buf[16];
+        export_encode_tile(chr->px[tile], buf);
 
         if (fwrite(buf, 1, 16, f) != 16) {
             fclose(f);
@@ -40,3 +52,163 @@ int export_chr(const ChrPage *chr, int ntiles, const char *path) {
     fclose(f);
     return 0;
 }
+
+/* ── Nametable / attribute table ─────────────────────────────────
+   Bytes 0-959 hold one tile number per 8×8 cell.  The PPU only has
+   8 bits per cell, so tiles 256+ are written modulo 256 (they live
+   in the second pattern table, selected by PPUCTRL at runtime).
+
+   Bytes 960-1023: one attribute byte per 32×32 px area, 8 per row.
+   Each byte packs four of our 16×16 attr blocks, 2 bits each:
+     bits 0-1 top-left, 2-3 top-right, 4-5 bottom-left, 6-7 bottom-right.
+   Our 15 attr rows cover only the top half of the 8th byte row;
+   the bottom quadrants there stay 0.                              */
+void export_nametable(const ComposeScene *sc, uint8_t out[NES_NAMETABLE_BYTES]) {
+    for (int r = 0; r < COMPOSE_NT_H; r++)
+        for (int c = 0; c < COMPOSE_NT_W; c++)
+            out[r * COMPOSE_NT_W + c] = (uint8_t)(sc->nametable[r][c] & 0xFF);
+
+    uint8_t *at = out + COMPOSE_NT_W * COMPOSE_NT_H;
+    memset(at, 0, 64);
+    for (int ay = 0; ay < 15; ay++) {
+        for (int ax = 0; ax < 16; ax++) {
+            int shift = ((ay & 1) << 2) | ((ax & 1) << 1);
+            at[(ay >> 1) * 8 + (ax >> 1)] |= (uint8_t)((sc->attr[ay][ax] & 3) << shift);
+        }
+    }
+}
+
+/* ── OAM ─────────────────────────────────────────────────────────
+   Per hardware sprite: Y, tile, attributes, X.
+     Y    = top row - 1 (the PPU draws sprites one scanline late);
+            a sprite on row 0 gets Y 0, one row low, since Y 0xFF
+            would hide it
+     attr = bits 0-1 palette (4-7 → 0-3), bit 5 behind BG,
+            bit 6 hflip, bit 7 vflip
+   A 16×16 sprite uses tiles [0][2] / [1][3] as in compose mode; the
+   quadrants swap with the flip bits so the picture matches.
+   OAM slot 0 is frontmost on the NES, while the editor draws the
+   last sprite on top, so sprites go out in reverse list order.    */
+static int oam_put(uint8_t *out, int n, int x, int y, int tile,
+                   const ComposeSprite *sp) {
+    if (n >= COMPOSE_MAX_SPR) return n;
+    if (x > 255 || y > 239) return n;   /* quadrant falls off-screen */
+    uint8_t a = (uint8_t)((sp->palette - 4) & 3);
+    if (sp->behind_bg) a |= 0x20;
+    if (sp->hflip)     a |= 0x40;
+    if (sp->vflip)     a |= 0x80;
+    uint8_t *e = out + n * 4;
+    e[0] = (uint8_t)(y > 0 ? y - 1 : 0);
+    e[1] = (uint8_t)(tile & 0xFF);
+    e[2] = a;
+    e[3] = (uint8_t)x;
+    return n + 1;
+}
+
+int export_oam(const ComposeScene *sc, uint8_t out[NES_OAM_BYTES]) {
+    memset(out, 0xFF, NES_OAM_BYTES);
+    int n = 0;
+    for (int i = sc->sprite_count - 1; i >= 0; i--) {
+        const ComposeSprite *sp = &sc->sprites[i];
+        if (!sp->s16) {
+            n = oam_put(out, n, sp->x, sp->y, sp->tile, sp);
+            continue;
+        }
+        for (int qx = 0; qx < 2; qx++) {
+            for (int qy = 0; qy < 2; qy++) {
+                int sub_x = sp->hflip ? 1 - qx : qx;
+                int sub_y = sp->vflip ? 1 - qy : qy;
+                n = oam_put(out, n, sp->x + qx * TILE_W, sp->y + qy * TILE_H,
+                            sp->tile + sub_x * 2 + sub_y, sp);
+            }
+        }
+    }
+    return n;
+}
+
+/* Build every scene's block into one buffer and write it in one go. */
+static int write_scene_blocks(const ComposeData *d, const char *path,
+                              size_t block, bool oam) {
+    size_t total = block * (size_t)d->scene_count;
+    uint8_t *buf = malloc(total);
+    if (!buf) return -1;
+    for (int i = 0; i < d->scene_count; i++) {
+        ComposeScene tmp;
+        const ComposeScene *sc = compose_peek(d, i, &tmp);
+        if (!sc) { free(buf); return -1; }
+        uint8_t *dst = buf + block * (size_t)i;
+        if (oam) export_oam(sc, dst);
+        else     export_nametable(sc, dst);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) { free(buf); return -1; }
+    int ok = (fwrite(buf, 1, total, f) == total);
+    if (fclose(f) != 0) ok = 0;
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+int export_scenes_nam(const ComposeData *d, const char *path) {
+    return write_scene_blocks(d, path, NES_NAMETABLE_BYTES, false);
+}
+
+int export_scenes_oam(const ComposeData *d, const char *path) {
+    return write_scene_blocks(d, path, NES_OAM_BYTES, true);
+}
+
+int export_scenes_packed(const ComposeData *d, Codec codec, const char *path) {
+    size_t table = 2 * (size_t)d->scene_count;
+    size_t cap   = table + codec_bound(NES_NAMETABLE_BYTES) * (size_t)d->scene_count;
+    uint8_t *buf = malloc(cap);
+    if (!buf) return -1;
+
+    size_t pos = table;
+    for (int i = 0; i < d->scene_count; i++) {
+        ComposeScene tmp;
+        const ComposeScene *sc = compose_peek(d, i, &tmp);
+        uint8_t nt[NES_NAMETABLE_BYTES];
+        long n = -1;
+        if (pos > 0xFFFF) { free(buf); return EXPORT_OFFSET_OVERFLOW; }
+        if (sc) {
+            export_nametable(sc, nt);
+            n = codec_compress(codec, nt, sizeof(nt), buf + pos);
+        }
+        if (n < 0) { free(buf); return -1; }
+        buf[2 * i]     = (uint8_t)(pos & 0xFF);
+        buf[2 * i + 1] = (uint8_t)(pos >> 8);
+        pos += (size_t)n;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) { free(buf); return -1; }
+    int ok = (fwrite(buf, 1, pos, f) == pos);
+    if (fclose(f) != 0) ok = 0;
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+/* ── Near-duplicate report ───────────────────────────────────── */
+
+int export_near_report(const TileHash *th, int ntiles, int max_dist,
+                       const char *path) {
+    static const char *const FLIP[4] = { "-", "H", "V", "HV" };
+
+    /* Count first, then fetch exactly that many pairs. */
+    int n = tilehash_near_pairs(th, ntiles, max_dist, true, NULL, 0);
+    TileMatch *m = malloc((size_t)(n > 0 ? n : 1) * sizeof(*m));
+    if (!m) return -1;
+    tilehash_near_pairs(th, ntiles, max_dist, true, m, n);
+
+    FILE *f = fopen(path, "w");
+    if (!f) { free(m); return -1; }
+    fprintf(f, "; near-duplicate tiles: %d pair(s), <= %d px apart, flips allowed\n",
+            n, max_dist);
+    fprintf(f, ";    a     b  px  flip (applied to a)\n");
+    for (int i = 0; i < n; i++)
+        fprintf(f, "%6d%6d%4d  %s\n", m[i].a, m[i].b, m[i].dist, FLIP[m[i].flip & 3]);
+    int ok = !ferror(f);
+    if (fclose(f) != 0) ok = 0;
+    free(m);
+    return ok ? n : -1;
+}
@@ -1,8 +1,54 @@
 #pragma once
 #include "chr.h"
+#include "compose.h"
+#include "compress.h"
+#include "tilehash.h"
+
+/* ── NES PPU data sizes ──────────────────────────────────────── */
+#define NES_NAMETABLE_BYTES 1024   /* 960 tile bytes + 64 attribute bytes */
+#define NES_OAM_BYTES        256   /* 64 sprites × 4 bytes                */
+
+/* Encodes one tile's 2-bit pixels as 16 bytes of NES planar data
+   (8 bytes bitplane-0, then 8 bytes bitplane-1). */
+void export_encode_tile(const uint8_t px[TILE_H][TILE_W], uint8_t out[16]);
+
+/* The inverse: 16 planar bytes back to 2-bit pixels. */
+void export_decode_tile(const uint8_t in[16], uint8_t px[TILE_H][TILE_W]);
 
 /* Writes raw NES CHR binary to path.
    Format: ntiles × 16 bytes, no header.
    Each tile: 8 bytes bitplane-0, 8 bytes bitplane-1.
    Returns 0 on success, -1 on error. */
 int export_chr(const ChrPage *chr, int ntiles, const char *path);
+
+/* Builds the PPU image of one scene's nametable: 960 tile bytes
+   (row-major, low 8 bits of each index) followed by the 64-byte
+   packed attribute table. */
+void export_nametable(const ComposeScene *sc, uint8_t out[NES_NAMETABLE_BYTES]);
+
+/* Builds a 256-byte OAM image for one scene's sprites.  16×16 sprites
+   expand to four hardware entries.  Unused entries are $FF (hidden).
+   Returns the number of hardware entries used (sprites past 64 are
+   dropped). */
+int  export_oam(const ComposeScene *sc, uint8_t out[NES_OAM_BYTES]);
+
+/* Batch exporters: every scene in d, back to back, in one write.
+   .nam = scene_count × 1024 bytes, .oam = scene_count × 256 bytes.
+   Return 0 on success, -1 on error. */
+int  export_scenes_nam(const ComposeData *d, const char *path);
+int  export_scenes_oam(const ComposeData *d, const char *path);
+
+/* Batch compressed nametables: a table of scene_count uint16 LE
+   offsets (from file start), then each scene's 1024-byte nametable
+   image compressed with codec.  Returns 0 on success, -1 on error
+   (including a scene the codec cannot represent), or
+   EXPORT_OFFSET_OVERFLOW if a scene would start past the 64 KB the
+   offsets reach.  Nothing is written unless it succeeds.           */
+#define EXPORT_OFFSET_OVERFLOW (-2)
+int  export_scenes_packed(const ComposeData *d, Codec codec, const char *path);
+
+/* Text report of near-duplicate tile pairs (see tilehash_near_pairs):
+   one "a b pixels flip" line per pair, flips allowed.  Returns the
+   number of pairs written, or -1 on error.                        */
+int  export_near_report(const TileHash *th, int ntiles, int max_dist,
+                        const char *path);
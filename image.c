@@ -0,0 +1,417 @@
+#include "image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#define IMAGE_MAX_DIM 4096      /* sanity cap on width and height */
+
+void image_free(Image *img) {
+    free(img->rgb);
+    img->rgb = NULL;
+    img->w = img->h = 0;
+}
+
+static int image_alloc(Image *img, int w, int h) {
+    if (w < 1 || h < 1 || w > IMAGE_MAX_DIM || h > IMAGE_MAX_DIM) return -1;
+    img->rgb = malloc((size_t)w * h * 3);
+    if (!img->rgb) return -1;
+    img->w = w;
+    img->h = h;
+    return 0;
+}
+
+/* ── BMP ─────────────────────────────────────────────────────── */
+
+static uint32_t le32(const uint8_t *p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Shift and width of a BI_BITFIELDS channel mask. */
+static void mask_shape(uint32_t m, int *shift, int *bits) {
+    *shift = *bits = 0;
+    if (!m) return;
+    while (!(m & 1)) { m >>= 1; (*shift)++; }
+    while (m & 1)    { m >>= 1; (*bits)++; }
+}
+
+static uint8_t mask_get(uint32_t v, int shift, int bits) {
+    if (bits == 0) return 0;
+    uint32_t x = bits == 32 ? v : (v >> shift) & ((1u << bits) - 1);   /* 1u << 32 is undefined */
+    return (uint8_t)(bits >= 8 ? x >> (bits - 8) : x * 255 / ((1u << bits) - 1));
+}
+
+/* Uncompressed BMPs: 1/4/8-bit paletted, 16/32-bit (BI_RGB or
+   BI_BITFIELDS) and 24-bit, bottom-up or top-down, with the OS/2 or
+   any Windows info header.  RLE-compressed files are rejected.    */
+static int load_bmp(Image *img, FILE *f) {
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 14 + 12) return -1;
+    uint8_t *buf = malloc((size_t)size);
+    int rc = -1;
+    if (!buf || fread(buf, 1, (size_t)size, f) != (size_t)size) goto out;
+
+    uint32_t off = le32(buf + 10), hsz = le32(buf + 14);
+    int w, h, bpp;
+    uint32_t comp = 0, used = 0, mask[3] = { 0x7C00, 0x03E0, 0x001F };
+    const uint8_t *pal;
+    int pal_stride;
+    if (hsz == 12) {
+        w   = buf[18] | buf[19] << 8;
+        h   = buf[20] | buf[21] << 8;
+        bpp = buf[24] | buf[25] << 8;
+        pal = buf + 26;
+        pal_stride = 3;
+    } else {
+        if (hsz < 40 || 14 + hsz > (uint32_t)size) goto out;
+        w    = (int32_t)le32(buf + 18);
+        h    = (int32_t)le32(buf + 22);
+        bpp  = buf[28] | buf[29] << 8;
+        comp = le32(buf + 30);
+        used = le32(buf + 46);
+        pal  = buf + 14 + hsz;
+        pal_stride = 4;
+        if (bpp == 32 && comp == 0) { mask[0] = 0xFF0000; mask[1] = 0xFF00; mask[2] = 0xFF; }
+        if (comp == 3) {          /* BI_BITFIELDS: masks end the header or follow it */
+            const uint8_t *m = hsz >= 52 ? buf + 54 : buf + 14 + hsz;
+            if (m + 12 > buf + size) goto out;
+            for (int k = 0; k < 3; k++) mask[k] = le32(m + 4 * k);
+            if (hsz < 52) pal += 12;
+        } else if (comp != 0) {
+            goto out;
+        }
+    }
+    bool top_down = h < 0;
+    if (h == INT32_MIN) goto out;   /* can't be negated */
+    if (top_down) h = -h;
+    if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 16 && bpp != 24 && bpp != 32) goto out;
+    if (comp == 3 && bpp != 16 && bpp != 32) goto out;
+    if (image_alloc(img, w, h) != 0) goto out;
+
+    int ncol = bpp <= 8 ? (used && used < (1u << bpp) ? (int)used : 1 << bpp) : 0;
+    size_t stride = ((size_t)w * bpp + 31) / 32 * 4;
+    if ((size_t)(pal - buf) + (size_t)ncol * pal_stride > (size_t)size ||
+        off > (size_t)size || (size_t)size - off < stride * h) {
+        image_free(img);
+        goto out;
+    }
+    int sh[3], bits[3];
+    for (int k = 0; k < 3; k++) mask_shape(mask[k], &sh[k], &bits[k]);
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *row = buf + off + stride * (size_t)(top_down ? y : h - 1 - y);
+        uint8_t *dst = img->rgb + (size_t)y * w * 3;
+        for (int x = 0; x < w; x++, dst += 3) {
+            if (bpp <= 8) {
+                int i = (row[x * bpp / 8] >> (8 - bpp - (x * bpp) % 8)) & ((1 << bpp) - 1);
+                const uint8_t *c = pal + (size_t)(i < ncol ? i : 0) * pal_stride;
+                dst[0] = c[2]; dst[1] = c[1]; dst[2] = c[0];
+            } else if (bpp == 24) {
+                dst[0] = row[x * 3 + 2]; dst[1] = row[x * 3 + 1]; dst[2] = row[x * 3];
+            } else {
+                uint32_t v = bpp == 16 ? (uint32_t)(row[x * 2] | row[x * 2 + 1] << 8)
+                                       : le32(row + x * 4);
+                for (int k = 0; k < 3; k++) dst[k] = mask_get(v, sh[k], bits[k]);
+            }
+        }
+    }
+    rc = 0;
+out:
+    free(buf);
+    return rc;
+}
+
+/* ── PPM ─────────────────────────────────────────────────────── */
+
+/* Next header/ASCII integer, skipping whitespace and # comments. */
+static int ppm_int(FILE *f) {
+    int c = fgetc(f);
+    for (;;) {
+        while (c != EOF && isspace(c)) c = fgetc(f);
+        if (c != '#') break;
+        while (c != EOF && c != '\n') c = fgetc(f);
+    }
+    if (c == EOF || !isdigit(c)) return -1;
+    int v = 0;
+    while (c != EOF && isdigit(c)) {
+        if (v > 65535) return -1;
+        v = v * 10 + (c - '0');
+        c = fgetc(f);
+    }
+    return v;   /* the single whitespace after the value is consumed */
+}
+
+static int load_ppm(Image *img, FILE *f) {
+    char magic[2];
+    if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' ||
+        (magic[1] != '6' && magic[1] != '3')) return -1;
+    int w = ppm_int(f), h = ppm_int(f), maxval = ppm_int(f);
+    if (maxval < 1 || maxval > 255) return -1;
+    if (image_alloc(img, w, h) != 0) return -1;
+
+    size_t n = (size_t)w * h * 3;
+    if (magic[1] == '6') {
+        if (fread(img->rgb, 1, n, f) != n) { image_free(img); return -1; }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            int v = ppm_int(f);
+            if (v < 0 || v > maxval) { image_free(img); return -1; }
+            img->rgb[i] = (uint8_t)v;
+        }
+    }
+    if (maxval != 255)
+        for (size_t i = 0; i < n; i++)
+            img->rgb[i] = (uint8_t)((img->rgb[i] * 255 + maxval / 2) / maxval);
+    return 0;
+}
+
+/* ── PNG (stored deflate only) ───────────────────────────────── */
+
+static const uint8_t PNG_SIG[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static uint32_t be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8)  |  (uint32_t)p[3];
+}
+
+/* Unwrap a zlib stream made of stored blocks into out (exactly cap
+   bytes expected).  Returns 0, or -1 on a compressed block or a
+   malformed stream.                                               */
+static int zlib_stored(const uint8_t *z, size_t n, uint8_t *out, size_t cap) {
+    if (n < 2 || (z[0] & 0x0F) != 8 || ((z[0] << 8) | z[1]) % 31 != 0 ||
+        (z[1] & 0x20)) return -1;
+    size_t pos = 2, len = 0;
+    for (;;) {
+        /* Stored blocks end on a byte boundary, so each header is the
+           low 3 bits of a fresh byte.                               */
+        if (pos + 5 > n) return -1;
+        int hdr = z[pos];
+        if ((hdr >> 1 & 3) != 0) return -1;
+        size_t blen = z[pos + 1] | (z[pos + 2] << 8);
+        size_t nlen = z[pos + 3] | (z[pos + 4] << 8);
+        if ((blen ^ nlen) != 0xFFFF) return -1;
+        pos += 5;
+        if (pos + blen > n || len + blen > cap) return -1;
+        memcpy(out + len, z + pos, blen);
+        pos += blen;
+        len += blen;
+        if (hdr & 1) break;
+    }
+    return len == cap ? 0 : -1;
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+/* Undo the per-row filters in place; rows are 1 + stride bytes. */
+static int png_unfilter(uint8_t *d, int h, size_t stride, int bpp) {
+    const uint8_t *prev = NULL;
+    for (int y = 0; y < h; y++) {
+        uint8_t  ft  = d[y * (stride + 1)];
+        uint8_t *row = d + y * (stride + 1) + 1;
+        for (size_t i = 0; i < stride; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp]  : 0;
+            int b = prev             ? prev[i]       : 0;
+            int c = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+            switch (ft) {
+                case 0: break;
+                case 1: row[i] = (uint8_t)(row[i] + a);            break;
+                case 2: row[i] = (uint8_t)(row[i] + b);            break;
+                case 3: row[i] = (uint8_t)(row[i] + (a + b) / 2);  break;
+                case 4: row[i] = (uint8_t)(row[i] + paeth(a, b, c)); break;
+                default: return -1;
+            }
+        }
+        prev = row;
+    }
+    return 0;
+}
+
+static int load_png(Image *img, FILE *f) {
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 8 + 25) return -1;
+
+    uint8_t *buf = malloc((size_t)size);
+    uint8_t *z = NULL, *raw = NULL;
+    int rc = -1;
+    if (!buf || fread(buf, 1, (size_t)size, f) != (size_t)size ||
+        memcmp(buf, PNG_SIG, 8) != 0) goto out;
+
+    int w = 0, h = 0, ctype = -1, chans = 0;
+    uint8_t plte[256][3] = { { 0 } };
+    size_t zlen = 0, pos = 8;
+    z = malloc((size_t)size);
+    if (!z) goto out;
+
+    while (pos + 12 <= (size_t)size) {
+        uint32_t len = be32(buf + pos);
+        const uint8_t *type = buf + pos + 4, *data = buf + pos + 8;
+        if (len > (size_t)size - pos - 12) goto out;
+        if (!memcmp(type, "IHDR", 4) && len >= 13) {
+            w = (int)be32(data);
+            h = (int)be32(data + 4);
+            ctype = data[9];
+            /* bit depth 8, deflate, adaptive filters, no interlace */
+            if (data[8] != 8 || data[10] || data[11] || data[12]) goto out;
+            chans = ctype == 0 ? 1 : ctype == 2 ? 3 : ctype == 3 ? 1 :
+                    ctype == 4 ? 2 : ctype == 6 ? 4 : 0;
+            if (!chans) goto out;
+        } else if (!memcmp(type, "PLTE", 4)) {
+            memcpy(plte, data, len < sizeof(plte) ? len : sizeof(plte));
+        } else if (!memcmp(type, "IDAT", 4)) {
+            memcpy(z + zlen, data, len);
+            zlen += len;
+        } else if (!memcmp(type, "IEND", 4)) {
+            break;
+        }
+        pos += 12 + len;
+    }
+    if (!chans || w < 1 || h < 1 || w > IMAGE_MAX_DIM || h > IMAGE_MAX_DIM)
+        goto out;
+
+    size_t stride = (size_t)w * chans;
+    raw = malloc((stride + 1) * h);
+    if (!raw || zlib_stored(z, zlen, raw, (stride + 1) * h) != 0 ||
+        png_unfilter(raw, h, stride, chans) != 0 ||
+        image_alloc(img, w, h) != 0) goto out;
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *row = raw + y * (stride + 1) + 1;
+        uint8_t *dst = img->rgb + (size_t)y * w * 3;
+        for (int x = 0; x < w; x++, dst += 3) {
+            const uint8_t *p = row + (size_t)x * chans;
+            if (ctype == 3)       memcpy(dst, plte[p[0]], 3);
+            else if (chans >= 3)  memcpy(dst, p, 3);
+            else                  dst[0] = dst[1] = dst[2] = p[0];
+        }
+    }
+    rc = 0;
+out:
+    free(raw);
+    free(z);
+    free(buf);
+    return rc;
+}
+
+/* ── PNG writer (stored deflate) ─────────────────────────────── */
+
+/* Bitwise CRC-32: no shared table, so concurrent saves are safe. */
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n) {
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++)
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    return ~crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+static int png_chunk(FILE *f, const char *type, const uint8_t *data, size_t len) {
+    uint8_t hdr[8], tail[4];
+    put_be32(hdr, (uint32_t)len);
+    memcpy(hdr + 4, type, 4);
+    uint32_t crc = crc32_update(crc32_update(0, hdr + 4, 4), data, len);
+    put_be32(tail, crc);
+    return (fwrite(hdr, 1, 8, f) == 8 &&
+            (len == 0 || fwrite(data, 1, len, f) == len) &&
+            fwrite(tail, 1, 4, f) == 4) ? 0 : -1;
+}
+
+static int save_png(const Image *img, FILE *f) {
+    /* Filter-0 rows wrapped in a zlib stream of ≤65535-byte stored
+       blocks: 2-byte header, 5 bytes per block, Adler-32 trailer.  */
+    size_t stride = (size_t)img->w * 3 + 1;
+    size_t raw    = stride * img->h;
+    size_t blocks = (raw + 65534) / 65535;
+    size_t zlen   = 2 + blocks * 5 + raw + 4;
+    uint8_t *z = malloc(zlen);
+    if (!z) return -1;
+
+    uint8_t *o = z;
+    *o++ = 0x78; *o++ = 0x01;
+    uint32_t a = 1, b = 0;
+    size_t   left = raw, row_pos = 0;
+    int      y = 0;
+    while (left > 0) {
+        size_t n = left < 65535 ? left : 65535;
+        left -= n;
+        *o++ = left == 0;
+        *o++ = (uint8_t)n;  *o++ = (uint8_t)(n >> 8);
+        *o++ = (uint8_t)~n; *o++ = (uint8_t)(~n >> 8);
+        for (size_t i = 0; i < n; i++) {
+            uint8_t v = row_pos == 0 ? 0
+                      : img->rgb[(size_t)y * img->w * 3 + row_pos - 1];
+            if (++row_pos == stride) { row_pos = 0; y++; }
+            *o++ = v;
+            a = (a + v) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    put_be32(o, (b << 16) | a);
+
+    uint8_t ihdr[13] = { 0 };
+    put_be32(ihdr, (uint32_t)img->w);
+    put_be32(ihdr + 4, (uint32_t)img->h);
+    ihdr[8] = 8;                       /* bit depth       */
+    ihdr[9] = 2;                       /* RGB             */
+    int rc = (fwrite(PNG_SIG, 1, 8, f) == 8 &&
+              png_chunk(f, "IHDR", ihdr, sizeof(ihdr)) == 0 &&
+              png_chunk(f, "IDAT", z, zlen) == 0 &&
+              png_chunk(f, "IEND", NULL, 0) == 0) ? 0 : -1;
+    free(z);
+    return rc;
+}
+
+/* ── Entry points ────────────────────────────────────────────── */
+
+int image_save(const Image *img, const char *path) {
+    if (!img->rgb || img->w < 1 || img->h < 1) return -1;
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    const char *dot = strrchr(path, '.');
+    int rc;
+    if (dot && (!strcmp(dot, ".ppm") || !strcmp(dot, ".PPM"))) {
+        size_t n = (size_t)img->w * img->h * 3;
+        rc = (fprintf(f, "P6\n%d %d\n255\n", img->w, img->h) > 0 &&
+              fwrite(img->rgb, 1, n, f) == n) ? 0 : -1;
+    } else {
+        rc = save_png(img, f);
+    }
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+int image_load(Image *img, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    uint8_t magic[8] = { 0 };
+    size_t  got = fread(magic, 1, sizeof(magic), f);
+    rewind(f);
+
+    Image tmp = { 0, 0, NULL };
+    int rc = -1;
+    if (got >= 8 && memcmp(magic, PNG_SIG, 8) == 0)
+        rc = load_png(&tmp, f);
+    else if (got >= 2 && magic[0] == 'P' && (magic[1] == '6' || magic[1] == '3'))
+        rc = load_ppm(&tmp, f);
+    else if (got >= 2 && magic[0] == 'B' && magic[1] == 'M')
+        rc = load_bmp(&tmp, f);
+    fclose(f);
+
+    if (rc == 0) *img = tmp;
+    return rc;
+}
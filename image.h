@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+/* ── RGB images for import ───────────────────────────────────────
+   Decoded to 8-bit RGB, row-major, 3 bytes per pixel.  Supported:
+     BMP  uncompressed: 1/4/8-bit paletted, 16/24/32-bit
+     PPM  P6 (binary) and P3 (ASCII), maxval 1-255
+     PNG  8-bit grey / RGB / palette / grey+alpha / RGBA, not
+          interlaced, with zlib "stored" (uncompressed) blocks only —
+          what most editors write with compression level 0.  Alpha
+          is ignored.
+   The format is picked from the file's magic bytes.              */
+
+typedef struct {
+    int      w, h;
+    uint8_t *rgb;           /* w * h * 3 bytes (malloc'd) */
+} Image;
+
+/* Returns 0 on success, -1 on error (unreadable, unsupported or
+   corrupt file); *img is only filled on success.                 */
+int  image_load(Image *img, const char *path);
+void image_free(Image *img);
+
+/* Write img as PPM (P6) if path ends in .ppm, else as an RGB PNG
+   with stored deflate blocks — readable by image_load and by any
+   other PNG reader.  Returns 0 on success, -1 on error.          */
+int  image_save(const Image *img, const char *path);
@@ -0,0 +1,303 @@
+#include "import.h"
+#include "export.h"
+#include "par.h"
+#include "palopt.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IMG_W    (COMPOSE_NT_W * TILE_W)     /* 256 */
+#define IMG_H    (COMPOSE_NT_H * TILE_H)     /* 240 */
+#define BLK_W    (COMPOSE_NT_W / 2)          /* 16 attribute blocks across */
+#define BLK_H    (COMPOSE_NT_H / 2)          /* 15 down                    */
+#define BLOCKS   (BLK_W * BLK_H)
+#define NO_COL   0xFF
+#define DEDUP_TABLE 2048                     /* power of two, >= 2 × CHR_MAX_TILES */
+
+/* ── Colour matching ─────────────────────────────────────────── */
+
+/* Snap targets: every master colour except the duplicate blacks
+   ($xE/$xF, $1D) and $0D, which upsets some TVs; $0F stands in for
+   black.                                                          */
+static uint8_t cand[64];
+static int     ncand;
+static const int (*col_dist)[64];
+
+static pthread_once_t colour_once = PTHREAD_ONCE_INIT;
+
+static void colour_tables_build(void) {
+    for (int i = 0; i < 64; i++) {
+        int lo = i & 0x0F;
+        if (lo == 0x0E || lo == 0x0F || i == 0x0D || i == 0x1D) continue;
+        cand[ncand++] = (uint8_t)i;
+    }
+    cand[ncand++] = 0x0F;
+    col_dist = palopt_dist_table();
+}
+
+static void colour_tables_init(void) {
+    pthread_once(&colour_once, colour_tables_build);
+}
+
+static int rgb_dist(const uint8_t a[3], const uint8_t b[3]) {
+    int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+    return 2 * dr * dr + 4 * dg * dg + 3 * db * db;   /* as palopt's table */
+}
+
+static uint8_t nearest_master(const uint8_t rgb[3]) {
+    int best = 0, bd = 1 << 30;
+    for (int i = 0; i < ncand; i++) {
+        int d = rgb_dist(rgb, NES_MASTER_RGB[cand[i]]);
+        if (d < bd) { bd = d; best = cand[i]; }
+    }
+    return (uint8_t)best;
+}
+
+/* ── Pipeline state ──────────────────────────────────────────── */
+
+typedef struct {
+    const Image *img;
+    uint8_t  q[IMG_H][IMG_W];         /* master index per pixel, NO_COL outside */
+    uint8_t  bg;                      /* backdrop colour                        */
+    PalOptInput  opt;                 /* per-block histograms + greedy seed     */
+    PalOptResult res;                 /* chosen palettes and block assignment   */
+    uint8_t  want[BLOCKS][3];         /* a block's top non-backdrop colours     */
+    int      nwant[BLOCKS];
+    uint8_t  px[IMPORT_CELLS][TILE_H][TILE_W];
+    uint8_t  enc[IMPORT_CELLS][16];
+} ImportCtx;
+
+/* 1: snap pixels, rows [y0, y1). */
+static void stage_snap(void *p, int y0, int y1) {
+    ImportCtx *c = p;
+    const Image *img = c->img;
+    for (int y = y0; y < y1; y++) {
+        const uint8_t *prev = NULL;
+        uint8_t last = NO_COL;
+        for (int x = 0; x < IMG_W; x++) {
+            if (x >= img->w || y >= img->h) { c->q[y][x] = NO_COL; continue; }
+            const uint8_t *rgb = img->rgb + ((size_t)y * img->w + x) * 3;
+            if (!prev || memcmp(rgb, prev, 3) != 0) last = nearest_master(rgb);
+            c->q[y][x] = last;
+            prev = rgb;
+        }
+    }
+}
+
+/* 3a: per-block histogram and wanted colours, blocks [b0, b1). */
+static void stage_hist(void *p, int b0, int b1) {
+    ImportCtx *c = p;
+    for (int b = b0; b < b1; b++) {
+        int *h = c->opt.hist[b];
+        memset(h, 0, sizeof(c->opt.hist[b]));
+        int by = b / BLK_W * 16, bx = b % BLK_W * 16;
+        for (int y = by; y < by + 16; y++)
+            for (int x = bx; x < bx + 16; x++) h[c->q[y][x]]++;
+
+        c->nwant[b] = 0;
+        for (int k = 0; k < 3; k++) {
+            int best = -1;
+            for (int i = 0; i < 64; i++) {
+                if (i == c->bg || h[i] == 0) continue;
+                bool taken = false;
+                for (int j = 0; j < c->nwant[b]; j++) taken |= c->want[b][j] == i;
+                if (!taken && (best < 0 || h[i] > h[best])) best = i;
+            }
+            if (best < 0) break;
+            c->want[b][c->nwant[b]++] = (uint8_t)best;
+        }
+    }
+}
+
+/* Palette p's colours (backdrop first) and how many there are. */
+static int pal_colours(const ImportCtx *c, int p, uint8_t out[4]) {
+    out[0] = c->bg;
+    int n = 1;
+    for (int k = 0; k < 3; k++)
+        if (c->res.col[p][k] != NO_COL) out[n++] = c->res.col[p][k];
+    return n;
+}
+
+/* 4: 2-bit pixels and planar bytes per tile, cells [t0, t1). */
+static void stage_tiles(void *p, int t0, int t1) {
+    ImportCtx *c = p;
+    for (int t = t0; t < t1; t++) {
+        int tx = t % COMPOSE_NT_W, ty = t / COMPOSE_NT_W;
+        uint8_t cols[4];
+        int n = pal_colours(c, c->res.block_pal[(ty / 2) * BLK_W + tx / 2], cols);
+        for (int y = 0; y < TILE_H; y++)
+            for (int x = 0; x < TILE_W; x++) {
+                uint8_t q = c->q[ty * TILE_H + y][tx * TILE_W + x];
+                int best = 0;
+                for (int k = 1; k < n; k++)
+                    if (col_dist[q][cols[k]] < col_dist[q][cols[best]]) best = k;
+                c->px[t][y][x] = (uint8_t)best;
+            }
+        export_encode_tile(c->px[t], c->enc[t]);
+    }
+}
+
+/* 3b: seed for the optimiser — merge the blocks' wanted sets into at
+   most four palettes.  Larger sets go first; a set joins the palette
+   it grows least while staying within three colours.              */
+static void seed_palettes(ImportCtx *c) {
+    uint8_t (*pal)[3] = c->opt.seed;
+    memset(c->opt.seed, NO_COL, sizeof(c->opt.seed));
+    c->opt.has_seed = true;
+    int npal = 0;
+
+    int order[BLOCKS];
+    for (int b = 0; b < BLOCKS; b++) order[b] = b;
+    for (int i = 1; i < BLOCKS; i++) {           /* stable insertion sort */
+        int b = order[i], j = i;
+        while (j > 0 && c->nwant[order[j - 1]] < c->nwant[b]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = b;
+    }
+
+    for (int i = 0; i < BLOCKS; i++) {
+        int b = order[i], best = -1, best_grow = 4;
+        for (int p = 0; p < npal; p++) {
+            uint8_t u[6];
+            int n = 0;
+            for (int k = 0; k < 3; k++) if (pal[p][k] != NO_COL) u[n++] = pal[p][k];
+            int had = n;
+            for (int k = 0; k < c->nwant[b]; k++) {
+                bool have = false;
+                for (int j = 0; j < n; j++) have |= u[j] == c->want[b][k];
+                if (!have) u[n++] = c->want[b][k];
+            }
+            if (n <= 3 && n - had < best_grow) { best_grow = n - had; best = p; }
+        }
+        if (best < 0 && npal < 4 && c->nwant[b] > 0) best = npal++;
+        if (best < 0) continue;               /* left to the optimiser */
+
+        for (int k = 0; k < c->nwant[b]; k++) {
+            int slot = -1;
+            for (int j = 0; j < 3; j++) {
+                if (pal[best][j] == c->want[b][k]) { slot = -2; break; }
+                if (pal[best][j] == NO_COL && slot == -1) slot = j;
+            }
+            if (slot >= 0) pal[best][slot] = c->want[b][k];
+        }
+    }
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int import_first_free(const ChrPage *chr, const UsageIndex *u) {
+    static const uint8_t blank[TILE_H][TILE_W];
+    for (int t = CHR_MAX_TILES - 1; t >= 0; t--)
+        if (u->count[t] > 0 || memcmp(chr->px[t], blank, sizeof(blank)) != 0)
+            return t + 1;
+    return 0;
+}
+
+static uint32_t hash16(const uint8_t k[16]) {
+    uint32_t h = 2166136261u;                 /* FNV-1a */
+    for (int i = 0; i < 16; i++) h = (h ^ k[i]) * 16777619u;
+    return h;
+}
+
+/* The slot holding k, or the empty slot where it belongs. */
+static unsigned find_slot(const int16_t table[DEDUP_TABLE],
+                          const uint8_t (*key)[16], const uint8_t k[16]) {
+    unsigned slot = hash16(k) & (DEDUP_TABLE - 1);
+    while (table[slot] >= 0 && memcmp(key[table[slot]], k, 16) != 0)
+        slot = (slot + 1) & (DEDUP_TABLE - 1);
+    return slot;
+}
+
+int import_build(const Image *img, const ChrPage *chr, int first_free,
+                 int budget_ms, ImportResult *r) {
+    ImportCtx *c = malloc(sizeof(*c));
+    uint8_t (*key)[16] = malloc(CHR_MAX_TILES * sizeof(*key));
+    if (!c || !key) { free(c); free(key); return -1; }
+    colour_tables_init();
+    c->img = img;
+
+    par_for(IMG_H, 16, stage_snap, c);
+
+    /* 2: backdrop = most common colour inside the image. */
+    int total[64] = { 0 };
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            if (c->q[y][x] != NO_COL) total[c->q[y][x]]++;
+    int bg = 0x0F;
+    for (int i = 0; i < 64; i++) if (total[i] > total[bg]) bg = i;
+    c->bg = (uint8_t)bg;
+    r->colours = 0;
+    for (int i = 0; i < 64; i++) r->colours += total[i] > 0;
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            if (c->q[y][x] == NO_COL) c->q[y][x] = c->bg;
+
+    par_for(BLOCKS, 8, stage_hist, c);
+    seed_palettes(c);
+    c->opt.nblocks  = BLOCKS;
+    c->opt.backdrop = c->bg;
+    if (palopt_run(&c->opt, budget_ms, &c->res) != 0) {
+        free(key);
+        free(c);
+        return -1;
+    }
+    par_for(IMPORT_CELLS, 32, stage_tiles, c);
+
+    PaletteState tmp;
+    palopt_store(&c->res, c->bg, &tmp, 0);
+    memcpy(r->bg, tmp.sub, sizeof(r->bg));
+    for (int b = 0; b < BLOCKS; b++)
+        r->attr[b / BLK_W][b % BLK_W] = c->res.block_pal[b];
+    r->lossy_blocks = c->res.lossy_blocks;
+    r->quality      = c->res.quality;
+    r->restarts     = c->res.restarts;
+
+    /* 5: dedupe.  key[t] holds the planar bytes of every tile in
+       the table, old (t < first_free) or new.                     */
+    if (first_free > CHR_MAX_TILES) first_free = CHR_MAX_TILES;
+    int16_t table[DEDUP_TABLE];
+    memset(table, 0xFF, sizeof(table));
+    for (int t = 0; t < first_free; t++) {
+        export_encode_tile(chr->px[t], key[t]);
+        unsigned slot = find_slot(table, key, key[t]);
+        if (table[slot] < 0) table[slot] = (int16_t)t;   /* keep the lowest copy */
+    }
+
+    int rc = 0;
+    r->first_new = first_free;
+    r->new_count = 0;
+    r->reused    = 0;
+    for (int cell = 0; cell < IMPORT_CELLS; cell++) {
+        int tx = cell % COMPOSE_NT_W, ty = cell / COMPOSE_NT_W;
+        unsigned slot = find_slot(table, key, c->enc[cell]);
+        int t = table[slot];
+        if (t < 0) {
+            t = first_free + r->new_count;
+            if (t >= CHR_MAX_TILES) { rc = -1; break; }
+            memcpy(key[t], c->enc[cell], 16);
+            memcpy(r->px[r->new_count], c->px[cell], sizeof(c->px[cell]));
+            r->tile_pal[r->new_count++] = r->attr[ty / 2][tx / 2];
+            table[slot] = (int16_t)t;
+        } else if (t < first_free) {
+            r->reused++;
+        }
+        r->nametable[ty][tx] = (uint16_t)t;
+    }
+
+    free(key);
+    free(c);
+    return rc;
+}
+
+void import_apply(const ImportResult *r, ChrPage *chr, PaletteState *pal,
+                  ComposeScene *sc) {
+    for (int p = 0; p < 4; p++) pal->sub[p] = r->bg[p];
+    for (int i = 0; i < r->new_count; i++) {
+        memcpy(chr->px[r->first_new + i], r->px[i], sizeof(r->px[i]));
+        pal->tile_pal[r->first_new + i] = r->tile_pal[i];
+    }
+    memcpy(sc->nametable, r->nametable, sizeof(sc->nametable));
+    memcpy(sc->attr, r->attr, sizeof(sc->attr));
+}
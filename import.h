@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include "chr.h"
+#include "compose.h"
+#include "usage.h"
+#include "image.h"
+
+/* ── Image → background import ───────────────────────────────────
+   The top-left 256×240 pixels of an image become one nametable:
+     1. every pixel snaps to the nearest NES master colour;
+     2. the most common colour becomes the shared backdrop;
+     3. each 16×16 attribute block wants its (up to) three most
+        common other colours; those sets, merged greedily, seed the
+        palette optimiser (palopt.h), which picks BG sub-palettes 0-3
+        and each block's palette within the time budget;
+     4. each block's tiles are mapped to 2-bit pixels;
+     5. tiles are deduplicated by their planar bytes against the
+        sheet and each other, and only new ones are appended.
+   Steps 1, 3, 4 and the optimiser's restarts run on a par_for pool.
+   Pixels outside a smaller image count as backdrop.               */
+
+#define IMPORT_CELLS (COMPOSE_NT_W * COMPOSE_NT_H)
+
+typedef struct {
+    SubPalette bg[4];                        /* new sub-palettes 0-3    */
+    uint16_t   nametable[COMPOSE_NT_H][COMPOSE_NT_W];
+    uint8_t    attr[15][16];
+    int        first_new;                    /* sheet slot of px[0]     */
+    int        new_count;
+    uint8_t    px[IMPORT_CELLS][TILE_H][TILE_W];
+    uint8_t    tile_pal[IMPORT_CELLS];       /* palette of each new tile */
+    int        reused;          /* cells matching a tile already in the sheet */
+    int        colours;         /* distinct NES colours after snapping        */
+    int        lossy_blocks;    /* blocks whose colours didn't all fit        */
+    double     quality;         /* % of pixels with their exact colour        */
+    int        restarts;        /* optimiser restarts within the budget       */
+} ImportResult;
+
+/* One past the last tile that is drawn on or referenced by a scene:
+   where imported tiles start.                                     */
+int  import_first_free(const ChrPage *chr, const UsageIndex *u);
+
+/* Run the pipeline without touching the sheet.  Tiles 0..first_free-1
+   of chr are candidates for reuse; budget_ms bounds the palette
+   search (0 = refine the greedy seed only).  Returns 0, or -1 if the
+   new tiles would run past CHR_MAX_TILES or memory runs out.      */
+int  import_build(const Image *img, const ChrPage *chr, int first_free,
+                  int budget_ms, ImportResult *r);
+
+#define IMPORT_BUDGET_MS       30   /* Ctrl+I / drop                  */
+#define IMPORT_BUDGET_LONG_MS 1000  /* Ctrl+Shift+I: thorough search  */
+
+/* Store a built result: BG palettes 0-3, new tiles and their
+   tile_pal entries, and sc's nametable and attributes (sprites are
+   kept).                                                          */
+void import_apply(const ImportResult *r, ChrPage *chr, PaletteState *pal,
+                  ComposeScene *sc);
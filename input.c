@@ -2,13 +2,36 @@
 #include "panel.h"
 #include "compose.h"
 #include "font.h"
+#include "compact.h"
+#include "replace.h"
+#include "import.h"
+#include "clip.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <stdbool.h>
 
 /* ── Undo / redo ring buffer ──────────────────────────────────── */
 
+/* Whole copies of scenes, with the scene count they go with.  Undo
+   and redo both swap them with the document's, so after an undo the
+   list holds the redo state and vice versa.                        */
+typedef struct {
+    int          index;
+    ComposeScene scene;
+} SceneSwap;
+
+typedef struct {
+    SceneSwap *swap;
+    int        count, cap;
+    int        scene_count;
+} SceneSwaps;
+
+/* Entries (about 70 KB each, mostly the ChrPage) are allocated when a
+   slot is first written, so a short session never pays for the full
+   ring.  Under the memory cap a new step reuses the oldest step's
+   entry instead: the history gets shorter, not the process bigger. */
 #define UNDO_MAX 64
 
 typedef struct {
@@ -16,65 +39,331 @@ typedef struct {
     PaletteState pal;
     ComposeScene scene;
     int          active_scene;
+    /* Set when the step that followed this snapshot was a compaction:
+       it renumbered tiles in every scene, not just the one saved
+       here, so undo/redo replay remap (or its inverse) on all.     */
+    bool         remapped;
+    uint16_t     remap[CHR_MAX_TILES];
+    /* Likewise for a find-and-replace: the edits it made in every
+       scene (count 0 = none).                                      */
+    ReplaceLog   replaced;
+    /* Other scenes the step changed wholesale (socket writes, hot
+       reload), registered through input_checkpoint_scene.          */
+    SceneSwaps   swapped;
 } UndoEntry;
 
-static UndoEntry undo_buf[UNDO_MAX];
+static UndoEntry *undo_buf[UNDO_MAX];   /* NULL until first used        */
+static UndoEntry *open_step;            /* input_checkpoint's, until the
+                                           history next changes         */
+static int undo_alloc = 0;   /* entries allocated                        */
 static int undo_head  = 0;   /* next write slot                          */
 static int undo_count = 0;   /* valid entries behind head                */
 static int undo_redo  = 0;   /* redo entries ahead of current position   */
 
-static void undo_push(const EditorState *s) {
-    UndoEntry *e = &undo_buf[undo_head];
+/* Change tracking for renderers that cache pixels: pixel edits stamp
+   just the tile, anything else bumps edit_rev (see main.h).        */
+static inline void mark_edited(EditorState *s) { s->edit_rev++; }
+void input_mark_tile(EditorState *s, int t) {
+    if (t < 0 || t >= CHR_MAX_TILES) return;
+    s->tile_rev[t] = ++s->chr_rev;
+    tilehash_update(&s->tilehash, &s->chr, t);
+}
+
+/* The active scene's nametable or sprite table changed: refresh its
+   entries in the usage index.                                      */
+static void scene_edited(EditorState *s) {
+    usage_sync_scene(&s->usage, s->compose.active_scene,
+                     compose_active(&s->compose));
+    mark_edited(s);
+}
+
+/* Refresh the usage entries of every scene a replace log touches. */
+static void replace_sync(EditorState *s, const ReplaceLog *log) {
+    static ComposeScene tmp;
+    int cur = -1;
+    for (int k = 0; k < log->count; k++) {
+        int i = log->edit[k].scene;
+        if (i == cur) continue;
+        cur = i;
+        const ComposeScene *sc = compose_peek(&s->compose, i, &tmp);
+        if (sc) usage_sync_scene(&s->usage, i, sc);
+    }
+}
+
+static void swaps_free(SceneSwaps *w) {
+    free(w->swap);
+    memset(w, 0, sizeof(*w));
+}
+
+/* Exchange the logged scenes (and scene count) with the document's. */
+static void swaps_apply(EditorState *s, SceneSwaps *w) {
+    if (w->count == 0) return;
+    ComposeData *d = &s->compose;
+    int n = d->scene_count;
+    if (w->scene_count > n) d->scene_count = w->scene_count;   /* to reach them all */
+    static ComposeScene tmp;
+    for (int k = 0; k < w->count; k++) {
+        ComposeScene *sc = compose_scene(d, w->swap[k].index);
+        tmp = *sc;
+        *sc = w->swap[k].scene;
+        w->swap[k].scene = tmp;
+    }
+    d->scene_count = w->scene_count;
+    w->scene_count = n;
+    compose_set_active(d, d->active_scene);
+    if (d->scene_count != n) {
+        usage_rebuild(&s->usage, d);
+        return;
+    }
+    for (int k = 0; k < w->count; k++)
+        usage_sync_scene(&s->usage, w->swap[k].index, compose_peek(d, w->swap[k].index, &tmp));
+}
+
+size_t input_undo_mem(int *steps) {
+    size_t n = (size_t)undo_alloc * sizeof(UndoEntry);
+    for (int i = 0; i < UNDO_MAX; i++)
+        if (undo_buf[i])
+            n += (size_t)undo_buf[i]->replaced.cap * sizeof(ReplaceEdit) +
+                 (size_t)undo_buf[i]->swapped.cap * sizeof(SceneSwap);
+    if (steps) *steps = undo_count;
+    return n;
+}
+
+void input_free(void) {
+    for (int i = 0; i < UNDO_MAX; i++) {
+        if (!undo_buf[i]) continue;
+        replace_log_free(&undo_buf[i]->replaced);
+        swaps_free(&undo_buf[i]->swapped);
+        free(undo_buf[i]);
+        undo_buf[i] = NULL;
+    }
+    undo_alloc = undo_head = undo_count = undo_redo = 0;
+    open_step  = NULL;
+}
+
+/* Would extra more bytes go over the cap?  Uses the last frame's
+   report for everything but the undo history itself.               */
+static bool over_cap(const EditorState *s, size_t extra) {
+    if (!s->mem_cap) return false;
+    size_t other = s->mem.total - s->mem.bytes[MEM_UNDO];
+    return other + input_undo_mem(NULL) + extra > s->mem_cap;
+}
+
+/* Slot i, allocated on first use.  Over the cap (or out of memory)
+   the oldest step's entry moves to slot i, as long as more than keep
+   steps remain.  The first step is always allocated.  NULL if there
+   is nothing to take.                                              */
+static UndoEntry *undo_slot(const EditorState *s, int i, int keep) {
+    if (undo_buf[i]) return undo_buf[i];
+    if (undo_count == 0 || !over_cap(s, sizeof(UndoEntry))) {
+        undo_buf[i] = calloc(1, sizeof(UndoEntry));
+        if (undo_buf[i]) { undo_alloc++; return undo_buf[i]; }
+    }
+    if (undo_count <= keep) return NULL;
+    int oldest = (undo_head - undo_count + UNDO_MAX) % UNDO_MAX;
+    UndoEntry *e = undo_buf[oldest];
+    undo_buf[oldest] = NULL;
+    undo_buf[i] = e;
+    undo_count--;
+    e->remapped = false;
+    replace_log_free(&e->replaced);
+    swaps_free(&e->swapped);
+    return e;
+}
+
+/* False if no snapshot could be stored (out of memory). */
+static bool undo_push(const EditorState *s) {
+    UndoEntry *e = undo_slot(s, undo_head, 0);
+    undo_redo = 0;   /* new action invalidates redo history */
+    open_step = NULL;
+    if (!e) return false;
     e->chr          = s->chr;
     e->pal          = s->pal;
     e->active_scene = s->compose.active_scene;
-    e->scene        = s->compose.scenes[s->compose.active_scene];
+    e->scene        = *compose_active(&s->compose);
+    e->remapped     = false;
+    replace_log_free(&e->replaced);
+    swaps_free(&e->swapped);
     undo_head = (undo_head + 1) % UNDO_MAX;
     if (undo_count < UNDO_MAX) undo_count++;
-    undo_redo = 0;   /* new action invalidates redo history */
+    return true;
 }
 
 static void undo_pop(EditorState *s) {
     if (undo_count == 0) return;
-    /* Save current state for redo before restoring */
+    open_step = NULL;
+    /* Save current state for redo before restoring (if there's room;
+       the step being undone is never given up for it). */
     int redo_slot = undo_head;
-    UndoEntry *re = &undo_buf[redo_slot];
-    re->chr          = s->chr;
-    re->pal          = s->pal;
-    re->active_scene = s->compose.active_scene;
-    re->scene        = s->compose.scenes[s->compose.active_scene];
+    UndoEntry *re = undo_slot(s, redo_slot, 1);
+    if (re) {
+        re->chr          = s->chr;
+        re->pal          = s->pal;
+        re->active_scene = s->compose.active_scene;
+        re->scene        = *compose_active(&s->compose);
+        if (undo_redo == 0) {                   /* nothing follows the tip */
+            re->remapped = false;
+            replace_log_free(&re->replaced);
+            swaps_free(&re->swapped);
+        }
+    }
 
     undo_head = (undo_head - 1 + UNDO_MAX) % UNDO_MAX;
     undo_count--;
-    undo_redo++;
+    undo_redo = re ? undo_redo + 1 : 0;
 
-    UndoEntry *e = &undo_buf[undo_head];
+    UndoEntry *e = undo_buf[undo_head];
+    if (e->remapped) {
+        uint16_t inv[CHR_MAX_TILES];
+        compact_invert(e->remap, inv);
+        compact_remap_scenes(&s->compose, &s->usage, inv);
+    }
+    replace_apply(&s->compose, &e->replaced, false);
+    swaps_apply(s, &e->swapped);
     s->chr = e->chr;
     s->pal = e->pal;
-    s->compose.scenes[e->active_scene] = e->scene;
+    *compose_scene(&s->compose, e->active_scene) = e->scene;
+    if (e->remapped)
+        usage_rebuild(&s->usage, &s->compose);
+    else
+        usage_sync_scene(&s->usage, e->active_scene, &e->scene);
+    replace_sync(s, &e->replaced);
+    tilehash_rebuild(&s->tilehash, &s->chr);
+    mark_edited(s);
 }
 
 static void undo_redo_pop(EditorState *s) {
     if (undo_redo == 0) return;
+    open_step = NULL;
     int redo_slot = (undo_head + 1) % UNDO_MAX;
-    UndoEntry *e = &undo_buf[redo_slot];
+    UndoEntry *e = undo_buf[redo_slot];
 
     /* Push current state so undo still works */
-    UndoEntry *cur = &undo_buf[undo_head];
+    UndoEntry *cur = undo_buf[undo_head];
     cur->chr          = s->chr;
     cur->pal          = s->pal;
     cur->active_scene = s->compose.active_scene;
-    cur->scene        = s->compose.scenes[s->compose.active_scene];
+    cur->scene        = *compose_active(&s->compose);
 
+    if (cur->remapped) compact_remap_scenes(&s->compose, &s->usage, cur->remap);
+    replace_apply(&s->compose, &cur->replaced, true);
+    swaps_apply(s, &cur->swapped);
     s->chr = e->chr;
     s->pal = e->pal;
-    s->compose.scenes[e->active_scene] = e->scene;
+    *compose_scene(&s->compose, e->active_scene) = e->scene;
+    if (cur->remapped)
+        usage_rebuild(&s->usage, &s->compose);
+    else
+        usage_sync_scene(&s->usage, e->active_scene, &e->scene);
+    replace_sync(s, &cur->replaced);
+    tilehash_rebuild(&s->tilehash, &s->chr);
+    mark_edited(s);
 
     undo_head = redo_slot;
     undo_count++;
     undo_redo--;
 }
 
+/* The entry undo_push just wrote. */
+static UndoEntry *undo_top(void) {
+    return undo_buf[(undo_head - 1 + UNDO_MAX) % UNDO_MAX];
+}
+
+bool input_checkpoint(const EditorState *s) {
+    if (!undo_push(s)) return false;
+    open_step = undo_top();
+    return true;
+}
+
+bool input_checkpoint_scene(const EditorState *s, int i) {
+    UndoEntry *e = open_step;
+    if (!e || i < 0 || i >= COMPOSE_MAX_SCENES) return false;
+    if (i == e->active_scene) return true;              /* in e->scene */
+    SceneSwaps *w = &e->swapped;
+    for (int k = 0; k < w->count; k++)
+        if (w->swap[k].index == i) return true;
+    if (w->count == w->cap) {
+        int cap = w->cap ? w->cap * 2 : 4;
+        SceneSwap *p = realloc(w->swap, (size_t)cap * sizeof(*p));
+        if (!p) return false;
+        w->swap = p;
+        w->cap  = cap;
+    }
+    if (w->count == 0) w->scene_count = s->compose.scene_count;
+    SceneSwap *sw = &w->swap[w->count];
+    const ComposeScene *sc = i < s->compose.scene_count
+                           ? compose_peek(&s->compose, i, &sw->scene) : NULL;
+    if (sc != &sw->scene) {
+        if (sc) sw->scene = *sc;
+        else    memset(&sw->scene, 0, sizeof(sw->scene));   /* none yet, or unreadable */
+    }
+    sw->index = i;
+    w->count++;
+    return true;
+}
+
+/* ── Tile compaction ──────────────────────────────────────────── */
+
+int input_compact(EditorState *s, int *moved) {
+    uint16_t map[CHR_MAX_TILES];
+    int span = compact_plan(&s->usage, map);
+    int n = 0;
+    for (int t = 0; t < CHR_MAX_TILES; t++)
+        if (map[t] != t && s->usage.count[t] > 0) n++;
+    if (moved) *moved = n;
+    if (compact_is_identity(map)) return span;
+
+    if (!undo_push(s)) return -1;
+    if (compact_remap_scenes(&s->compose, &s->usage, map) < 0) {
+        undo_head = (undo_head - 1 + UNDO_MAX) % UNDO_MAX;   /* drop it */
+        undo_count--;
+        return -1;
+    }
+    UndoEntry *e = undo_top();
+    e->remapped = true;
+    memcpy(e->remap, map, sizeof(map));
+
+    compact_apply_chr(&s->chr, &s->pal, map);
+    usage_rebuild(&s->usage, &s->compose);
+    tilehash_rebuild(&s->tilehash, &s->chr);
+    if (s->brush_tile >= 0 && s->brush_tile < CHR_MAX_TILES)
+        s->brush_tile = map[s->brush_tile];
+    s->anim_state   = ANIM_OFF;   /* frame range no longer means anything */
+    s->anim_playing = false;
+    mark_edited(s);
+    return span;
+}
+
+/* ── Tile find-and-replace ────────────────────────────────────── */
+
+int input_replace(EditorState *s, int find, int with, bool flips,
+                  int *skipped, int *scenes) {
+    ReplaceLog log;
+    int n = replace_tiles(&s->compose, &s->usage, &s->tilehash,
+                          find, with, flips, &log);
+    if (skipped) *skipped = n < 0 ? 0 : log.skipped;
+    if (scenes)  *scenes  = n < 0 ? 0 : log.scenes;
+    if (n <= 0) {
+        replace_log_free(&log);
+        return n;
+    }
+    /* Only now that something changed is a step pushed, so a replace
+       that finds nothing keeps the redo history and the oldest step.
+       The snapshot must see the scene as it was: step the edits back
+       for it, then forward again (or leave them undone if it fails). */
+    replace_apply(&s->compose, &log, false);
+    bool pushed = undo_push(s);
+    replace_apply(&s->compose, &log, pushed);
+    if (!pushed) {
+        replace_log_free(&log);
+        return -1;
+    }
+    undo_top()->replaced = log;
+    replace_sync(s, &log);
+    mark_edited(s);
+    return n;
+}
+
 /* ── Helpers ──────────────────────────────────────────────────── */
 
 static int wmod(int v, int n) { return ((v % n) + n) % n; }
@@ -139,40 +428,10 @@ static bool pal_paste_from_clipboard(EditorState *s) {
     undo_push(s);
     SubPalette *sp = &s->pal.sub[s->active_sub_pal];
     for (int i = 0; i < 4; i++) sp->idx[i] = bytes[i];
+    mark_edited(s);
     return true;
 }
 
-/* ── File-based clipboard (cross-instance copy/paste) ────────── */
-
-#define CLIPBOARD_PATH "/tmp/chrmaker_clipboard.bin"
-
-static void clipboard_save(const EditorState *s) {
-    FILE *f = fopen(CLIPBOARD_PATH, "wb");
-    if (!f) return;
-    uint8_t flag = s->clipboard_s16 ? 1 : 0;
-    fwrite(&flag, 1, 1, f);
-    int cnt = s->clipboard_s16 ? 4 : 1;
-    for (int p = 0; p < cnt; p++)
-        fwrite(s->clipboard[p], 1, TILE_H * TILE_W, f);
-    fclose(f);
-}
-
-static void clipboard_load(EditorState *s) {
-    FILE *f = fopen(CLIPBOARD_PATH, "rb");
-    if (!f) return;
-    uint8_t flag;
-    if (fread(&flag, 1, 1, f) != 1) { fclose(f); return; }
-    s->clipboard_s16 = (flag != 0);
-    int cnt = s->clipboard_s16 ? 4 : 1;
-    for (int p = 0; p < cnt; p++) {
-        if (fread(s->clipboard[p], 1, TILE_H * TILE_W, f) != TILE_H * TILE_W) {
-            fclose(f); return;
-        }
-    }
-    s->has_clipboard = true;
-    fclose(f);
-}
-
 static void anim_finish_pick(EditorState *s) {
     int stride = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) ? 4 : 1;
     if (s->anim_last < s->anim_first) {
@@ -276,22 +535,21 @@ static void focus_zoom_at(EditorState *s, int mx, int my, int new_focus) {
     clamp_pan(s);
 }
 
-/* Map screen coords to the tile index under the cursor.
-   In sprite-16 mode the tile layout is remapped, so screen position
-   does not equal (row*cols + col) — we compute the correct sub-tile. */
-static int screen_to_tile(const EditorState *s, int mx, int my) {
-    int nx = sx_to_nx(s, mx);
-    int ny = sy_to_ny(s, my);
+/* Tile shown at on-screen tile position (tx, ty).  In sprite-16 mode
+   the layout is remapped: each 2×2 block is one sprite, stored as four
+   consecutive tiles in column order.                                */
+static int tile_at(const EditorState *s, int tx, int ty) {
     if (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) {
         int sprite_cols = s->chr_cols / 2;
-        int sprite_x    = nx / (TILE_W * 2);
-        int sprite_y    = ny / (TILE_H * 2);
-        int sub_x       = (nx / TILE_W) % 2;   /* 0=left col, 1=right col */
-        int sub_y       = (ny / TILE_H) % 2;   /* 0=top row,  1=bot row   */
-        int p           = sub_x * 2 + sub_y;   /* matches render layout   */
-        return (sprite_y * sprite_cols + sprite_x) * 4 + p;
+        int p           = (tx % 2) * 2 + (ty % 2);   /* matches render layout */
+        return ((ty / 2) * sprite_cols + (tx / 2)) * 4 + p;
     }
-    return (ny / TILE_H) * s->chr_cols + (nx / TILE_W);
+    return ty * s->chr_cols + tx;
+}
+
+/* Map screen coords to the tile index under the cursor. */
+static int screen_to_tile(const EditorState *s, int mx, int my) {
+    return tile_at(s, sx_to_nx(s, mx) / TILE_W, sy_to_ny(s, my) / TILE_H);
 }
 
 /* Index of the top-left tile of the currently selected tile/sprite. */
@@ -301,6 +559,78 @@ static int sel_tile_idx(const EditorState *s) {
     return s->sel_tile_y * s->chr_cols + s->sel_tile_x;
 }
 
+/* The selection clipped to the sheet; false if none of it is left
+   (after a resize).                                                */
+static bool sel_rect(const EditorState *s, int *x0, int *y0, int *w, int *h) {
+    *x0 = s->sel_tile_x;
+    *y0 = s->sel_tile_y;
+    *w  = s->sel_w < s->chr_cols - *x0 ? s->sel_w : s->chr_cols - *x0;
+    *h  = s->sel_h < s->chr_rows - *y0 ? s->sel_h : s->chr_rows - *y0;
+    return *w > 0 && *h > 0;
+}
+
+/* Set (pal >= 0) or step by delta the sub-palette of every selected tile. */
+static void sel_pal(EditorState *s, int pal, int delta) {
+    int x0, y0, w, h;
+    if (!sel_rect(s, &x0, &y0, &w, &h)) return;
+    for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++) {
+            uint8_t *tp = &s->pal.tile_pal[tile_at(s, x, y)];
+            *tp = (uint8_t)(pal >= 0 ? pal : (*tp + PAL_COUNT + delta) % PAL_COUNT);
+        }
+}
+
+/* ── Tile clipboard (shared with other windows, see clip.h) ───── */
+
+/* Copy the selection as it appears on screen, so a block copied in
+   sprite-16 view pastes as the same picture into either view.      */
+static void tiles_copy(EditorState *s, bool cut) {
+    int x0, y0, w, h;
+    if (!sel_rect(s, &x0, &y0, &w, &h)) return;
+    if (cut) undo_push(s);
+    ClipData *d = clip_begin();
+    if (!d) return;
+    d->kind = CLIP_TILES;
+    d->w    = (uint16_t)w;
+    d->h    = (uint16_t)h;
+    int i = 0;
+    for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++, i++) {
+            int t = tile_at(s, x, y);
+            memcpy(d->px[i], s->chr.px[t], TILE_H * TILE_W);
+            d->tile_pal[i] = s->pal.tile_pal[t];
+        }
+    clip_end();
+    if (!cut) return;
+    for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++) {
+            int t = tile_at(s, x, y);
+            memset(s->chr.px[t], 0, TILE_H * TILE_W);
+            input_mark_tile(s, t);
+        }
+}
+
+/* Paste with the top-left at the selection's corner, clipped to the
+   sheet; the selection becomes the pasted block.                  */
+static void tiles_paste(EditorState *s) {
+    const ClipData *d = clip_get();
+    if (!d || d->kind != CLIP_TILES) return;
+    int w = d->w < s->chr_cols - s->sel_tile_x ? d->w : s->chr_cols - s->sel_tile_x;
+    int h = d->h < s->chr_rows - s->sel_tile_y ? d->h : s->chr_rows - s->sel_tile_y;
+    if (w <= 0 || h <= 0) return;
+    undo_push(s);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            int i = y * d->w + x;
+            int t = tile_at(s, s->sel_tile_x + x, s->sel_tile_y + y);
+            memcpy(s->chr.px[t], d->px[i], TILE_H * TILE_W);
+            s->pal.tile_pal[t] = d->tile_pal[i];
+            input_mark_tile(s, t);
+        }
+    s->sel_w = w;
+    s->sel_h = h;
+}
+
 /* ── Palette assignment ───────────────────────────────────────── */
 
 /* Assign the active sub-palette to the tile (or sprite) under (mx, my). */
@@ -334,6 +664,12 @@ static void input_begin(EditorState *s, InputType type) {
     } else if (type == INPUT_OPEN_PAL) {
         snprintf(s->input_buf, sizeof(s->input_buf), "%s", s->pal_path);
         s->input_len = (int)strlen(s->input_buf);
+    } else if (type == INPUT_IMPORT) {
+        snprintf(s->input_buf, sizeof(s->input_buf), "%s", s->import_path);
+        s->input_len = (int)strlen(s->input_buf);
+    } else if (type == INPUT_REPLACE) {
+        snprintf(s->input_buf, sizeof(s->input_buf), "%d ", s->brush_tile);
+        s->input_len = (int)strlen(s->input_buf);
     }
 
     SDL_StartTextInput();
@@ -355,6 +691,19 @@ static void input_confirm(EditorState *s) {
     } else if (s->input_type == INPUT_OPEN_PAL) {
         snprintf(s->pal_path, sizeof(s->pal_path), "%s", s->input_buf);
         s->want_load_pal = true;
+    } else if (s->input_type == INPUT_IMPORT) {
+        snprintf(s->import_path, sizeof(s->import_path), "%s", s->input_buf);
+        s->want_import = true;
+    } else if (s->input_type == INPUT_REPLACE) {
+        int from = 0, to = 0;
+        if (sscanf(s->input_buf, "%d %d", &from, &to) == 2
+            && from >= 0 && from < CHR_MAX_TILES
+            && to   >= 0 && to   < CHR_MAX_TILES && from != to) {
+            s->replace_from = from;
+            s->replace_to   = to;
+            s->want_replace = true;
+        }
+        /* silently discard invalid input */
     } else {
         snprintf(s->current_path, sizeof(s->current_path), "%s", s->input_buf);
         if (s->input_type == INPUT_SAVE_AS) s->want_save = true;
@@ -370,6 +719,26 @@ static void input_cancel(EditorState *s) {
     SDL_StopTextInput();
 }
 
+/* Dropped images are imported into the active scene; anything else
+   is opened as CHR.                                                */
+static void drop_file(EditorState *s, const char *path) {
+    static const char *const IMG_EXT[] = { ".bmp", ".png", ".ppm", ".pnm" };
+    const char *dot = strrchr(path, '.');
+    for (size_t i = 0; dot && i < sizeof(IMG_EXT) / sizeof(IMG_EXT[0]); i++) {
+        bool match = strlen(dot) == 4;
+        for (int k = 0; match && k < 4; k++)
+            match = tolower((unsigned char)dot[k]) == IMG_EXT[i][k];
+        if (match) {
+            snprintf(s->import_path, sizeof(s->import_path), "%s", path);
+            s->import_budget_ms = IMPORT_BUDGET_MS;
+            s->want_import = true;
+            return;
+        }
+    }
+    snprintf(s->current_path, sizeof(s->current_path), "%s", path);
+    s->want_load = true;
+}
+
 /* ── Tile edit paint (enlarged tile in panel) ─────────────────── */
 
 static void tile_edit_paint(EditorState *s, int px, int py) {
@@ -398,9 +767,11 @@ static void tile_edit_paint(EditorState *s, int px, int py) {
         int p     = sub_x * 2 + sub_y;
         int tile  = sel_tile_idx(s) + p;
         s->chr.px[tile][ly % TILE_H][lx % TILE_W] = (uint8_t)s->color;
+        input_mark_tile(s, tile);
     } else {
         int tile = sel_tile_idx(s);
         s->chr.px[tile][ly][lx] = (uint8_t)s->color;
+        input_mark_tile(s, tile);
     }
 }
 
@@ -451,24 +822,36 @@ static void paint_at(EditorState *s, int mx, int my) {
     }
 
     s->chr.px[tile][local_y][local_x] = (uint8_t)s->color;
+    input_mark_tile(s, tile);
 }
 
 /* ── Tile selection ───────────────────────────────────────────── */
 
-static void select_tile_under_cursor(EditorState *s) {
+/* T selects the tile (sprite, in sprite-16 mode) under the cursor;
+   with extend, the selection grows to the rectangle between it and
+   the tile T was last pressed on.                                  */
+static void select_tile_under_cursor(EditorState *s, bool extend) {
     int mx = s->mouse_x, my = s->mouse_y;
     if (mx < 0 || mx >= s->canvas_w || my < 0 || my >= s->canvas_h) return;
-    int nx = sx_to_nx(s, mx);
-    int ny = sy_to_ny(s, my);
+    int tx = sx_to_nx(s, mx) / TILE_W;
+    int ty = sy_to_ny(s, my) / TILE_H;
+    int unit = 1;
     if (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) {
         /* Snap to sprite (2-tile) boundary so sel_tile_x/y are always even. */
-        s->sel_tile_x = (nx / (TILE_W * 2)) * 2;
-        s->sel_tile_y = (ny / (TILE_H * 2)) * 2;
-    } else {
-        s->sel_tile_x = nx / TILE_W;
-        s->sel_tile_y = ny / TILE_H;
+        tx = tx / 2 * 2;
+        ty = ty / 2 * 2;
+        unit = 2;
+    }
+    if (!extend || !s->tile_mode) {
+        s->sel_anchor_x = tx;
+        s->sel_anchor_y = ty;
     }
-    s->tile_mode = true;
+    int ax = s->sel_anchor_x, ay = s->sel_anchor_y;
+    s->sel_tile_x = ax < tx ? ax : tx;
+    s->sel_tile_y = ay < ty ? ay : ty;
+    s->sel_w      = (ax < tx ? tx - ax : ax - tx) + unit;
+    s->sel_h      = (ay < ty ? ty - ay : ay - ty) + unit;
+    s->tile_mode  = true;
 }
 
 /* ── Panel click ──────────────────────────────────────────────── */
@@ -486,12 +869,7 @@ static void panel_click(EditorState *s, int px, int py) {
         int pal_idx = s->palette_scroll + row;
         if (pal_idx < 0 || pal_idx >= PAL_COUNT) return;
         s->active_sub_pal = pal_idx;
-        if (s->tile_mode) {
-            int base = sel_tile_idx(s);
-            int cnt  = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) ? 4 : 1;
-            for (int p = 0; p < cnt; p++)
-                s->pal.tile_pal[base + p] = (uint8_t)pal_idx;
-        }
+        if (s->tile_mode) sel_pal(s, pal_idx, 0);
         return;
     }
 
@@ -505,9 +883,11 @@ static void panel_click(EditorState *s, int px, int py) {
         px >= nes_x0 && px < nes_x0 + PANEL_NES_COLS * nes_step) {
         int col = (px - nes_x0) / nes_step;
         int row = (py - PANEL_NES_Y0) / nes_step;
-        if (col >= 0 && col < PANEL_NES_COLS && row >= 0 && row < PANEL_NES_ROWS)
+        if (col >= 0 && col < PANEL_NES_COLS && row >= 0 && row < PANEL_NES_ROWS) {
             s->pal.sub[s->active_sub_pal].idx[s->active_swatch] =
                 (uint8_t)(row * PANEL_NES_COLS + col);
+            mark_edited(s);
+        }
         return;
     }
 
@@ -556,7 +936,7 @@ static void panel_click(EditorState *s, int px, int py) {
 
 /* ── Compose mode: get active scene ───────────────────────────── */
 static ComposeScene *active_scene(EditorState *s) {
-    return &s->compose.scenes[s->compose.active_scene];
+    return compose_scene(&s->compose, s->compose.active_scene);
 }
 
 /* ── Compose mode: focus zoom / pan helpers ───────────────────── */
@@ -696,6 +1076,7 @@ static void compose_panel_click(EditorState *s, int px, int py) {
             int dst = s->active_sub_pal & 7;
             undo_push(s);
             s->pal.sub[dst] = s->pal.sub[pal_idx];
+            mark_edited(s);
         }
         return;
     }
@@ -709,6 +1090,110 @@ static void compose_panel_click(EditorState *s, int px, int py) {
     }
 }
 
+/* ── Compose: cell clipboard ──────────────────────────────────── */
+
+/* T / Shift+T over the canvas, as in paint mode. */
+static void compose_select_cells(EditorState *s, bool extend) {
+    int cx = s->compose_hover_x, cy = s->compose_hover_y;
+    if (cx < 0 || cy < 0) return;
+    if (!extend || s->cmp_sel_w <= 0) {
+        s->cmp_sel_ax = cx;
+        s->cmp_sel_ay = cy;
+    }
+    int ax = s->cmp_sel_ax, ay = s->cmp_sel_ay;
+    s->cmp_sel_x = ax < cx ? ax : cx;
+    s->cmp_sel_y = ay < cy ? ay : cy;
+    s->cmp_sel_w = (ax < cx ? cx - ax : ax - cx) + 1;
+    s->cmp_sel_h = (ay < cy ? cy - ay : ay - cy) + 1;
+}
+
+static bool spr_in_cells(const ComposeSprite *sp, int x0, int y0, int w, int h) {
+    return sp->x >= x0 * TILE_W && sp->x < (x0 + w) * TILE_W &&
+           sp->y >= y0 * TILE_H && sp->y < (y0 + h) * TILE_H;
+}
+
+/* Copy the selected cells (the one under the cursor if none), their
+   attribute palettes and the sprites whose origin is inside them.  */
+static void compose_copy_cells(EditorState *s, bool cut) {
+    int x0 = s->cmp_sel_x, y0 = s->cmp_sel_y, w = s->cmp_sel_w, h = s->cmp_sel_h;
+    if (w <= 0) {
+        if (s->compose_hover_x < 0 || s->compose_hover_y < 0) return;
+        x0 = s->compose_hover_x; y0 = s->compose_hover_y; w = h = 1;
+    }
+    if (cut) undo_push(s);
+    const ComposeScene *cur = compose_active(&s->compose);
+    ClipData *d = clip_begin();
+    if (!d) return;
+    d->kind = CLIP_CELLS;
+    d->w    = (uint16_t)w;
+    d->h    = (uint16_t)h;
+    int i = 0;
+    for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++, i++) {
+            d->cell_tile[i] = cur->nametable[y][x];
+            d->cell_attr[i] = cur->attr[y / 2][x / 2] & 3;
+        }
+    d->sprite_count = 0;
+    for (int k = 0; k < cur->sprite_count; k++) {
+        const ComposeSprite *sp = &cur->sprites[k];
+        if (!spr_in_cells(sp, x0, y0, w, h)) continue;
+        ComposeSprite *o = &d->sprites[d->sprite_count++];
+        *o = *sp;
+        o->x = (uint8_t)(sp->x - x0 * TILE_W);
+        o->y = (uint8_t)(sp->y - y0 * TILE_H);
+    }
+    clip_end();
+    if (!cut) return;
+
+    ComposeScene *sc = active_scene(s);
+    for (int y = y0; y < y0 + h; y++)
+        for (int x = x0; x < x0 + w; x++)
+            sc->nametable[y][x] = 0;
+    int n = 0;
+    for (int k = 0; k < sc->sprite_count; k++)
+        if (!spr_in_cells(&sc->sprites[k], x0, y0, w, h))
+            sc->sprites[n++] = sc->sprites[k];
+    sc->sprite_count = n;
+    s->compose_spr_sel = -1;
+    scene_edited(s);
+}
+
+/* Paste at the cell under the cursor (the selection's corner if the
+   cursor is off the canvas), clipped to the screen.  Attributes are
+   per 2×2 block, so paste at an even cell to keep them lined up.
+   Sprites are added while there is room.                          */
+static void compose_paste_cells(EditorState *s) {
+    const ClipData *d = clip_get();
+    if (!d || d->kind != CLIP_CELLS) return;
+    int x0 = s->compose_hover_x, y0 = s->compose_hover_y;
+    if (x0 < 0 || y0 < 0) {
+        if (s->cmp_sel_w <= 0) return;
+        x0 = s->cmp_sel_x; y0 = s->cmp_sel_y;
+    }
+    int w = d->w < COMPOSE_NT_W - x0 ? d->w : COMPOSE_NT_W - x0;
+    int h = d->h < COMPOSE_NT_H - y0 ? d->h : COMPOSE_NT_H - y0;
+    undo_push(s);
+    ComposeScene *sc = active_scene(s);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            int i = y * d->w + x;
+            sc->nametable[y0 + y][x0 + x] = d->cell_tile[i];
+            sc->attr[(y0 + y) / 2][(x0 + x) / 2] = d->cell_attr[i];
+        }
+    for (int k = 0; k < d->sprite_count && sc->sprite_count < COMPOSE_MAX_SPR; k++) {
+        int x = d->sprites[k].x + x0 * TILE_W;
+        int y = d->sprites[k].y + y0 * TILE_H;
+        if (x > 255 || y > 239) continue;
+        ComposeSprite *sp = &sc->sprites[sc->sprite_count++];
+        *sp   = d->sprites[k];
+        sp->x = (uint8_t)x;
+        sp->y = (uint8_t)y;
+    }
+    s->cmp_sel_x = x0; s->cmp_sel_y = y0;
+    s->cmp_sel_w = w;  s->cmp_sel_h = h;
+    scene_edited(s);
+}
+
 /* ── Compose mode: canvas click ──────────────────────────────── */
 static void compose_canvas_click(EditorState *s, int mx, int my, bool left, bool shift) {
     int nx = cmp_sx_to_nx(s, mx);
@@ -717,10 +1202,13 @@ static void compose_canvas_click(EditorState *s, int mx, int my, bool left, bool
     int tile_y = ny / TILE_H;
     if (tile_x < 0 || tile_x >= COMPOSE_NT_W || tile_y < 0 || tile_y >= COMPOSE_NT_H) return;
 
-    ComposeScene *sc = active_scene(s);
+    /* Clicks that only look (eyedropper, picking a sprite) leave the
+       scene clean; it is taken for writing once something changes.  */
+    const ComposeScene *cur = compose_active(&s->compose);
 
     if (s->compose_layer == COMPOSE_BG) {
         if (left) {
+            ComposeScene *sc = active_scene(s);
             if (shift) {
                 /* Erase: set tile to 0 */
                 sc->nametable[tile_y][tile_x] = 0;
@@ -733,13 +1221,14 @@ static void compose_canvas_click(EditorState *s, int mx, int my, bool left, bool
                 if (ay < 15 && ax < 16)
                     sc->attr[ay][ax] = (uint8_t)(s->active_sub_pal & 3);
             }
+            scene_edited(s);
         } else {
             /* Right-click: eyedropper — pick tile + palette */
-            s->brush_tile = sc->nametable[tile_y][tile_x];
+            s->brush_tile = cur->nametable[tile_y][tile_x];
             int ax = tile_x / 2;
             int ay = tile_y / 2;
             if (ay < 15 && ax < 16)
-                s->active_sub_pal = sc->attr[ay][ax] & 3;
+                s->active_sub_pal = cur->attr[ay][ax] & 3;
         }
     } else {
         /* Sprite layer */
@@ -748,8 +1237,8 @@ static void compose_canvas_click(EditorState *s, int mx, int my, bool left, bool
 
         if (left) {
             /* Check if clicking on existing sprite */
-            for (int i = sc->sprite_count - 1; i >= 0; i--) {
-                ComposeSprite *sp = &sc->sprites[i];
+            for (int i = cur->sprite_count - 1; i >= 0; i--) {
+                const ComposeSprite *sp = &cur->sprites[i];
                 int spr_w = sp->s16 ? 16 : 8;
                 int spr_h = sp->s16 ? 16 : 8;
                 if (px_x >= sp->x && px_x < sp->x + spr_w &&
@@ -762,7 +1251,8 @@ static void compose_canvas_click(EditorState *s, int mx, int my, bool left, bool
                 }
             }
             /* Place new sprite */
-            if (sc->sprite_count < COMPOSE_MAX_SPR) {
+            if (cur->sprite_count < COMPOSE_MAX_SPR) {
+                ComposeScene *sc = active_scene(s);
                 int idx = sc->sprite_count++;
                 ComposeSprite *sp = &sc->sprites[idx];
                 sp->x       = (uint8_t)(px_x < 255 ? px_x : 255);
@@ -774,21 +1264,24 @@ static void compose_canvas_click(EditorState *s, int mx, int my, bool left, bool
                 sp->behind_bg = false;
                 sp->s16     = s->brush_s16;
                 s->compose_spr_sel = idx;
+                scene_edited(s);
             }
         } else {
             /* Right-click: delete sprite under cursor */
-            for (int i = sc->sprite_count - 1; i >= 0; i--) {
-                ComposeSprite *sp = &sc->sprites[i];
+            for (int i = cur->sprite_count - 1; i >= 0; i--) {
+                const ComposeSprite *sp = &cur->sprites[i];
                 int spr_w = sp->s16 ? 16 : 8;
                 int spr_h = sp->s16 ? 16 : 8;
                 if (px_x >= sp->x && px_x < sp->x + spr_w &&
                     px_y >= sp->y && px_y < sp->y + spr_h) {
                     /* Remove by shifting */
+                    ComposeScene *sc = active_scene(s);
                     for (int j = i; j < sc->sprite_count - 1; j++)
                         sc->sprites[j] = sc->sprites[j + 1];
                     sc->sprite_count--;
                     if (s->compose_spr_sel == i) s->compose_spr_sel = -1;
                     else if (s->compose_spr_sel > i) s->compose_spr_sel--;
+                    scene_edited(s);
                     break;
                 }
             }
@@ -804,11 +1297,20 @@ static void compose_input(const SDL_Event *e, EditorState *s) {
     switch (e->type) {
         case SDL_QUIT: s->running = false; break;
 
+        case SDL_DROPFILE: {
+            char *dropped = e->drop.file;
+            drop_file(s, dropped);
+            SDL_free(dropped);
+            break;
+        }
+
         case SDL_KEYDOWN:
             switch (e->key.keysym.sym) {
                 case SDLK_ESCAPE:
                     if (s->compose_show_help)
                         s->compose_show_help = false;
+                    else if (s->cmp_sel_w > 0)
+                        s->cmp_sel_w = 0;
                     else if (s->compose_spr_sel >= 0)
                         s->compose_spr_sel = -1;
                     else {
@@ -837,7 +1339,10 @@ static void compose_input(const SDL_Event *e, EditorState *s) {
                 case SDLK_b: s->compose_layer = COMPOSE_BG;  break;
                 case SDLK_l: s->compose_layer = COMPOSE_SPR; break;
                 case SDLK_h:
-                    if (s->compose_layer == COMPOSE_SPR)
+                    if (e->key.keysym.mod & KMOD_CTRL) {
+                        s->replace_flips = (e->key.keysym.mod & KMOD_SHIFT) != 0;
+                        input_begin(s, INPUT_REPLACE);
+                    } else if (s->compose_layer == COMPOSE_SPR)
                         s->brush_hflip = !s->brush_hflip;
                     break;
                 case SDLK_f:
@@ -880,20 +1385,19 @@ static void compose_input(const SDL_Event *e, EditorState *s) {
                     s->pan_y = 0;
                     break;
                 case SDLK_PAGEUP:
-                    if (s->compose.active_scene > 0) s->compose.active_scene--;
+                    if (s->compose.active_scene > 0)
+                        compose_set_active(&s->compose, s->compose.active_scene - 1);
                     break;
                 case SDLK_PAGEDOWN:
                     if (s->compose.active_scene < s->compose.scene_count - 1)
-                        s->compose.active_scene++;
+                        compose_set_active(&s->compose, s->compose.active_scene + 1);
                     break;
+                case SDLK_u: s->show_usage = !s->show_usage; break;
                 case SDLK_n:
-                    if (e->key.keysym.mod & KMOD_CTRL) {
-                        if (s->compose.scene_count < COMPOSE_MAX_SCENES) {
-                            int idx = s->compose.scene_count++;
-                            memset(&s->compose.scenes[idx], 0, sizeof(ComposeScene));
-                            s->compose.active_scene = idx;
-                        }
-                    }
+                    if ((e->key.keysym.mod & KMOD_CTRL) &&
+                        !over_cap(s, sizeof(ComposeScene) + sizeof(UsageScene)) &&
+                        compose_add_scene(&s->compose) >= 0)
+                        scene_edited(s);
                     break;
                 case SDLK_z:
                     if (e->key.keysym.mod & KMOD_CTRL) {
@@ -911,16 +1415,42 @@ static void compose_input(const SDL_Event *e, EditorState *s) {
                     if ((e->key.keysym.mod & KMOD_CTRL) &&
                         (e->key.keysym.mod & KMOD_SHIFT))
                         pal_copy_to_clipboard(s);
+                    else if (e->key.keysym.mod & KMOD_CTRL)
+                        compose_copy_cells(s, false);
+                    break;
+                case SDLK_x:
+                    if (e->key.keysym.mod & KMOD_CTRL)
+                        compose_copy_cells(s, true);
                     break;
                 case SDLK_v:
                     if ((e->key.keysym.mod & KMOD_CTRL) &&
                         (e->key.keysym.mod & KMOD_SHIFT))
                         pal_paste_from_clipboard(s);
+                    else if (e->key.keysym.mod & KMOD_CTRL)
+                        compose_paste_cells(s);
+                    break;
+                case SDLK_t:
+                    compose_select_cells(s, (e->key.keysym.mod & KMOD_SHIFT) != 0);
                     break;
                 case SDLK_s:
                     if (e->key.keysym.mod & KMOD_CTRL)
                         s->want_save_scene = true;
                     break;
+                case SDLK_i:
+                    if (e->key.keysym.mod & KMOD_CTRL) {
+                        s->import_budget_ms = (e->key.keysym.mod & KMOD_SHIFT)
+                                            ? IMPORT_BUDGET_LONG_MS : IMPORT_BUDGET_MS;
+                        input_begin(s, INPUT_IMPORT);
+                    }
+                    break;
+                case SDLK_e:
+                    if (e->key.keysym.mod & KMOD_CTRL) {
+                        if (e->key.keysym.mod & KMOD_SHIFT)
+                            s->want_export_packed = true;
+                        else
+                            s->want_export_nes = true;
+                    }
+                    break;
                 case SDLK_DELETE:
                     if (s->compose_spr_sel >= 0) {
                         undo_push(s);
@@ -930,30 +1460,31 @@ static void compose_input(const SDL_Event *e, EditorState *s) {
                             sc->sprites[j] = sc->sprites[j + 1];
                         sc->sprite_count--;
                         s->compose_spr_sel = -1;
+                        scene_edited(s);
                     }
                     break;
                 case SDLK_UP:
                     if (s->compose_spr_sel >= 0) {
                         ComposeSprite *sp = &active_scene(s)->sprites[s->compose_spr_sel];
-                        if (sp->y > 0) sp->y--;
+                        if (sp->y > 0) { sp->y--; mark_edited(s); }
                     }
                     break;
                 case SDLK_DOWN:
                     if (s->compose_spr_sel >= 0) {
                         ComposeSprite *sp = &active_scene(s)->sprites[s->compose_spr_sel];
-                        if (sp->y < 239) sp->y++;
+                        if (sp->y < 239) { sp->y++; mark_edited(s); }
                     }
                     break;
                 case SDLK_LEFT:
                     if (s->compose_spr_sel >= 0) {
                         ComposeSprite *sp = &active_scene(s)->sprites[s->compose_spr_sel];
-                        if (sp->x > 0) sp->x--;
+                        if (sp->x > 0) { sp->x--; mark_edited(s); }
                     }
                     break;
                 case SDLK_RIGHT:
                     if (s->compose_spr_sel >= 0) {
                         ComposeSprite *sp = &active_scene(s)->sprites[s->compose_spr_sel];
-                        if (sp->x < 255) sp->x++;
+                        if (sp->x < 255) { sp->x++; mark_edited(s); }
                     }
                     break;
                 default: break;
@@ -1106,6 +1637,7 @@ static void compose_input(const SDL_Event *e, EditorState *s) {
                 ComposeSprite *sp = &active_scene(s)->sprites[s->compose_spr_drag];
                 sp->x = (uint8_t)px_x;
                 sp->y = (uint8_t)px_y;
+                mark_edited(s);
             }
             /* BG tile painting while dragging */
             else if (s->mouse_down && s->compose_layer == COMPOSE_BG &&
@@ -1181,8 +1713,7 @@ void input_handle(const SDL_Event *e, EditorState *s) {
 
         case SDL_DROPFILE: {
             char *dropped = e->drop.file;
-            snprintf(s->current_path, sizeof(s->current_path), "%s", dropped);
-            s->want_load = true;
+            drop_file(s, dropped);
             SDL_free(dropped);
             break;
         }
@@ -1230,15 +1761,7 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                         (e->key.keysym.mod & KMOD_SHIFT)) {
                         pal_paste_from_clipboard(s);
                     } else if ((e->key.keysym.mod & KMOD_CTRL) && s->tile_mode) {
-                        clipboard_load(s);  /* refresh from file (cross-instance) */
-                        if (s->has_clipboard) {
-                            undo_push(s);
-                            int base = sel_tile_idx(s);
-                            bool s16 = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2);
-                            int cnt  = (s16 && s->clipboard_s16) ? 4 : 1;
-                            for (int p = 0; p < cnt; p++)
-                                memcpy(s->chr.px[base + p], s->clipboard[p], TILE_H * TILE_W);
-                        }
+                        tiles_paste(s);
                     } else if (!(e->key.keysym.mod & KMOD_CTRL)) {
                         s->view_mode = (s->view_mode == VIEW_GRAYSCALE)
                                      ? VIEW_NES_COLOR : VIEW_GRAYSCALE;
@@ -1268,8 +1791,24 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                     if (e->key.keysym.mod & KMOD_CTRL)
                         input_begin(s, INPUT_OPEN);
                     break;
+                case SDLK_i:
+                    if (e->key.keysym.mod & KMOD_CTRL) {
+                        s->import_budget_ms = (e->key.keysym.mod & KMOD_SHIFT)
+                                            ? IMPORT_BUDGET_LONG_MS : IMPORT_BUDGET_MS;
+                        input_begin(s, INPUT_IMPORT);
+                    }
+                    break;
+                case SDLK_h:
+                    if (e->key.keysym.mod & KMOD_CTRL) {
+                        s->replace_flips = (e->key.keysym.mod & KMOD_SHIFT) != 0;
+                        input_begin(s, INPUT_REPLACE);
+                    }
+                    break;
                 case SDLK_r:
-                    if (e->key.keysym.mod & KMOD_CTRL)
+                    if ((e->key.keysym.mod & KMOD_CTRL) &&
+                        (e->key.keysym.mod & KMOD_SHIFT))
+                        s->want_compact = true;
+                    else if (e->key.keysym.mod & KMOD_CTRL)
                         input_begin(s, INPUT_RESIZE);
                     break;
                 case SDLK_c:
@@ -1277,33 +1816,15 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                         (e->key.keysym.mod & KMOD_SHIFT)) {
                         pal_copy_to_clipboard(s);
                     } else if ((e->key.keysym.mod & KMOD_CTRL) && s->tile_mode) {
-                        int base = sel_tile_idx(s);
-                        bool s16 = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2);
-                        int cnt  = s16 ? 4 : 1;
-                        for (int p = 0; p < cnt; p++)
-                            memcpy(s->clipboard[p], s->chr.px[base + p], TILE_H * TILE_W);
-                        s->clipboard_s16  = s16;
-                        s->has_clipboard  = true;
-                        clipboard_save(s);
+                        tiles_copy(s, false);
                     } else if (!(e->key.keysym.mod & (KMOD_CTRL|KMOD_ALT|KMOD_GUI))) {
                         s->show_preview = !s->show_preview;
                         s->want_resize  = true;
                     }
                     break;
                 case SDLK_x:
-                    if ((e->key.keysym.mod & KMOD_CTRL) && s->tile_mode) {
-                        undo_push(s);
-                        int base = sel_tile_idx(s);
-                        bool s16 = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2);
-                        int cnt  = s16 ? 4 : 1;
-                        for (int p = 0; p < cnt; p++) {
-                            memcpy(s->clipboard[p], s->chr.px[base + p], TILE_H * TILE_W);
-                            memset(s->chr.px[base + p], 0, TILE_H * TILE_W);
-                        }
-                        s->clipboard_s16  = s16;
-                        s->has_clipboard  = true;
-                        clipboard_save(s);
-                    }
+                    if ((e->key.keysym.mod & KMOD_CTRL) && s->tile_mode)
+                        tiles_copy(s, true);
                     break;
 
 
@@ -1337,6 +1858,15 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                 }
 
                 case SDLK_n: s->show_addr = !s->show_addr; break;
+                case SDLK_u: s->show_usage = !s->show_usage; break;
+                case SDLK_d:
+                    if (e->key.keysym.mod & KMOD_CTRL)
+                        s->want_near_report = true;
+                    else if (e->key.keysym.mod & KMOD_SHIFT)
+                        s->show_nearest = !s->show_nearest;
+                    else
+                        s->dup_view = (s->dup_view + 1) % 3;
+                    break;
 
                 case SDLK_a:
                     if (s->anim_state == ANIM_OFF)
@@ -1373,7 +1903,7 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                     if (!e->key.repeat) s->space_held = true;
                     if (s->anim_state == ANIM_ACTIVE && !e->key.repeat) {
                         s->anim_playing = !s->anim_playing;
-                        s->anim_last_tick = SDL_GetTicks();
+                        s->anim_last_tick = s->ticks;
                     }
                     break;
                 case SDLK_f:
@@ -1390,7 +1920,27 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                         s->anim_speed++;
                     break;
 
-                case SDLK_t: select_tile_under_cursor(s); break;
+                case SDLK_k:
+                    if (!s->show_preview) break;
+                    if (e->key.keysym.mod & KMOD_SHIFT) {
+                        s->scroll_vertical = !s->scroll_vertical;
+                        s->scroll_pos      = 0;
+                    } else {
+                        s->scroll_play = !s->scroll_play;
+                    }
+                    s->scroll_t0     = s->ticks;
+                    s->scroll_frames = 0;
+                    break;
+                case SDLK_j:
+                    if (s->show_preview && s->scroll_speed > 1) s->scroll_speed--;
+                    break;
+                case SDLK_l:
+                    if (s->show_preview && s->scroll_speed < 8) s->scroll_speed++;
+                    break;
+
+                case SDLK_t:
+                    select_tile_under_cursor(s, (e->key.keysym.mod & KMOD_SHIFT) != 0);
+                    break;
                 case SDLK_w:
                     s->wrap_mode = (WrapMode)((s->wrap_mode + 1) % 4);
                     break;
@@ -1398,21 +1948,13 @@ void input_handle(const SDL_Event *e, EditorState *s) {
                 case SDLK_LEFTBRACKET:
                     if (s->tile_mode) {
                         undo_push(s);
-                        int base = sel_tile_idx(s);
-                        int cnt  = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) ? 4 : 1;
-                        for (int p = 0; p < cnt; p++)
-                            s->pal.tile_pal[base + p] =
-                                (uint8_t)((s->pal.tile_pal[base + p] + PAL_COUNT - 1) % PAL_COUNT);
+                        sel_pal(s, -1, -1);
                     }
                     break;
                 case SDLK_RIGHTBRACKET:
                     if (s->tile_mode) {
                         undo_push(s);
-                        int base = sel_tile_idx(s);
-                        int cnt  = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) ? 4 : 1;
-                        for (int p = 0; p < cnt; p++)
-                            s->pal.tile_pal[base + p] =
-                                (uint8_t)((s->pal.tile_pal[base + p] + 1) % PAL_COUNT);
+                        sel_pal(s, -1, 1);
                     }
                     break;
 
@@ -3,3 +3,42 @@
 #include "main.h"
 
 void input_handle(const SDL_Event *e, EditorState *s);
+
+/* Release the undo history. */
+void input_free(void);
+
+/* Bytes held by the undo history; *steps (optional) gets the number
+   of steps that can be undone.                                    */
+size_t input_undo_mem(int *steps);
+
+/* Push an undo snapshot (chr, palettes, active scene) before an edit
+   made outside the event handlers.  False if out of memory.       */
+bool input_checkpoint(const EditorState *s);
+
+/* Add scene i, as it is now, to the step input_checkpoint just
+   pushed, before changing it: only the active scene is otherwise
+   saved.  i may be at or past the scene count (a scene about to be
+   added); the count itself is restored along with the scenes.
+   Repeats are ignored.  False if no step is open or out of memory. */
+bool input_checkpoint_scene(const EditorState *s, int i);
+
+/* A tile's pixels changed: stamp it for renderers and ctl subscribers
+   and update its hash.                                            */
+void input_mark_tile(EditorState *s, int t);
+
+/* Pack the tiles used by any scene to the front of the sheet and
+   renumber every nametable and sprite reference, as one undo step.
+   Returns the slots the used tiles take, as compact_plan (*moved: how
+   many used tiles changed slot), or -1 if the scenes could not be
+   rewritten.                                                      */
+int  input_compact(EditorState *s, int *moved);
+
+/* Point every nametable cell and sprite that uses tile find (and,
+   with flips, its flipped variants) at tile with, in all scenes, as
+   one undo step.  Returns the number of references rewritten, or -1
+   on a bad tile number or out of memory.  *skipped counts flipped BG
+   cells and 16×16 sprite quadrants left alone; *scenes the scenes
+   changed.  A replace that rewrites nothing pushes no step, so the
+   redo history survives it.                                       */
+int  input_replace(EditorState *s, int find, int with, bool flips,
+                   int *skipped, int *scenes);
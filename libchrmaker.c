@@ -0,0 +1,306 @@
+#include "chrmaker.h"
+#include "chrcore.h"
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CM_GRAIN 4096           /* tiles per worker range */
+
+/* chrmaker.h restates core sizes as plain numbers so it stands alone;
+   the ABI breaks if they drift, so a core change must fail here.   */
+_Static_assert(CM_TILE_PIXELS == TILE_W * TILE_H,           "CM_TILE_PIXELS");
+_Static_assert(CM_MAX_TILES   == CHR_MAX_TILES,             "CM_MAX_TILES");
+_Static_assert(CM_PALETTES    == PAL_COUNT,                 "CM_PALETTES");
+_Static_assert(CM_SCENE_W     == COMPOSE_NT_W,              "CM_SCENE_W");
+_Static_assert(CM_SCENE_H     == COMPOSE_NT_H,              "CM_SCENE_H");
+_Static_assert(CM_SCREEN_W    == COMPOSE_NT_W * TILE_W,     "CM_SCREEN_W");
+_Static_assert(CM_SCREEN_H    == COMPOSE_NT_H * TILE_H,     "CM_SCREEN_H");
+/* The pointers handed out assume these layouts. */
+_Static_assert(sizeof(SubPalette) == 4,                     "cm_project_palettes: 4 bytes per sub-palette");
+_Static_assert(sizeof(((PaletteState *)0)->tile_pal[0]) == 1, "cm_project_tile_palettes");
+_Static_assert(sizeof(((ChrPage *)0)->px[0]) == CM_TILE_PIXELS, "cm_project_pixels");
+_Static_assert(sizeof(((ComposeScene *)0)->nametable[0][0]) == 2, "cm_project_nametable");
+_Static_assert(sizeof(((ComposeScene *)0)->attr) == 15 * 16,      "cm_project_attributes");
+
+struct CmProject {
+    ChrPage      chr;
+    PaletteState pal;
+    ComposeData  compose;
+    UsageIndex   usage;
+    TileHash     tilehash;
+    int          cols, rows;
+};
+
+static _Thread_local char err[300];
+
+static int fail(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, sizeof(err), fmt, ap);
+    va_end(ap);
+    return -1;
+}
+
+int cm_abi_version(void) { return CHRMAKER_ABI; }
+
+const char *cm_error(void) { return err; }
+
+/* ── Bulk tile kernels ───────────────────────────────────────── */
+
+typedef struct {
+    const uint8_t *in;
+    uint8_t       *out;
+} TileJob;
+
+static void decode_range(void *ctx, int begin, int end) {
+    const TileJob *j = ctx;
+    for (int t = begin; t < end; t++)
+        export_decode_tile(j->in + (size_t)t * CM_TILE_BYTES,
+                           (uint8_t (*)[TILE_W])(j->out + (size_t)t * CM_TILE_PIXELS));
+}
+
+static void encode_range(void *ctx, int begin, int end) {
+    const TileJob *j = ctx;
+    for (int t = begin; t < end; t++)
+        export_encode_tile((const uint8_t (*)[TILE_W])(j->in + (size_t)t * CM_TILE_PIXELS),
+                           j->out + (size_t)t * CM_TILE_BYTES);
+}
+
+static int check_count(int64_t n, const void *a, const void *b) {
+    if (n < 0 || n > INT_MAX) return fail("bad tile count %lld", (long long)n);
+    if (n > 0 && (!a || !b))  return fail("NULL buffer");
+    return 0;
+}
+
+int cm_decode_tiles(const uint8_t *planar, int64_t n, uint8_t *pixels) {
+    if (check_count(n, planar, pixels) != 0) return -1;
+    TileJob j = { planar, pixels };
+    par_for((int)n, CM_GRAIN, decode_range, &j);
+    return 0;
+}
+
+int cm_encode_tiles(const uint8_t *pixels, int64_t n, uint8_t *planar) {
+    if (check_count(n, pixels, planar) != 0) return -1;
+    uint8_t any = 0;
+    for (size_t i = 0; i < (size_t)n * CM_TILE_PIXELS; i++) any |= pixels[i];
+    if (any > 3) {
+        for (size_t i = 0; ; i++)
+            if (pixels[i] > 3)
+                return fail("tile %zu: pixel value %d (0-3 only)", i / CM_TILE_PIXELS, pixels[i]);
+    }
+    TileJob j = { pixels, planar };
+    par_for((int)n, CM_GRAIN, encode_range, &j);
+    return 0;
+}
+
+int cm_split_sprites16(const uint8_t *sprite16, int64_t n, uint8_t *pixels) {
+    if (check_count(n * 4, sprite16, pixels) != 0) return -1;
+    for (int64_t s = 0; s < n; s++) {
+        const uint8_t *src = sprite16 + s * 256;
+        for (int q = 0; q < 4; q++) {
+            uint8_t *dst = pixels + (s * 4 + q) * CM_TILE_PIXELS;
+            int y0 = (q & 1) * TILE_H, x0 = (q >> 1) * TILE_W;
+            for (int y = 0; y < TILE_H; y++)
+                memcpy(dst + y * TILE_W, src + (y0 + y) * 16 + x0, TILE_W);
+        }
+    }
+    return 0;
+}
+
+int64_t cm_dedupe_tiles(const uint8_t *planar, int64_t n, int flips,
+                        int32_t *rep, uint8_t *flip) {
+    if (check_count(n, planar, rep) != 0) return -1;
+    size_t    cap   = 16;
+    while (cap < (size_t)n * 2) cap *= 2;
+    uint64_t (*key)[2] = malloc((size_t)n * sizeof(*key) + 1);
+    uint8_t  *orient   = malloc((size_t)n + 1);
+    int32_t  *table    = malloc(cap * sizeof(*table));
+    if (!key || !orient || !table) {
+        free(key); free(orient); free(table);
+        return fail("out of memory");
+    }
+    memset(table, 0xFF, cap * sizeof(*table));
+
+    int64_t dups = 0;
+    for (int32_t t = 0; t < (int32_t)n; t++) {
+        uint64_t plane[2];
+        tilehash_pack(planar + (size_t)t * CM_TILE_BYTES, plane);
+        if (flips) orient[t] = (uint8_t)tilehash_canon(plane, key[t]);
+        else       { orient[t] = 0; key[t][0] = plane[0]; key[t][1] = plane[1]; }
+
+        size_t slot = (size_t)tilehash_key(key[t]) & (cap - 1);
+        for (;;) {
+            int32_t r = table[slot];
+            if (r < 0) { table[slot] = t; rep[t] = t; break; }
+            if (key[r][0] == key[t][0] && key[r][1] == key[t][1]) {
+                rep[t] = r;
+                dups++;
+                break;
+            }
+            slot = (slot + 1) & (cap - 1);
+        }
+        if (flip) flip[t] = orient[rep[t]] ^ orient[t];
+    }
+    free(key);
+    free(orient);
+    free(table);
+    return dups;
+}
+
+/* ── Projects ────────────────────────────────────────────────── */
+
+static CmProject *project_alloc(int cols, int rows) {
+    if (cols < 1 || rows < 1 || cols * rows > CHR_MAX_TILES) {
+        fail("bad sheet size %dx%d", cols, rows);
+        return NULL;
+    }
+    CmProject *p = calloc(1, sizeof(*p));
+    if (!p) { fail("out of memory"); return NULL; }
+    chr_init(&p->chr);
+    palette_init(&p->pal);
+    compose_init(&p->compose);
+    usage_init(&p->usage);
+    p->cols = cols;
+    p->rows = rows;
+    return p;
+}
+
+CmProject *cm_project_new(int cols, int rows) { return project_alloc(cols, rows); }
+
+CmProject *cm_project_open(const char *chr_path, int cols) {
+    CmProject *p = project_alloc(cols ? cols : CHR_DEFAULT_COLS, 1);
+    if (!p) return NULL;
+    int tiles = chrfmt_load(&p->chr, chr_path, chrfmt_from_path(chr_path));
+    if (tiles <= 0) {
+        const char *why = chrfmt_refuses(chr_path);
+        fail("can't read CHR %s%s%s", chr_path, why ? ": " : "", why ? why : "");
+        cm_project_free(p);
+        return NULL;
+    }
+    p->rows = (tiles + p->cols - 1) / p->cols;
+    if (p->cols * p->rows > CHR_MAX_TILES) p->rows = CHR_MAX_TILES / p->cols;
+
+    char pp[260], sp[260];
+    chr_sidecar_path(pp, sizeof(pp), chr_path, ".pal");
+    chr_sidecar_path(sp, sizeof(sp), chr_path, ".scn");
+    if (palette_load(&p->pal, pp) != 0) palette_init(&p->pal);
+    if (compose_load(&p->compose, sp) != 0) {
+        compose_free(&p->compose);
+        compose_init(&p->compose);
+    }
+    return p;
+}
+
+int cm_project_save(CmProject *p, const char *chr_path) {
+    char pp[260], sp[260];
+    chr_sidecar_path(pp, sizeof(pp), chr_path, ".pal");
+    chr_sidecar_path(sp, sizeof(sp), chr_path, ".scn");
+    ChrFormat f = chrfmt_from_path(chr_path);
+    if (chrfmt_refuses(chr_path)) return fail("can't write %s: %s", chr_path, chrfmt_refuses(chr_path));
+    if (chrfmt_save(&p->chr, p->cols * p->rows, chr_path, f) != 0)
+        return fail("can't write %s CHR %s", chrfmt_name(f), chr_path);
+    if (palette_save(&p->pal, pp) != 0)       return fail("can't write palette %s", pp);
+    if (compose_save(&p->compose, sp) != 0)   return fail("can't write scenes %s", sp);
+    return 0;
+}
+
+void cm_project_free(CmProject *p) {
+    if (!p) return;
+    usage_free(&p->usage);
+    compose_free(&p->compose);
+    free(p);
+}
+
+int cm_project_cols(const CmProject *p) { return p->cols; }
+int cm_project_rows(const CmProject *p) { return p->rows; }
+
+int cm_project_set_size(CmProject *p, int cols, int rows) {
+    if (cols < 1 || rows < 1 || cols * rows > CHR_MAX_TILES)
+        return fail("bad sheet size %dx%d", cols, rows);
+    p->cols = cols;
+    p->rows = rows;
+    return 0;
+}
+
+uint8_t *cm_project_pixels(CmProject *p)        { return &p->chr.px[0][0][0]; }
+uint8_t *cm_project_tile_palettes(CmProject *p) { return p->pal.tile_pal; }
+uint8_t *cm_project_palettes(CmProject *p)      { return p->pal.sub[0].idx; }
+
+int cm_project_scene_count(const CmProject *p) { return p->compose.scene_count; }
+
+int cm_project_add_scene(CmProject *p) {
+    int i = compose_add_scene(&p->compose);
+    return i < 0 ? fail("scene limit (%d) reached", COMPOSE_MAX_SCENES) : i;
+}
+
+/* Scene i for writing (resident from now on), or NULL. */
+static ComposeScene *scene_for(CmProject *p, int i) {
+    if (i < 0 || i >= p->compose.scene_count) {
+        fail("no scene %d (%d scene(s))", i, p->compose.scene_count);
+        return NULL;
+    }
+    return compose_scene(&p->compose, i);
+}
+
+uint16_t *cm_project_nametable(CmProject *p, int scene) {
+    ComposeScene *sc = scene_for(p, scene);
+    return sc ? &sc->nametable[0][0] : NULL;
+}
+
+uint8_t *cm_project_attributes(CmProject *p, int scene) {
+    ComposeScene *sc = scene_for(p, scene);
+    return sc ? &sc->attr[0][0] : NULL;
+}
+
+/* Scene i for reading; it is not marked dirty. */
+static const ComposeScene *scene_view(CmProject *p, int i) {
+    if (i < 0 || i >= p->compose.scene_count) {
+        fail("no scene %d (%d scene(s))", i, p->compose.scene_count);
+        return NULL;
+    }
+    const ComposeScene *sc = compose_view(&p->compose, i);
+    if (!sc) fail("can't read scene %d", i);
+    return sc;
+}
+
+const uint16_t *cm_project_read_nametable(CmProject *p, int scene) {
+    const ComposeScene *sc = scene_view(p, scene);
+    return sc ? &sc->nametable[0][0] : NULL;
+}
+
+const uint8_t *cm_project_read_attributes(CmProject *p, int scene) {
+    const ComposeScene *sc = scene_view(p, scene);
+    return sc ? &sc->attr[0][0] : NULL;
+}
+
+int cm_project_render_scene(CmProject *p, int scene, uint32_t *argb, int stride) {
+    ComposeScene tmp;
+    const ComposeScene *sc = compose_peek(&p->compose, scene, &tmp);
+    if (!sc)   return fail("can't read scene %d", scene);
+    if (!argb) return fail("NULL buffer");
+    swr_scene(&p->chr, &p->pal, sc, 0, 0, CM_SCREEN_W, CM_SCREEN_H, argb,
+              stride ? stride : CM_SCREEN_W);
+    return 0;
+}
+
+int cm_project_render_sheet(CmProject *p, int gray, uint32_t *argb, int stride) {
+    if (!argb) return fail("NULL buffer");
+    swr_sheet(&p->chr, &p->pal, p->cols, p->rows, gray != 0, false, argb,
+              stride ? stride : p->cols * TILE_W);
+    return 0;
+}
+
+int cm_project_dedupe(CmProject *p, int flips, int *refs) {
+    /* Pixels and scenes may have been written through the pointers
+       above, so the indexes are rebuilt first.                     */
+    int r, skipped;
+    tilehash_rebuild(&p->tilehash, &p->chr);
+    usage_rebuild(&p->usage, &p->compose);
+    int dups = replace_dedupe(&p->compose, &p->usage, &p->tilehash, p->cols * p->rows,
+                              flips != 0, &r, &skipped);
+    if (dups < 0) return fail("out of memory");
+    if (refs) *refs = r;
+    return dups;
+}
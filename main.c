@@ -1,6 +1,7 @@
 #include <SDL2/SDL.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include "chr.h"
 #include "main.h"
 #include "panel.h"
@@ -8,35 +9,25 @@
 #include "input.h"
 #include "export.h"
 #include "compose.h"
-
-/* ── Palette sidecar path ─────────────────────────────────────── */
-
-/* Derive the .pal sidecar path from a .chr path.
-   "output.chr" → "output.pal"; "/p/f.chr" → "/p/f.pal";
-   files without an extension get ".pal" appended.             */
+#include "import.h"
+#include "chrfmt.h"
+#include "batch.h"
+#include "replay.h"
+#include "trace.h"
+#include "clip.h"
+#include "ctl.h"
+#include "watch.h"
+
+/* ── Sidecar paths ────────────────────────────────────────────── */
+
+/* Derive the .pal sidecar path from a .chr path. */
 static void make_pal_path(char *out, int outlen, const char *chr_path) {
-    snprintf(out, outlen, "%s", chr_path);
-    char *dot = strrchr(out, '.');
-    char *sl  = strrchr(out, '/');
-    if (dot && (!sl || dot > sl))
-        snprintf(dot, outlen - (int)(dot - out), ".pal");
-    else {
-        int len = (int)strlen(out);
-        snprintf(out + len, outlen - len, ".pal");
-    }
+    chr_sidecar_path(out, outlen, chr_path, ".pal");
 }
 
 /* Derive the .scn sidecar path from a .chr path. */
 static void make_scn_path(char *out, int outlen, const char *chr_path) {
-    snprintf(out, outlen, "%s", chr_path);
-    char *dot = strrchr(out, '.');
-    char *sl  = strrchr(out, '/');
-    if (dot && (!sl || dot > sl))
-        snprintf(dot, outlen - (int)(dot - out), ".scn");
-    else {
-        int len = (int)strlen(out);
-        snprintf(out + len, outlen - len, ".scn");
-    }
+    chr_sidecar_path(out, outlen, chr_path, ".scn");
 }
 
 /* ── Dimension helpers ────────────────────────────────────────── */
@@ -128,6 +119,9 @@ static void state_update_dims(EditorState *s) {
 static void state_init(EditorState *s, const char *path, int cols, int rows) {
     memset(s, 0, sizeof(EditorState));
     chr_init(&s->chr);
+    tilehash_rebuild(&s->tilehash, &s->chr);
+    s->dup_view = 0;
+    s->show_nearest = false;
     palette_init(&s->pal);
 
     s->chr_cols        = cols;
@@ -153,6 +147,8 @@ static void state_init(EditorState *s, const char *path, int cols, int rows) {
     s->tile_mode       = false;
     s->sel_tile_x      = 0;
     s->sel_tile_y      = 0;
+    s->sel_w           = 1;
+    s->sel_h           = 1;
     s->sprite_mode     = SPRITE_8;
     s->wrap_mode       = WRAP_NONE;
     s->mouse_down       = false;
@@ -165,6 +161,10 @@ static void state_init(EditorState *s, const char *path, int cols, int rows) {
     s->pal_path[0]      = '\0';
     s->want_save_pal    = false;
     s->want_load_pal    = false;
+    s->import_path[0]   = '\0';
+    s->want_import      = false;
+    s->chr_format       = -1;
+    s->import_budget_ms = IMPORT_BUDGET_MS;
     s->running          = true;
 
     s->anim_state        = ANIM_OFF;
@@ -180,6 +180,10 @@ static void state_init(EditorState *s, const char *path, int cols, int rows) {
     /* Compose mode */
     s->compose_mode       = false;
     compose_init(&s->compose);
+    usage_init(&s->usage);
+    usage_rebuild(&s->usage, &s->compose);
+    chrsize_init(&s->chrsize);
+    s->show_usage         = false;
     s->compose_layer      = COMPOSE_BG;
     s->brush_tile         = 0;
     s->brush_hflip        = false;
@@ -194,6 +198,14 @@ static void state_init(EditorState *s, const char *path, int cols, int rows) {
     s->compose_show_help  = false;
     s->want_save_scene    = false;
     s->want_load_scene    = false;
+    s->want_export_nes    = false;
+    s->want_export_packed = false;
+    s->want_near_report   = false;
+    s->want_compact       = false;
+    s->want_replace       = false;
+    s->replace_from       = 0;
+    s->replace_to         = 0;
+    s->replace_flips      = false;
     s->scene_path[0]      = '\0';
 
     /* Compose preview dock */
@@ -202,30 +214,147 @@ static void state_init(EditorState *s, const char *path, int cols, int rows) {
     s->preview_pan_x  = 0;
     s->preview_pan_y  = 0;
     s->preview_panning = false;
+    s->scroll_play     = false;
+    s->scroll_vertical = false;
+    s->scroll_speed    = 1;
+    s->scroll_pos      = 0;
+    s->scroll_t0       = 0;
+    s->scroll_frames   = 0;
+    s->edit_rev        = 0;
+    s->chr_rev         = 0;
+    memset(s->tile_rev, 0, sizeof(s->tile_rev));
 
     snprintf(s->current_path, sizeof(s->current_path), "%s", path);
 }
 
+/* CHR file format: --format if given, else the file extension. */
+static ChrFormat chr_format_for(const EditorState *s, const char *path) {
+    return s->chr_format >= 0 ? (ChrFormat)s->chr_format : chrfmt_from_path(path);
+}
+
+/* ── Memory accounting ────────────────────────────────────────── */
+
+static void mem_collect(const EditorState *s, MemReport *m) {
+    size_t peak = m->peak;
+    memset(m, 0, sizeof(*m));
+    m->bytes[MEM_STATE] = sizeof(*s) + clip_mem() + watch_mem();
+    m->bytes[MEM_UNDO]  = input_undo_mem(&m->undo_steps);
+    for (int i = 0; i < s->compose.scene_count; i++) {
+        if (s->compose.scenes[i]) m->scenes_resident++;
+        if (s->usage.scene[i])    m->bytes[MEM_USAGE] += sizeof(UsageScene);
+    }
+    m->bytes[MEM_SCENES]   = (size_t)m->scenes_resident * sizeof(ComposeScene);
+    m->bytes[MEM_TEXTURES] = render_mem();
+    m->bytes[MEM_WORKERS]  = chrsize_mem(&s->chrsize);
+    for (int k = 0; k < MEM_KINDS; k++) m->total += m->bytes[k];
+    m->peak = m->total > peak ? m->total : peak;
+}
+
+static void mem_print(const EditorState *s, FILE *f) {
+    static const char *const NAME[MEM_KINDS] = {
+        "editor state", "undo history", "scenes", "usage index", "textures", "workers",
+    };
+    const MemReport *m = &s->mem;
+    fprintf(f, "memory: %.1f KB at exit, peak %.1f KB", m->total / 1024.0, m->peak / 1024.0);
+    if (s->mem_cap) fprintf(f, ", cap %.1f KB", s->mem_cap / 1024.0);
+    fputc('\n', f);
+    for (int k = 0; k < MEM_KINDS; k++) {
+        fprintf(f, "  %-13s %10.1f KB", NAME[k], m->bytes[k] / 1024.0);
+        if (k == MEM_UNDO)   fprintf(f, "  (%d step(s))", m->undo_steps);
+        if (k == MEM_SCENES) fprintf(f, "  (%d of %d resident)", m->scenes_resident,
+                                     s->compose.scene_count);
+        fputc('\n', f);
+    }
+}
+
 /* Update the window title with a short status message. */
 static void set_title(SDL_Window *win, const char *msg) {
     char t[320];
     snprintf(t, sizeof(t), "chrmaker — %s", msg);
     SDL_SetWindowTitle(win, t);
+    ctl_result(msg);
 }
 
 int main(int argc, char *argv[]) {
-    const char *arg_path = (argc > 1) ? argv[1] : "output.chr";
+    /* Flags may appear anywhere; the rest are positional. */
+    const char *pos[2] = { NULL, NULL };
+    const char *record_path = NULL, *replay_path = NULL, *times_path = NULL;
+    const char *trace_path = NULL, *listen_path = NULL;
+    double max_p95 = 0, mem_cap_mb = 0;
+    bool stats = false;
+    int npos = 0, arg_format = -1;
+    bool batch = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--batch")) {
+            batch = true;
+        } else if (!strncmp(argv[i], "--record=", 9)) {
+            record_path = argv[i] + 9;
+        } else if (!strncmp(argv[i], "--replay=", 9)) {
+            replay_path = argv[i] + 9;
+        } else if (!strncmp(argv[i], "--frame-times=", 14)) {
+            times_path = argv[i] + 14;
+        } else if (!strncmp(argv[i], "--max-p95=", 10)) {
+            max_p95 = atof(argv[i] + 10);
+        } else if (!strncmp(argv[i], "--trace=", 8)) {
+            trace_path = argv[i] + 8;
+        } else if (!strncmp(argv[i], "--mem-cap=", 10)) {
+            mem_cap_mb = atof(argv[i] + 10);
+        } else if (!strncmp(argv[i], "--listen=", 9)) {
+            listen_path = argv[i] + 9;
+        } else if (!strcmp(argv[i], "--stats")) {
+            stats = true;
+        } else if (!strncmp(argv[i], "--format=", 9)) {
+            arg_format = chrfmt_parse(argv[i] + 9);
+            if (arg_format < 0) {
+                fprintf(stderr, "unknown --format (raw, rle, pred): %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (npos < 2) {
+            pos[npos++] = argv[i];
+        }
+    }
+    if (trace_path) {
+        if (trace_open(trace_path) != 0) {
+            fprintf(stderr, "can't write trace %s\n", trace_path);
+            return 1;
+        }
+        trace_thread_name("main");
+    }
+
+    /* Headless: no window, no SDL video. */
+    if (batch) {
+        int rc = batch_main(argc, argv);
+        trace_close();
+        return rc;
+    }
+
+    const char *arg_path = pos[0] ? pos[0] : "output.chr";
 
     /* Optional second arg: "16x32" — canvas dimensions in tiles. */
     int arg_cols = CHR_DEFAULT_COLS, arg_rows = CHR_DEFAULT_ROWS;
-    if (argc > 2) {
+    if (pos[1]) {
         int c = 0, r = 0;
-        if (sscanf(argv[2], "%dx%d", &c, &r) == 2 && c >= 1 && r >= 1) {
+        if (sscanf(pos[1], "%dx%d", &c, &r) == 2 && c >= 1 && r >= 1) {
             if (c <= 128) arg_cols = c;
             if (r <=  64) arg_rows = r;
         }
     }
 
+    /* Replay: no visible window (SDL's dummy video driver unless
+       SDL_VIDEODRIVER says otherwise) and no frame delay.          */
+    EventReplay replay;
+    EventRecorder rec = { NULL };
+    if (replay_path) {
+        if (replay_open(&replay, replay_path) != 0) return 1;
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    } else if (record_path && rec_open(&rec, record_path) != 0) {
+        fprintf(stderr, "can't write recording %s\n", record_path);
+        return 1;
+    }
+    /* File operations go through replay_file(rp, ...): a replay saves
+       into its scratch directory, never over the recorded files.    */
+    EventReplay *rp = replay_path ? &replay : NULL;
+
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
         return 1;
@@ -235,12 +364,24 @@ int main(int argc, char *argv[]) {
     /* Temporary state to get initial window dimensions. */
     EditorState state;
     state_init(&state, arg_path, arg_cols, arg_rows);
+    state.chr_format = arg_format;
+    state.mem_cap    = mem_cap_mb > 0 ? (size_t)(mem_cap_mb * 1024 * 1024) : 0;
+    /* Replays get a private clipboard so another window's copy can't
+       change what a recorded paste does.                             */
+    if (clip_open(replay_path == NULL) != 0)
+        fprintf(stderr, "out of memory for the clipboard; copy/paste is off\n");
+    if (listen_path && ctl_open(listen_path) != 0) {
+        SDL_Quit();
+        return 1;
+    }
+    /* Replays must not pick up whatever is on disk now. */
+    if (!replay_path) watch_open();
 
     SDL_Window *win = SDL_CreateWindow(
         "chrmaker",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         state.win_w, state.win_h,
-        SDL_WINDOW_SHOWN
+        replay_path ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN
     );
     if (!win) {
         fprintf(stderr, "SDL_CreateWindow: %s\n", SDL_GetError());
@@ -248,7 +389,7 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    SDL_Renderer *ren = SDL_CreateRenderer(
+    SDL_Renderer *ren = replay_path ? NULL : SDL_CreateRenderer(
         win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!ren)
         ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_SOFTWARE);
@@ -266,7 +407,8 @@ int main(int argc, char *argv[]) {
         FILE *probe = fopen(arg_path, "rb");
         if (probe) {
             fclose(probe);
-            int tiles = chr_load(&state.chr, arg_path);
+            int tiles = chrfmt_load(&state.chr, arg_path, chr_format_for(&state, arg_path));
+            tilehash_rebuild(&state.tilehash, &state.chr);
             if (tiles > 0) {
                 /* Auto-detect rows from tile count, keeping cols fixed. */
                 int rows = (tiles + state.chr_cols - 1) / state.chr_cols;
@@ -288,41 +430,85 @@ int main(int argc, char *argv[]) {
                 char sp[260];
                 make_scn_path(sp, sizeof(sp), arg_path);
                 compose_load(&state.compose, sp); /* silent, ok if missing */
+            } else if (chrfmt_refuses(arg_path)) {
+                char msg[300];
+                snprintf(msg, sizeof(msg), "ERROR opening %s: %s", arg_path, chrfmt_refuses(arg_path));
+                set_title(win, msg);
             }
         }
     }
+    usage_rebuild(&state.usage, &state.compose);
+    watch_base(&state, WATCH_ALL);
 
-    SDL_Event e;
+    SDL_Event  e;
+    FrameTimes times = { NULL, 0, 0 };
+    int        replay_rc = 0;
     while (state.running) {
-        while (SDL_PollEvent(&e))
-            input_handle(&e, &state);
+        TraceZone frame_z = trace_begin("frame");
+        uint64_t frame_t0 = SDL_GetPerformanceCounter();
+        if (replay_path) {
+            /* The recording drives the frame; live events are dropped. */
+            if ((replay_rc = replay_frame(&replay, &state.ticks)) <= 0) break;
+            while (SDL_PollEvent(&e)) {}
+            while ((replay_rc = replay_event(&replay, &e)) > 0) {
+                TraceZone z = trace_begin("input");
+                input_handle(&e, &state);
+                trace_end(z);
+            }
+            if (replay_rc < 0) break;
+        } else {
+            state.ticks = SDL_GetTicks();
+            rec_frame(&rec, state.ticks);
+            while (SDL_PollEvent(&e)) {
+                rec_event(&rec, &e);
+                TraceZone z = trace_begin("input");
+                input_handle(&e, &state);
+                trace_end(z);
+            }
+        }
+
+        /* ── Control socket requests (may queue file operations) ── */
+        ctl_poll(&state, CTL_BUDGET_MS);
 
         /* ── File operations ── */
         if (state.want_save) {
             state.want_save = false;
+            TraceZone z = trace_begin("save");
             char msg[300];
             int  ntiles = state.chr_cols * state.chr_rows;
-            if (export_chr(&state.chr, ntiles, state.current_path) == 0) {
-                snprintf(msg, sizeof(msg), "saved: %s (%d tiles)",
-                         state.current_path, ntiles);
+            char rf[600];
+            ChrFormat fmt = chr_format_for(&state, state.current_path);
+            if (chrfmt_save(&state.chr, ntiles,
+                            replay_file(rp, state.current_path, true, rf, sizeof(rf)), fmt) == 0) {
+                snprintf(msg, sizeof(msg), "saved: %s (%d tiles%s%s)",
+                         state.current_path, ntiles,
+                         fmt == CHR_FMT_RAW ? "" : ", ", fmt == CHR_FMT_RAW ? "" : chrfmt_name(fmt));
                 char pp[260];
                 make_pal_path(pp, sizeof(pp), state.current_path);
-                palette_save(&state.pal, pp); /* silent sidecar */
+                palette_save(&state.pal, replay_file(rp, pp, true, rf, sizeof(rf))); /* silent sidecar */
                 /* Auto-save scene sidecar if compose has data */
                 if (state.compose.scene_count > 0) {
                     char sp[260];
                     make_scn_path(sp, sizeof(sp), state.current_path);
-                    compose_save(&state.compose, sp);
+                    compose_save(&state.compose, replay_file(rp, sp, true, rf, sizeof(rf)));
                 }
+                watch_base(&state, WATCH_ALL);
             } else {
-                snprintf(msg, sizeof(msg), "ERROR saving %s", state.current_path);
+                const char *why = chrfmt_refuses(state.current_path);
+                snprintf(msg, sizeof(msg), "ERROR saving %s%s%s", state.current_path,
+                         why ? ": " : "", why ? why : "");
             }
+            trace_end(z);
             set_title(win, msg);
         }
         if (state.want_load) {
             state.want_load = false;
-            char msg[300];
-            int tiles = chr_load(&state.chr, state.current_path);
+            TraceZone z = trace_begin("load");
+            char msg[300], rf[600];
+            int tiles = chrfmt_load(&state.chr,
+                                    replay_file(rp, state.current_path, false, rf, sizeof(rf)),
+                                    chr_format_for(&state, state.current_path));
+            tilehash_rebuild(&state.tilehash, &state.chr);
             if (tiles > 0) {
                 int rows = (tiles + state.chr_cols - 1) / state.chr_cols;
                 if (rows != state.chr_rows) {
@@ -333,72 +519,247 @@ int main(int argc, char *argv[]) {
                          state.current_path, tiles);
                 char pp[260];
                 make_pal_path(pp, sizeof(pp), state.current_path);
-                if (palette_load(&state.pal, pp) == 0)
+                if (palette_load(&state.pal, replay_file(rp, pp, false, rf, sizeof(rf))) == 0)
                     state.view_mode = VIEW_NES_COLOR;
                 /* Auto-load scene sidecar */
                 char sp[260];
                 make_scn_path(sp, sizeof(sp), state.current_path);
-                compose_load(&state.compose, sp); /* silent */
+                compose_load(&state.compose, replay_file(rp, sp, false, rf, sizeof(rf))); /* silent */
+                usage_rebuild(&state.usage, &state.compose);
+                state.edit_rev++;
+                watch_base(&state, WATCH_ALL);
             } else {
-                snprintf(msg, sizeof(msg), "ERROR opening %s", state.current_path);
+                const char *why = chrfmt_refuses(state.current_path);
+                snprintf(msg, sizeof(msg), "ERROR opening %s%s%s", state.current_path,
+                         why ? ": " : "", why ? why : "");
             }
+            trace_end(z);
             set_title(win, msg);
         }
 
         /* ── Scene save/load ── */
         if (state.want_save_scene) {
             state.want_save_scene = false;
-            char sp[260], msg[300];
+            TraceZone z = trace_begin("save scene");
+            char sp[260], msg[300], rf[600];
             if (state.scene_path[0] == '\0')
                 make_scn_path(sp, sizeof(sp), state.current_path);
             else
                 snprintf(sp, sizeof(sp), "%s", state.scene_path);
-            if (compose_save(&state.compose, sp) == 0)
+            if (compose_save(&state.compose, replay_file(rp, sp, true, rf, sizeof(rf))) == 0) {
+                if (state.scene_path[0] == '\0') watch_base(&state, WATCH_SCN);
                 snprintf(msg, sizeof(msg), "scene saved: %s", sp);
-            else
+            } else
                 snprintf(msg, sizeof(msg), "ERROR saving scene: %s", sp);
+            trace_end(z);
             set_title(win, msg);
         }
         if (state.want_load_scene) {
             state.want_load_scene = false;
-            char sp[260], msg[300];
+            TraceZone z = trace_begin("load scene");
+            char sp[260], msg[300], rf[600];
             if (state.scene_path[0] == '\0')
                 make_scn_path(sp, sizeof(sp), state.current_path);
             else
                 snprintf(sp, sizeof(sp), "%s", state.scene_path);
-            if (compose_load(&state.compose, sp) == 0)
+            if (compose_load(&state.compose, replay_file(rp, sp, false, rf, sizeof(rf))) == 0) {
+                usage_rebuild(&state.usage, &state.compose);
+                state.edit_rev++;
+                if (state.scene_path[0] == '\0') watch_base(&state, WATCH_SCN);
                 snprintf(msg, sizeof(msg), "scene loaded: %s", sp);
-            else
+            } else
                 snprintf(msg, sizeof(msg), "ERROR loading scene: %s", sp);
+            trace_end(z);
+            set_title(win, msg);
+        }
+
+        /* ── NES-native scene export (.nam + .oam, all scenes) ── */
+        if (state.want_export_nes) {
+            state.want_export_nes = false;
+            TraceZone z = trace_begin("export nam/oam");
+            char np[260], op[260], msg[600], rf[600];
+            chr_sidecar_path(np, sizeof(np), state.current_path, ".nam");
+            chr_sidecar_path(op, sizeof(op), state.current_path, ".oam");
+            if (export_scenes_nam(&state.compose, replay_file(rp, np, true, rf, sizeof(rf))) == 0 &&
+                export_scenes_oam(&state.compose, replay_file(rp, op, true, rf, sizeof(rf))) == 0)
+                snprintf(msg, sizeof(msg), "exported %d scene(s): %s, %s",
+                         state.compose.scene_count, np, op);
+            else
+                snprintf(msg, sizeof(msg), "ERROR exporting: %s", np);
+            trace_end(z);
+            set_title(win, msg);
+        }
+
+        if (state.want_export_packed) {
+            state.want_export_packed = false;
+            TraceZone z = trace_begin("export packed");
+            static const char *const EXT[CODEC_COUNT] = { ".nrle", ".nlz" };
+            char msg[300];
+            int  failed = -1, rc = 0;
+            for (int c = 0; c < CODEC_COUNT && failed < 0; c++) {
+                char cp[260], rf[600];
+                chr_sidecar_path(cp, sizeof(cp), state.current_path, EXT[c]);
+                rc = export_scenes_packed(&state.compose, (Codec)c,
+                                          replay_file(rp, cp, true, rf, sizeof(rf)));
+                if (rc != 0) failed = c;
+            }
+            if (failed < 0)
+                snprintf(msg, sizeof(msg), "exported %d compressed scene(s) (%s, %s)",
+                         state.compose.scene_count, EXT[0], EXT[1]);
+            else if (rc == EXPORT_OFFSET_OVERFLOW)
+                snprintf(msg, sizeof(msg), "ERROR exporting %s scenes: over 64 KB, "
+                         "past the 16-bit offsets", codec_name((Codec)failed));
+            else
+                snprintf(msg, sizeof(msg), "ERROR exporting %s scenes",
+                         codec_name((Codec)failed));
+            trace_end(z);
+            set_title(win, msg);
+        }
+
+        /* ── Near-duplicate tile report ── */
+        if (state.want_near_report) {
+            state.want_near_report = false;
+            TraceZone z = trace_begin("near report");
+            char np[260], msg[300], rf[600];
+            chr_sidecar_path(np, sizeof(np), state.current_path, ".near.txt");
+            int ntiles = state.chr_cols * state.chr_rows;
+            int pairs  = export_near_report(&state.tilehash, ntiles, TH_NEAR_DIST,
+                                            replay_file(rp, np, true, rf, sizeof(rf)));
+            if (pairs >= 0)
+                snprintf(msg, sizeof(msg), "%d near-duplicate pair(s): %s", pairs, np);
+            else
+                snprintf(msg, sizeof(msg), "ERROR writing %s", np);
+            trace_end(z);
+            set_title(win, msg);
+        }
+
+        /* ── Unused-tile compaction ── */
+        if (state.want_compact) {
+            state.want_compact = false;
+            TraceZone z = trace_begin("compact");
+            char msg[300];
+            int moved = 0;
+            int span  = input_compact(&state, &moved);
+            if (span < 0)
+                snprintf(msg, sizeof(msg), "ERROR compacting: out of memory");
+            else if (moved == 0)
+                snprintf(msg, sizeof(msg), "already compact: used tiles take %d slot(s)", span);
+            else
+                snprintf(msg, sizeof(msg),
+                         "compacted: used tiles take %d slot(s), %d moved; fits in %d row(s)",
+                         span, moved, (span + state.chr_cols - 1) / state.chr_cols);
+            trace_end(z);
+            set_title(win, msg);
+        }
+
+        /* ── Tile find-and-replace across all scenes ── */
+        if (state.want_replace) {
+            state.want_replace = false;
+            TraceZone z = trace_begin("replace");
+            char msg[300];
+            int skipped = 0, scenes = 0;
+            int n = input_replace(&state, state.replace_from, state.replace_to,
+                                  state.replace_flips, &skipped, &scenes);
+            if (n < 0)
+                snprintf(msg, sizeof(msg), "ERROR replacing tile %d with %d",
+                         state.replace_from, state.replace_to);
+            else
+                snprintf(msg, sizeof(msg),
+                         "replaced tile %d with %d%s: %d reference(s) in %d scene(s), "
+                         "%d flipped/16x16 skipped",
+                         state.replace_from, state.replace_to,
+                         state.replace_flips ? " (+flips)" : "", n, scenes, skipped);
+            trace_end(z);
             set_title(win, msg);
         }
 
         /* ── Explicit palette save/load ── */
         if (state.want_save_pal) {
             state.want_save_pal = false;
-            char pp[260], msg[300];
+            TraceZone z = trace_begin("save palette");
+            char pp[260], msg[300], rf[600];
             make_pal_path(pp, sizeof(pp), state.current_path);
-            if (palette_save(&state.pal, pp) == 0)
+            if (palette_save(&state.pal, replay_file(rp, pp, true, rf, sizeof(rf))) == 0) {
+                watch_base(&state, WATCH_PAL);
                 snprintf(msg, sizeof(msg), "palette saved: %s", pp);
-            else
+            } else
                 snprintf(msg, sizeof(msg), "ERROR saving palette: %s", pp);
+            trace_end(z);
             set_title(win, msg);
         }
         if (state.want_load_pal) {
             state.want_load_pal = false;
-            char msg[300];
-            if (palette_load(&state.pal, state.pal_path) == 0) {
+            TraceZone z = trace_begin("load palette");
+            char msg[300], rf[600];
+            if (palette_load(&state.pal, replay_file(rp, state.pal_path, false, rf, sizeof(rf))) == 0) {
                 state.view_mode = VIEW_NES_COLOR;
+                state.edit_rev++;
                 snprintf(msg, sizeof(msg), "palette loaded: %s", state.pal_path);
             }
             else
                 snprintf(msg, sizeof(msg), "ERROR loading palette: %s", state.pal_path);
+            trace_end(z);
             set_title(win, msg);
         }
 
+        /* ── Image import into the active scene ── */
+        if (state.want_import) {
+            state.want_import = false;
+            TraceZone z = trace_begin("import");
+            char msg[400];
+            Image img;
+            ImportResult *r = malloc(sizeof(*r));
+            if (!r || image_load(&img, state.import_path) != 0) {
+                snprintf(msg, sizeof(msg), "ERROR reading image: %s", state.import_path);
+            } else {
+                uint64_t t0 = SDL_GetPerformanceCounter();
+                int first = import_first_free(&state.chr, &state.usage);
+                if (import_build(&img, &state.chr, first, state.import_budget_ms, r) != 0) {
+                    snprintf(msg, sizeof(msg), "ERROR importing %s: not enough free tiles",
+                             state.import_path);
+                } else {
+                    input_checkpoint(&state);
+                    int i = state.compose.active_scene;
+                    import_apply(r, &state.chr, &state.pal, compose_scene(&state.compose, i));
+                    usage_sync_scene(&state.usage, i, compose_active(&state.compose));
+                    tilehash_rebuild(&state.tilehash, &state.chr);
+                    state.edit_rev++;
+                    state.view_mode = VIEW_NES_COLOR;
+                    double ms = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0
+                              / (double)SDL_GetPerformanceFrequency();
+
+                    /* Grow the sheet to show the appended tiles. */
+                    int end  = r->first_new + r->new_count;
+                    int rows = (end + state.chr_cols - 1) / state.chr_cols;
+                    if (rows > state.chr_rows && rows <= 64) {
+                        state.chr_rows    = rows;
+                        state.want_resize = true;
+                    }
+                    snprintf(msg, sizeof(msg),
+                             "imported %s: %d new tile(s) at %d, %d cell(s) reused, "
+                             "%d colour(s), fit %.1f%%, %d lossy block(s), "
+                             "%d restart(s), %.1f ms",
+                             state.import_path, r->new_count, r->first_new, r->reused,
+                             r->colours, r->quality, r->lossy_blocks, r->restarts, ms);
+                }
+                image_free(&img);
+            }
+            free(r);
+            trace_end(z);
+            set_title(win, msg);
+        }
+
+        /* ── Files changed on disk (after the file operations, so a
+           control-socket save or load gets its own reply) ── */
+        {
+            char msg[300];
+            if (watch_poll(&state, msg, sizeof(msg))) set_title(win, msg);
+        }
+
         /* ── Resize — MUST come after want_load, before render_frame ── */
         if (state.want_resize) {
             state.want_resize = false;
+            TraceZone z = trace_begin("resize");
             /* Reset focus zoom/pan: canvas dims just changed. */
             state.focus_zoom = 1;
             state.pan_x = 0;
@@ -408,11 +769,12 @@ int main(int argc, char *argv[]) {
             SDL_SetWindowPosition(win, SDL_WINDOWPOS_CENTERED,
                                       SDL_WINDOWPOS_CENTERED);
             render_resize(ren, &state);
+            trace_end(z);
         }
 
         /* ── Animation playback ── */
         if (state.anim_playing && state.anim_state == ANIM_ACTIVE) {
-            uint32_t now = SDL_GetTicks();
+            uint32_t now = state.ticks;
             uint32_t interval = (state.anim_speed > 0) ? 1000 / state.anim_speed : 125;
             if (now - state.anim_last_tick >= interval) {
                 state.anim_cur = (state.anim_cur + 1) % state.anim_frame_count;
@@ -420,13 +782,74 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        /* ── Scroll preview playback ── */
+        if (state.scroll_play && state.show_preview) {
+            /* Step a whole number of 60 Hz frames since playback began so
+               the camera speed doesn't depend on the loop's frame rate. */
+            uint32_t target = (state.ticks - state.scroll_t0) * 60 / 1000;
+            uint32_t steps  = target - state.scroll_frames;
+            if (steps > 4) steps = 4;   /* don't lurch after a stall */
+            state.scroll_frames = target;
+            int strip = state.compose.scene_count *
+                        (state.scroll_vertical ? 240 : 256);
+            state.scroll_pos = (state.scroll_pos +
+                                (int)steps * state.scroll_speed) % strip;
+        }
+
+        ctl_notify(&state);
+        mem_collect(&state, &state.mem);
+
+        /* ── Compressed-size estimate (worker thread) ── */
+        {
+            int ntiles = state.chr_cols * state.chr_rows;
+            TraceZone z = trace_begin("chrsize update");
+            chrsize_update(&state.chrsize, &state.chr, ntiles, state.edit_rev,
+                           state.chr_rev, state.tile_rev);
+            trace_end(z);
+        }
+
         render_frame(ren, &state);
-        SDL_Delay(16);
+        trace_end(frame_z);
+        if (replay_path)
+            frametimes_add(&times, (double)(SDL_GetPerformanceCounter() - frame_t0)
+                                   * 1000.0 / (double)SDL_GetPerformanceFrequency());
+        else
+            SDL_Delay(16);
+    }
+
+    /* ── Replay report: exit 1 on a bad recording, 3 over budget ── */
+    int status = 0;
+    if (replay_path) {
+        replay_close(&replay);
+        if (replay_rc < 0) status = 1;
+        if (frametimes_report(&times, stdout, times_path) != 0) {
+            fprintf(stderr, "can't write %s\n", times_path);
+            status = 1;
+        }
+        double p95 = frametimes_pct(&times, 95);
+        if (status == 0 && max_p95 > 0 && p95 > max_p95) {
+            fprintf(stderr, "replay: p95 %.3f ms over budget %.3f ms\n", p95, max_p95);
+            status = 3;
+        }
+        frametimes_free(&times);
+    }
+    rec_close(&rec);
+    if (stats) {
+        mem_collect(&state, &state.mem);
+        mem_print(&state, stdout);
     }
 
+    chrsize_free(&state.chrsize);
+    ctl_close();
+    watch_close();
+    input_free();
+    clip_close();
+    usage_free(&state.usage);
+    compose_free(&state.compose);
     render_destroy();
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     SDL_Quit();
-    return 0;
+    trace_close();
+    return status;
 }
@@ -2,6 +2,9 @@
 #include <stdbool.h>
 #include "chr.h"
 #include "compose.h"
+#include "usage.h"
+#include "tilehash.h"
+#include "chrsize.h"
 
 typedef enum {
     VIEW_GRAYSCALE,
@@ -15,7 +18,8 @@ typedef enum {
     WRAP_BOTH
 } WrapMode;
 
-typedef enum { INPUT_SAVE_AS, INPUT_OPEN, INPUT_RESIZE, INPUT_OPEN_PAL } InputType;
+typedef enum { INPUT_SAVE_AS, INPUT_OPEN, INPUT_RESIZE, INPUT_OPEN_PAL, INPUT_IMPORT,
+               INPUT_REPLACE } InputType;
 
 typedef enum {
     SPRITE_8,    /* standard 8×8 tile display                          */
@@ -31,6 +35,24 @@ typedef enum {
 
 typedef enum { COMPOSE_BG, COMPOSE_SPR } ComposeLayer;
 
+/* Memory in use, by subsystem; refreshed every frame by main.c. */
+typedef enum {
+    MEM_STATE,       /* EditorState itself: sheet, indexes, scene table */
+    MEM_UNDO,        /* undo entries allocated so far, with their logs  */
+    MEM_SCENES,      /* resident scenes                                 */
+    MEM_USAGE,       /* per-scene usage-index blocks                    */
+    MEM_TEXTURES,    /* streaming textures (pixel bytes)                */
+    MEM_WORKERS,     /* background workers' buffers                     */
+    MEM_KINDS
+} MemKind;
+
+typedef struct {
+    size_t bytes[MEM_KINDS];
+    size_t total, peak;
+    int    undo_steps;
+    int    scenes_resident;
+} MemReport;
+
 typedef struct {
     ChrPage      chr;
     PaletteState pal;
@@ -67,6 +89,9 @@ typedef struct {
     bool         tile_edit;         /* enlarged tile editor in panel        */
     int          sel_tile_x;        /* tile col of selection (sprite16: always even) */
     int          sel_tile_y;        /* tile row of selection (sprite16: always even) */
+    int          sel_w, sel_h;      /* selection size in tiles, as on screen        */
+    int          sel_anchor_x;      /* corner T was pressed on; Shift+T extends     */
+    int          sel_anchor_y;      /* from it                                      */
     WrapMode     wrap_mode;
 
     /* Input */
@@ -92,11 +117,15 @@ typedef struct {
 
     /* File operations */
     char         current_path[256]; /* active CHR file path for save/load  */
+    int          chr_format;        /* ChrFormat forced by --format, or -1 */
     bool         want_save;         /* save CHR to current_path            */
     bool         want_load;         /* load CHR from current_path          */
     char         pal_path[256];     /* palette file path for manual load   */
     bool         want_save_pal;     /* save palette (derived from current_path) */
     bool         want_load_pal;     /* load palette from pal_path          */
+    char         import_path[256];  /* image for the next import           */
+    bool         want_import;       /* import image into the active scene  */
+    int          import_budget_ms;  /* palette search time for that import */
 
     /* Text-input overlay (Save As / Open) */
     bool         input_mode;        /* text-input overlay is open          */
@@ -120,16 +149,17 @@ typedef struct {
     int          anim_preview_zoom; /* preview scale: 1 or 2 (click preview to toggle) */
     bool         anim_playing;      /* auto-advance frames when true              */
     int          anim_speed;        /* frames per second (default 8)              */
-    uint32_t     anim_last_tick;    /* SDL_GetTicks() of last frame advance       */
-
-    /* Clipboard (tile copy/paste in tile mode) */
-    bool         has_clipboard;
-    uint8_t      clipboard[4][TILE_H][TILE_W];  /* up to 4 sub-tiles (sprite-16) */
-    bool         clipboard_s16;                 /* was copy done in sprite-16 mode? */
+    uint32_t     anim_last_tick;    /* ticks of last frame advance                */
 
     /* Compose mode — NES screen layout editor */
     bool         compose_mode;
     ComposeData  compose;
+    UsageIndex   usage;              /* tile → cells/sprites, all scenes     */
+    TileHash     tilehash;           /* per-tile content hashes (dup finder) */
+    ChrSize      chrsize;            /* compressed sheet size, per bank      */
+    int          dup_view;           /* D: 0 off, 1 exact dups, 2 incl. flips */
+    bool         show_nearest;       /* Shift+D: nearest tiles to the current one */
+    bool         show_usage;         /* where-used overlay (U)               */
     ComposeLayer compose_layer;
     int          brush_tile;          /* selected tile from CHR picker       */
     bool         brush_hflip, brush_vflip;  /* sprite-only flip state        */
@@ -140,12 +170,22 @@ typedef struct {
     int          compose_hover_x;     /* tile col under cursor (-1 = none)   */
     int          compose_hover_y;     /* tile row under cursor (-1 = none)   */
     int          compose_spr_sel;     /* selected sprite index, -1 = none    */
+    int          cmp_sel_x, cmp_sel_y;   /* cell selection for copy (T)      */
+    int          cmp_sel_w, cmp_sel_h;   /* in cells, 0 = none               */
+    int          cmp_sel_ax, cmp_sel_ay; /* anchor; Shift+T extends from it  */
     int          compose_spr_drag;    /* sprite being dragged, -1 = none     */
     int          drag_off_x, drag_off_y; /* offset from sprite origin        */
     bool         compose_show_attr_grid; /* attribute grid (16px blocks)     */
     bool         compose_show_help;     /* compose help overlay              */
     bool         want_save_scene;
     bool         want_load_scene;
+    bool         want_export_nes;     /* write .nam/.oam for all scenes     */
+    bool         want_export_packed;  /* write .nrle/.nlz for all scenes    */
+    bool         want_near_report;    /* write .near.txt merge candidates   */
+    bool         want_compact;        /* pack used tiles to the front       */
+    bool         want_replace;        /* replace_from → replace_to everywhere */
+    int          replace_from, replace_to;
+    bool         replace_flips;       /* also match flipped variants        */
     char         scene_path[256];
 
     /* Compose preview dock (in paint mode) — shows active compose scene */
@@ -160,6 +200,30 @@ typedef struct {
     int          preview_pan_anchor_mx, preview_pan_anchor_my;
     int          preview_pan_anchor_px, preview_pan_anchor_py;
 
+    /* Scroll playback in the preview dock: scenes laid end to end
+       (side by side, or stacked when scroll_vertical) with a 256×240
+       camera moving along the strip at a fixed 60 Hz step.           */
+    bool         scroll_play;
+    bool         scroll_vertical;    /* false = side by side (vert. mirroring) */
+    int          scroll_speed;       /* camera px per 60 Hz frame (1..8)    */
+    int          scroll_pos;         /* camera offset along the strip (px)  */
+    uint32_t     scroll_t0;          /* ticks when playback began           */
+    uint32_t     scroll_frames;      /* 60 Hz frames stepped since t0       */
+
+    /* Change tracking.  Pixel edits only stamp the tiles they touch
+       (tile_rev[t] = ++chr_rev) so caches can find the affected cells
+       through the usage index; everything else bumps edit_rev.       */
+    uint32_t     edit_rev;           /* palette/scene edits, undo, loads     */
+    uint32_t     chr_rev;            /* last tile_rev stamp handed out       */
+    uint32_t     tile_rev[CHR_MAX_TILES];
+
+    /* Memory accounting; mem_cap (--mem-cap, 0 = none) limits the
+       undo history and new scenes, which are allocated on demand.    */
+    MemReport    mem;
+    size_t       mem_cap;
+
     /* Loop control */
     bool         running;
+    uint32_t     ticks;              /* ms clock for this frame: SDL_GetTicks(),
+                                        or the recorded one during --replay */
 } EditorState;
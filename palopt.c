@@ -0,0 +1,253 @@
+#include "palopt.h"
+#include "par.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FAR (1 << 20)      /* cost of a colour nothing can reproduce */
+#define LLOYD_MAX 32
+
+/* ── Colour distance ─────────────────────────────────────────── */
+
+static int            dist_tab[64][64];
+static pthread_once_t dist_once = PTHREAD_ONCE_INIT;
+
+static void dist_init(void) {
+    for (int a = 0; a < 64; a++)
+        for (int b = 0; b < 64; b++) {
+            const uint8_t *x = NES_MASTER_RGB[a], *y = NES_MASTER_RGB[b];
+            int dr = x[0] - y[0], dg = x[1] - y[1], db = x[2] - y[2];
+            /* weighted squared RGB: green counts most, blue least */
+            dist_tab[a][b] = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+        }
+}
+
+/* Built once, even when imports run on several threads at once. */
+const int (*palopt_dist_table(void))[64] {
+    pthread_once(&dist_once, dist_init);
+    return (const int (*)[64])dist_tab;
+}
+
+/* ── Shared problem data ─────────────────────────────────────── */
+
+typedef struct {
+    uint8_t col[4][3];
+    int64_t err;
+    int     restarts;
+} Chain;
+
+typedef struct {
+    const PalOptInput *in;
+    const int (*d)[64];
+    int      nblocks;
+    /* Blocks as sparse (colour, count) lists; base is the cost of the
+       entry with no palette colour (backdrop distance, or FAR).    */
+    int      nent[PALOPT_MAX_BLOCKS];
+    uint8_t  ecol[PALOPT_MAX_BLOCKS][64];
+    int      ecnt[PALOPT_MAX_BLOCKS][64];
+    int      ebase[PALOPT_MAX_BLOCKS][64];
+    uint8_t  want[PALOPT_MAX_BLOCKS][3];  /* top colours, PALOPT_NONE-padded */
+    uint8_t  cand[64];                     /* colours worth trying         */
+    int      ncand;
+    double   deadline;                     /* ms, same clock as now_ms     */
+    bool     restarts;
+    Chain    chain[PAR_MAX_THREADS];
+} Problem;
+
+static double now_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static uint32_t xorshift(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+/* ── Cost and the k-means steps ──────────────────────────────── */
+
+static int64_t block_cost(const Problem *pr, int b, const uint8_t p[3]) {
+    int64_t cost = 0;
+    for (int e = 0; e < pr->nent[b]; e++) {
+        int c = pr->ecol[b][e], best = pr->ebase[b][e];
+        for (int k = 0; k < 3; k++)
+            if (p[k] != PALOPT_NONE && pr->d[c][p[k]] < best) best = pr->d[c][p[k]];
+        cost += (int64_t)best * pr->ecnt[b][e];
+    }
+    return cost;
+}
+
+/* Give every block its cheapest palette.  Returns the total cost;
+   berr (optional) receives each block's share.                    */
+static int64_t assign(const Problem *pr, const uint8_t col[4][3],
+                      uint8_t bp[], int64_t berr[]) {
+    int64_t total = 0;
+    for (int b = 0; b < pr->nblocks; b++) {
+        int64_t best = -1;
+        for (int p = 0; p < 4; p++) {
+            int64_t c = block_cost(pr, b, col[p]);
+            if (best < 0 || c < best) { best = c; bp[b] = (uint8_t)p; }
+        }
+        if (berr) berr[b] = best;
+        total += best;
+    }
+    return total;
+}
+
+/* Coordinate descent on palette p's three slots over its blocks. */
+static void refit(const Problem *pr, uint8_t col[4][3], const uint8_t bp[], int p) {
+    int64_t cur = 0;
+    for (int b = 0; b < pr->nblocks; b++)
+        if (bp[b] == p) cur += block_cost(pr, b, col[p]);
+
+    for (bool improved = true; improved && cur > 0; ) {
+        improved = false;
+        for (int k = 0; k < 3; k++) {
+            uint8_t keep = col[p][k];
+            for (int i = 0; i < pr->ncand; i++) {
+                col[p][k] = pr->cand[i];
+                int64_t c = 0;
+                for (int b = 0; b < pr->nblocks && c < cur; b++)
+                    if (bp[b] == p) c += block_cost(pr, b, col[p]);
+                if (c < cur) { cur = c; keep = pr->cand[i]; improved = true; }
+            }
+            col[p][k] = keep;
+        }
+    }
+}
+
+static int64_t lloyd(const Problem *pr, uint8_t col[4][3]) {
+    uint8_t bp[PALOPT_MAX_BLOCKS];
+    int64_t err = assign(pr, col, bp, NULL);
+    for (int it = 0; it < LLOYD_MAX && err > 0; it++) {
+        for (int p = 0; p < 4; p++) refit(pr, col, bp, p);
+        int64_t e = assign(pr, col, bp, NULL);
+        if (e >= err) break;
+        err = e;
+    }
+    return err;
+}
+
+/* Restart: each palette takes the top colours of a block picked with
+   probability proportional to its error under the best cover.    */
+static void reseed(const Problem *pr, const uint8_t best[4][3], uint32_t *rng,
+                   uint8_t col[4][3]) {
+    uint8_t bp[PALOPT_MAX_BLOCKS];
+    int64_t berr[PALOPT_MAX_BLOCKS], sum = 0;
+    assign(pr, best, bp, berr);
+    for (int b = 0; b < pr->nblocks; b++) sum += berr[b] + 1;
+
+    for (int p = 0; p < 4; p++) {
+        uint64_t x = ((uint64_t)xorshift(rng) << 32) | xorshift(rng);
+        int64_t  r = (int64_t)(x % (uint64_t)sum);
+        int b = 0;
+        while (b < pr->nblocks - 1 && r >= berr[b] + 1) { r -= berr[b] + 1; b++; }
+        memcpy(col[p], pr->want[b], 3);
+    }
+}
+
+/* One restart chain per worker index. */
+static void chain_run(void *ctx, int i0, int i1) {
+    Problem *pr = ctx;
+    for (int i = i0; i < i1; i++) {
+        Chain *ch = &pr->chain[i];
+        uint32_t rng = 0x9E3779B9u * (uint32_t)(i + 1);
+        uint8_t col[4][3];
+
+        if (i == 0 && pr->in->has_seed) memcpy(col, pr->in->seed, sizeof(col));
+        else                            memset(col, PALOPT_NONE, sizeof(col));
+        if (i > 0) reseed(pr, col, &rng, col);
+        ch->err = lloyd(pr, col);
+        memcpy(ch->col, col, sizeof(col));
+        ch->restarts = 0;
+
+        while (pr->restarts && ch->err > 0 && now_ms() < pr->deadline) {
+            reseed(pr, ch->col, &rng, col);
+            int64_t e = lloyd(pr, col);
+            if (e < ch->err) { ch->err = e; memcpy(ch->col, col, sizeof(col)); }
+            ch->restarts++;
+        }
+    }
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+int palopt_run(const PalOptInput *in, int budget_ms, PalOptResult *out) {
+    if (in->nblocks < 1 || in->nblocks > PALOPT_MAX_BLOCKS) return -1;
+    Problem *pr = malloc(sizeof(*pr));
+    if (!pr) return -1;
+    pr->in       = in;
+    pr->d        = palopt_dist_table();
+    pr->nblocks  = in->nblocks;
+    pr->restarts = budget_ms > 0;
+    pr->deadline = now_ms() + budget_ms;
+
+    bool seen[64] = { false };
+    for (int b = 0; b < in->nblocks; b++) {
+        const int *h = in->hist[b];
+        int n = 0;
+        for (int c = 0; c < 64; c++) {
+            if (h[c] <= 0) continue;
+            pr->ecol[b][n]  = (uint8_t)c;
+            pr->ecnt[b][n]  = h[c];
+            pr->ebase[b][n] = in->backdrop >= 0 ? pr->d[c][in->backdrop] : FAR;
+            n++;
+            if (c != in->backdrop) seen[c] = true;
+        }
+        pr->nent[b] = n;
+
+        memset(pr->want[b], PALOPT_NONE, 3);
+        for (int k = 0; k < 3; k++) {
+            int best = -1;
+            for (int e = 0; e < n; e++) {
+                int c = pr->ecol[b][e];
+                if (c == in->backdrop || memchr(pr->want[b], c, (size_t)k)) continue;
+                if (best < 0 || pr->ecnt[b][e] > h[best]) best = c;
+            }
+            if (best < 0) break;
+            pr->want[b][k] = (uint8_t)best;
+        }
+    }
+    pr->ncand = 0;
+    for (int c = 0; c < 64; c++) if (seen[c]) pr->cand[pr->ncand++] = (uint8_t)c;
+
+    int nchains = pr->restarts ? par_threads() : 1;
+    par_for(nchains, 1, chain_run, pr);
+
+    int best = 0;
+    out->restarts = 0;
+    for (int i = 0; i < nchains; i++) {
+        if (pr->chain[i].err < pr->chain[best].err) best = i;
+        out->restarts += pr->chain[i].restarts;
+    }
+    memcpy(out->col, pr->chain[best].col, sizeof(out->col));
+
+    int64_t berr[PALOPT_MAX_BLOCKS];
+    out->error = assign(pr, out->col, out->block_pal, berr);
+    int64_t exact = 0, total = 0;
+    out->lossy_blocks = 0;
+    for (int b = 0; b < in->nblocks; b++) {
+        out->lossy_blocks += berr[b] > 0;
+        const uint8_t *p = out->col[out->block_pal[b]];
+        for (int e = 0; e < pr->nent[b]; e++) {
+            int c = pr->ecol[b][e];
+            total += pr->ecnt[b][e];
+            if (c == in->backdrop || memchr(p, c, 3)) exact += pr->ecnt[b][e];
+        }
+    }
+    out->quality = total ? 100.0 * (double)exact / (double)total : 100.0;
+    free(pr);
+    return 0;
+}
+
+void palopt_store(const PalOptResult *r, int backdrop, PaletteState *pal, int base) {
+    for (int p = 0; p < 4; p++) {
+        SubPalette *sp = &pal->sub[base + p];
+        if (backdrop >= 0) sp->idx[0] = (uint8_t)backdrop;
+        for (int k = 0; k < 3; k++)
+            sp->idx[k + 1] = r->col[p][k] != PALOPT_NONE ? r->col[p][k] : sp->idx[0];
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "chr.h"
+
+/* ── Sub-palette optimiser ───────────────────────────────────────
+   Chooses four 3-colour palettes (colours 1-3 of a sub-palette) that
+   best cover a set of blocks — attribute blocks for the background,
+   sprites for the sprite layer — where each block uses exactly one
+   palette.  A block is a histogram over the 64 master colours; its
+   cost under a palette is the count-weighted distance from every
+   colour to the nearest palette colour (colour 0 counts as
+   available when it is a shared backdrop).
+
+   Search: k-means style alternation — assign every block its
+   cheapest palette, then refit each palette's colours slot by slot
+   against its blocks — from a seed, then from random restarts that
+   favour badly covered blocks.  Each CPU runs its own restart chain
+   (par_for) until the time budget runs out or a zero-error cover is
+   found; the best cover wins.                                     */
+
+#define PALOPT_MAX_BLOCKS 256
+#define PALOPT_NONE       0xFF     /* unused palette slot */
+
+typedef struct {
+    int     nblocks;
+    int     hist[PALOPT_MAX_BLOCKS][64];
+    int     backdrop;       /* shared colour 0, or -1 if colour 0 is
+                               transparent (sprites; leave it out of
+                               the histograms)                       */
+    bool    has_seed;
+    uint8_t seed[4][3];     /* optional starting cover (PALOPT_NONE = empty) */
+} PalOptInput;
+
+typedef struct {
+    uint8_t col[4][3];                    /* PALOPT_NONE = unused   */
+    uint8_t block_pal[PALOPT_MAX_BLOCKS];
+    int64_t error;           /* weighted colour error, 0 = exact        */
+    double  quality;         /* % of pixels reproduced exactly          */
+    int     lossy_blocks;    /* blocks with non-zero error              */
+    int     restarts;        /* restarts completed across all threads   */
+} PalOptResult;
+
+/* Weighted RGB distance between master colours, [a][b].  Built on
+   first call; call once before sharing it across threads.        */
+const int (*palopt_dist_table(void))[64];
+
+/* Run for up to budget_ms (0 = seed refinement only).  Returns 0, or
+   -1 if nblocks is out of range or memory runs out.               */
+int  palopt_run(const PalOptInput *in, int budget_ms, PalOptResult *out);
+
+/* Write the cover into sub-palettes base..base+3 (0 = BG, 4 = sprites).
+   Unused slots repeat the backdrop (or colour 0 of the slot).     */
+void palopt_store(const PalOptResult *r, int backdrop, PaletteState *pal, int base);
@@ -0,0 +1,52 @@
+#include "par.h"
+#include "trace.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <stdbool.h>
+
+int par_threads(void) {
+    static int n = 0;
+    if (n == 0) {
+        long c = sysconf(_SC_NPROCESSORS_ONLN);
+        n = c < 1 ? 1 : c > PAR_MAX_THREADS ? PAR_MAX_THREADS : (int)c;
+    }
+    return n;
+}
+
+typedef struct {
+    ParFn fn;
+    void *ctx;
+    int   begin, end;
+} ParJob;
+
+static void *par_worker(void *arg) {
+    ParJob *j = arg;
+    trace_thread_name("par worker");
+    TraceZone z = trace_begin("par range");
+    j->fn(j->ctx, j->begin, j->end);
+    trace_end(z);
+    return NULL;
+}
+
+void par_for(int n, int grain, ParFn fn, void *ctx) {
+    if (n <= 0) return;
+    if (grain < 1) grain = 1;
+    int nt = par_threads();
+    if (nt > n / grain) nt = n / grain;
+    if (nt < 2) { fn(ctx, 0, n); return; }
+
+    /* Thread 0 is the caller; a failed spawn runs its range inline. */
+    ParJob    job[PAR_MAX_THREADS];
+    pthread_t tid[PAR_MAX_THREADS];
+    bool      spawned[PAR_MAX_THREADS] = { false };
+    for (int i = 0; i < nt; i++)
+        job[i] = (ParJob){ fn, ctx, (int)((long)n * i / nt),
+                           (int)((long)n * (i + 1) / nt) };
+    for (int i = 1; i < nt; i++)
+        spawned[i] = pthread_create(&tid[i], NULL, par_worker, &job[i]) == 0;
+    fn(ctx, job[0].begin, job[0].end);
+    for (int i = 1; i < nt; i++) {
+        if (spawned[i]) pthread_join(tid[i], NULL);
+        else            fn(ctx, job[i].begin, job[i].end);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+/* ── Parallel for ────────────────────────────────────────────────
+   Splits [0, n) into contiguous ranges and runs fn(ctx, begin, end)
+   on each from a short-lived pool of POSIX threads, returning once
+   all ranges are done.  Ranges never overlap, so workers may write
+   to disjoint parts of shared output without locking.  Falls back to
+   a single inline call when n < 2 * grain or only one CPU is online. */
+
+typedef void (*ParFn)(void *ctx, int begin, int end);
+
+#define PAR_MAX_THREADS 16
+
+/* Online CPUs, clamped to 1..PAR_MAX_THREADS. */
+int  par_threads(void);
+
+void par_for(int n, int grain, ParFn fn, void *ctx);
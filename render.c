@@ -2,49 +2,20 @@
 #include "panel.h"
 #include "font.h"
 #include "compose.h"
+#include "export.h"
+#include "compress.h"
+#include "usage.h"
+#include "swrender.h"
+#include "trace.h"
+#include "clip.h"
 #include <stdio.h>
 #include <string.h>
 
-/* ── NES master palette (NTSC 2C02) ──────────────────────────────
-   64 hardware-defined colours. Indices $0E/$0F/$1E/$1F/$2E/$2F/
-   $3E/$3F are black on real hardware; kept as black here.         */
-static const SDL_Color NES_MASTER_PALETTE[64] = {
-    /* $00 */ {  84,  84,  84, 255 }, /* $01 */ {   0,  30, 116, 255 },
-    /* $02 */ {   8,  16, 144, 255 }, /* $03 */ {  48,   0, 136, 255 },
-    /* $04 */ {  68,   0, 100, 255 }, /* $05 */ {  92,   0,  48, 255 },
-    /* $06 */ {  84,   4,   0, 255 }, /* $07 */ {  60,  24,   0, 255 },
-    /* $08 */ {  32,  42,   0, 255 }, /* $09 */ {   8,  58,   0, 255 },
-    /* $0A */ {   0,  64,   0, 255 }, /* $0B */ {   0,  60,   0, 255 },
-    /* $0C */ {   0,  50,  60, 255 }, /* $0D */ {   0,   0,   0, 255 },
-    /* $0E */ {   0,   0,   0, 255 }, /* $0F */ {   0,   0,   0, 255 },
-
-    /* $10 */ { 152, 150, 152, 255 }, /* $11 */ {   8,  76, 196, 255 },
-    /* $12 */ {  48,  50, 236, 255 }, /* $13 */ {  92,  30, 228, 255 },
-    /* $14 */ { 136,  20, 176, 255 }, /* $15 */ { 160,  20, 100, 255 },
-    /* $16 */ { 152,  34,  32, 255 }, /* $17 */ { 120,  60,   0, 255 },
-    /* $18 */ {  84,  90,   0, 255 }, /* $19 */ {  40, 114,   0, 255 },
-    /* $1A */ {   8, 124,   0, 255 }, /* $1B */ {   0, 118,  40, 255 },
-    /* $1C */ {   0, 102, 120, 255 }, /* $1D */ {   0,   0,   0, 255 },
-    /* $1E */ {   0,   0,   0, 255 }, /* $1F */ {   0,   0,   0, 255 },
-
-    /* $20 */ { 236, 238, 236, 255 }, /* $21 */ {  76, 154, 236, 255 },
-    /* $22 */ { 120, 124, 236, 255 }, /* $23 */ { 176,  98, 236, 255 },
-    /* $24 */ { 228,  84, 236, 255 }, /* $25 */ { 236,  88, 180, 255 },
-    /* $26 */ { 236, 106, 100, 255 }, /* $27 */ { 212, 136,  32, 255 },
-    /* $28 */ { 160, 170,   0, 255 }, /* $29 */ { 116, 196,   0, 255 },
-    /* $2A */ {  76, 208,  32, 255 }, /* $2B */ {  56, 204, 108, 255 },
-    /* $2C */ {  56, 180, 204, 255 }, /* $2D */ {  60,  60,  60, 255 },
-    /* $2E */ {   0,   0,   0, 255 }, /* $2F */ {   0,   0,   0, 255 },
-
-    /* $30 */ { 236, 238, 236, 255 }, /* $31 */ { 168, 204, 236, 255 },
-    /* $32 */ { 188, 188, 236, 255 }, /* $33 */ { 212, 178, 236, 255 },
-    /* $34 */ { 236, 174, 236, 255 }, /* $35 */ { 236, 174, 212, 255 },
-    /* $36 */ { 236, 180, 176, 255 }, /* $37 */ { 228, 196, 144, 255 },
-    /* $38 */ { 204, 210, 120, 255 }, /* $39 */ { 180, 222, 120, 255 },
-    /* $3A */ { 168, 226, 144, 255 }, /* $3B */ { 152, 226, 180, 255 },
-    /* $3C */ { 160, 214, 228, 255 }, /* $3D */ { 160, 162, 160, 255 },
-    /* $3E */ {   0,   0,   0, 255 }, /* $3F */ {   0,   0,   0, 255 },
-};
+/* NES master palette entry as an SDL colour (table lives in chr.c). */
+static inline SDL_Color nes_rgb(int i) {
+    const uint8_t *c = NES_MASTER_RGB[i & 0x3F];
+    return (SDL_Color){ c[0], c[1], c[2], 255 };
+}
 
 /* Grayscale ramp used in VIEW_GRAYSCALE mode. */
 static const SDL_Color GRAY_RAMP[4] = {
@@ -59,6 +30,30 @@ static const SDL_Color GRAY_RAMP[4] = {
 static SDL_Texture *canvas_tex  = NULL;
 static SDL_Texture *compose_tex = NULL;   /* 256x240 for compose mode */
 
+/* compose_tex is redrawn only when the active scene, a palette or a
+   tile that the scene actually references has changed.             */
+static bool     cmp_tex_valid   = false;
+static int      cmp_tex_scene   = -1;
+static uint32_t cmp_tex_rev     = 0;
+static uint32_t cmp_tex_chr_rev = 0;
+
+/* Scroll preview ring: a 512×480 texture holding the camera's
+   neighbourhood as 8-px strips (64 columns when scrolling
+   horizontally, 60 rows vertically).  Strip u of the scene strip
+   lives in slot u % slots; only strips whose slot tag is stale get
+   redrawn, so a moving camera costs one strip per 8 px of travel.  */
+#define RING_W     512
+#define RING_H     480
+#define RING_SLOTS 64
+static SDL_Texture *ring_tex = NULL;
+static int      ring_tag[RING_SLOTS];   /* strip held by each slot, -1 = none */
+static bool     ring_valid    = false;
+static bool     ring_vertical = false;
+static int      ring_count    = 0;       /* scene_count the tags refer to     */
+static uint32_t ring_rev      = 0;       /* edit_rev the tags refer to        */
+static uint32_t ring_chr_rev  = 0;       /* chr_rev  the tags refer to        */
+static uint8_t  ring_dirty[COMPOSE_MAX_SCENES * (256 / 8)];  /* by strip    */
+
 static void create_canvas_tex(SDL_Renderer *ren, const EditorState *s) {
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
     int tex_w = s->chr_cols * TILE_W;
@@ -79,11 +74,23 @@ static void create_compose_tex(SDL_Renderer *ren) {
         SDL_TEXTUREACCESS_STREAMING, 256, 240);
     if (!compose_tex)
         fprintf(stderr, "compose_tex: %s\n", SDL_GetError());
+    cmp_tex_valid = false;
+}
+
+static void create_ring_tex(SDL_Renderer *ren) {
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+    ring_tex = SDL_CreateTexture(
+        ren, SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING, RING_W, RING_H);
+    if (!ring_tex)
+        fprintf(stderr, "ring_tex: %s\n", SDL_GetError());
+    ring_valid = false;
 }
 
 void render_init(SDL_Renderer *ren, const EditorState *s) {
     create_canvas_tex(ren, s);
     create_compose_tex(ren);
+    create_ring_tex(ren);
 }
 
 void render_resize(SDL_Renderer *ren, const EditorState *s) {
@@ -91,11 +98,24 @@ void render_resize(SDL_Renderer *ren, const EditorState *s) {
     create_canvas_tex(ren, s);
     if (compose_tex) { SDL_DestroyTexture(compose_tex); compose_tex = NULL; }
     create_compose_tex(ren);
+    if (ring_tex) { SDL_DestroyTexture(ring_tex); ring_tex = NULL; }
+    create_ring_tex(ren);
 }
 
 void render_destroy(void) {
     if (canvas_tex)  { SDL_DestroyTexture(canvas_tex);  canvas_tex  = NULL; }
     if (compose_tex) { SDL_DestroyTexture(compose_tex); compose_tex = NULL; }
+    if (ring_tex)    { SDL_DestroyTexture(ring_tex);    ring_tex    = NULL; }
+}
+
+static size_t tex_bytes(SDL_Texture *t) {
+    int w = 0, h = 0;
+    if (!t || SDL_QueryTexture(t, NULL, NULL, &w, &h) != 0) return 0;
+    return (size_t)w * h * 4;
+}
+
+size_t render_mem(void) {
+    return tex_bytes(canvas_tex) + tex_bytes(compose_tex) + tex_bytes(ring_tex);
 }
 
 /* ── Focus zoom / scrollbar helpers ───────────────────────────── */
@@ -113,7 +133,7 @@ static SDL_Color get_display_color(const EditorState *s, int tile, int val) {
 
     uint8_t sub    = s->pal.tile_pal[tile];
     uint8_t master = s->pal.sub[sub & (PAL_COUNT - 1)].idx[val & 3] & 0x3F;
-    return NES_MASTER_PALETTE[master];
+    return nes_rgb(master);
 }
 
 /* ── Canvas rendering ─────────────────────────────────────────── */
@@ -126,50 +146,9 @@ static void render_canvas(const EditorState *s) {
         return;
     }
 
-    uint32_t *dst    = (uint32_t *)pixels;
-    int       stride = pitch / 4;
-    int       ntiles = s->chr_cols * s->chr_rows;
-
-    /* Sprite-16 layout: 4 sequential tiles → [0][2]
-                                               [1][3]
-       p=0 top-left, p=1 bottom-left, p=2 top-right, p=3 bottom-right
-       sub_x = p>>1 (col within sprite), sub_y = p&1 (row within sprite) */
-    if (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) {
-        int sprite_cols = s->chr_cols / 2;
-        for (int tile = 0; tile < ntiles; tile++) {
-            int p  = tile % 4;
-            int S  = tile / 4;
-            int sx = S % sprite_cols;
-            int sy = S / sprite_cols;
-            int tx = (sx * 2 + (p >> 1)) * TILE_W;
-            int ty = (sy * 2 + (p  & 1)) * TILE_H;
-
-            for (int row = 0; row < TILE_H; row++) {
-                for (int col = 0; col < TILE_W; col++) {
-                    uint8_t   val = s->chr.px[tile][row][col] & 3;
-                    SDL_Color c   = get_display_color(s, tile, val);
-                    dst[(ty + row) * stride + (tx + col)] =
-                        (0xFFu << 24) | ((uint32_t)c.r << 16) |
-                        ((uint32_t)c.g <<  8) | c.b;
-                }
-            }
-        }
-    } else {
-        for (int tile = 0; tile < ntiles; tile++) {
-            int tx = (tile % s->chr_cols) * TILE_W;
-            int ty = (tile / s->chr_cols) * TILE_H;
-
-            for (int row = 0; row < TILE_H; row++) {
-                for (int col = 0; col < TILE_W; col++) {
-                    uint8_t   val = s->chr.px[tile][row][col] & 3;
-                    SDL_Color c   = get_display_color(s, tile, val);
-                    dst[(ty + row) * stride + (tx + col)] =
-                        (0xFFu << 24) | ((uint32_t)c.r << 16) |
-                        ((uint32_t)c.g <<  8) | c.b;
-                }
-            }
-        }
-    }
+    swr_sheet(&s->chr, &s->pal, s->chr_cols, s->chr_rows,
+              s->view_mode == VIEW_GRAYSCALE, s->sprite_mode == SPRITE_16,
+              (uint32_t *)pixels, pitch / 4);
 
     SDL_UnlockTexture(canvas_tex);
 }
@@ -200,9 +179,14 @@ static void vline(SDL_Renderer *ren, int x, int y, int len,
 
 /* ── Grid overlays ────────────────────────────────────────────── */
 
+/* Grid colours are shared with swr_grid so exported images match. */
+static void set_grid_color(SDL_Renderer *ren, uint32_t c) {
+    SDL_SetRenderDrawColor(ren, (c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, c >> 24);
+}
+
 static void render_tile_grid(SDL_Renderer *ren, const EditorState *s) {
     SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(ren, 60, 100, 200, 130);
+    set_grid_color(ren, SWR_GRID_TILE);
 
     int scale = fz_scale_r(s);
     for (int i = 1; i < s->chr_cols; i++) {
@@ -221,7 +205,7 @@ static void render_tile_grid(SDL_Renderer *ren, const EditorState *s) {
 
 static void render_pixel_grid(SDL_Renderer *ren, const EditorState *s) {
     SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(ren, 80, 80, 110, 55);
+    set_grid_color(ren, SWR_GRID_PIXEL);
 
     int scale    = fz_scale_r(s);
     int nes_cols = s->chr_cols * TILE_W;
@@ -243,6 +227,56 @@ static void render_pixel_grid(SDL_Renderer *ren, const EditorState *s) {
     SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
 }
 
+/* Screen position of tile t's top-left corner on the CHR canvas. */
+static void tile_screen_r(const EditorState *s, int t, int *sx, int *sy) {
+    int nx, ny;
+    if (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) {
+        int S = t / 4, p = t % 4, cols = s->chr_cols / 2;
+        nx = ((S % cols) * 2 + p / 2) * TILE_W;
+        ny = ((S / cols) * 2 + p % 2) * TILE_H;
+    } else {
+        nx = (t % s->chr_cols) * TILE_W;
+        ny = (t / s->chr_cols) * TILE_H;
+    }
+    int scale = fz_scale_r(s);
+    *sx = (nx - s->pan_x) * scale;
+    *sy = (ny - s->pan_y) * scale;
+}
+
+/* ── Duplicate-tile overlay ───────────────────────────────────────
+   Tints every tile that shares its content (dup_view 1) or its
+   content up to an H/V flip (dup_view 2) with another tile; members
+   of one group share a colour picked from the group's first tile. */
+static void render_dup_overlay(SDL_Renderer *ren, const EditorState *s) {
+    if (s->dup_view == 0) return;
+
+    static const SDL_Color GROUP[8] = {
+        { 255,  80,  80, 0 }, {  80, 220,  80, 0 }, {  80, 140, 255, 0 },
+        { 255, 200,  40, 0 }, { 220,  80, 255, 0 }, {  40, 220, 220, 0 },
+        { 255, 140,  40, 0 }, { 160, 255, 120, 0 },
+    };
+
+    int ntiles = s->chr_cols * s->chr_rows;
+    if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+    int16_t rep[CHR_MAX_TILES], size[CHR_MAX_TILES];
+    tilehash_clusters(&s->tilehash, ntiles, s->dup_view == 2, rep, size);
+
+    int scale = fz_scale_r(s);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    for (int t = 0; t < ntiles; t++) {
+        if (size[t] < 2) continue;
+        int sx, sy;
+        tile_screen_r(s, t, &sx, &sy);
+        SDL_Color c = GROUP[rep[t] % 8];
+        SDL_Rect r = { sx, sy, TILE_W * scale, TILE_H * scale };
+        SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, 90);
+        SDL_RenderFillRect(ren, &r);
+        SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, 220);
+        SDL_RenderDrawRect(ren, &r);
+    }
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+}
+
 /* ── Animation helpers ────────────────────────────────────────── */
 
 /* Compute screen position and base tile for animation frame f. */
@@ -310,12 +344,11 @@ static void draw_ghost_tile(SDL_Renderer *ren, const EditorState *s,
 static void render_tile_highlight(SDL_Renderer *ren, const EditorState *s) {
     if (!s->tile_mode) return;
 
-    int mult  = (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2) ? 2 : 1;
     int scale = fz_scale_r(s);
     int tx = (s->sel_tile_x * TILE_W - s->pan_x) * scale;
     int ty = (s->sel_tile_y * TILE_H - s->pan_y) * scale;
-    int tw = TILE_W * mult * scale;
-    int th = TILE_H * mult * scale;
+    int tw = TILE_W * s->sel_w * scale;
+    int th = TILE_H * s->sel_h * scale;
 
     SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
     SDL_SetRenderDrawColor(ren, 0, 0, 0, 180);
@@ -387,7 +420,111 @@ static int screen_to_tile_idx(const EditorState *s, int mx, int my) {
     return (ny / TILE_H) * s->chr_cols + (nx / TILE_W);
 }
 
+static int sel_tile_idx_r(const EditorState *s) {
+    if (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2)
+        return ((s->sel_tile_y / 2) * (s->chr_cols / 2) + (s->sel_tile_x / 2)) * 4;
+    return s->sel_tile_y * s->chr_cols + s->sel_tile_x;
+}
+
+/* Tile the where-used overlay describes in paint mode. */
+static int usage_tile_r(const EditorState *s) {
+    int mx = s->mouse_x, my = s->mouse_y;
+    if (mx >= 0 && mx < s->canvas_w && my >= 0 && my < s->canvas_h)
+        return screen_to_tile_idx(s, mx, my);
+    return s->tile_mode ? sel_tile_idx_r(s) : -1;
+}
+
+/* "USED 12 BG 3 SPR 2 SCN" for tile, or "UNUSED". */
+static void usage_label(const EditorState *s, int tile, char *buf, size_t n) {
+    int bg, spr, scn;
+    usage_summary(&s->usage, tile, &bg, &spr, &scn);
+    if (bg + spr == 0)
+        snprintf(buf, n, "#%d UNUSED", tile);
+    else
+        snprintf(buf, n, "#%d USED %d BG %d SPR %d SCN", tile, bg, spr, scn);
+}
+
+/* ── Nearest-tile overlay ─────────────────────────────────────────
+   Outlines the NEAREST_K tiles closest to the current tile (flips
+   allowed) and labels each with its pixel distance.               */
+#define NEAREST_K 8
+
+static void render_nearest_overlay(SDL_Renderer *ren, const EditorState *s) {
+    if (!s->show_nearest) return;
+    int tile = usage_tile_r(s);
+    if (tile < 0) return;
+
+    int ntiles = s->chr_cols * s->chr_rows;
+    TileMatch m[NEAREST_K];
+    int n = tilehash_nearest(&s->tilehash, ntiles, tile, true, NEAREST_K, m);
+
+    int scale = fz_scale_r(s);
+    static const SDL_Color NCOL = {0, 230, 255, 255};
+    for (int i = 0; i < n; i++) {
+        int sx, sy;
+        tile_screen_r(s, m[i].b, &sx, &sy);
+        SDL_SetRenderDrawColor(ren, NCOL.r, NCOL.g, NCOL.b, 255);
+        SDL_Rect r = { sx, sy, TILE_W * scale, TILE_H * scale };
+        SDL_RenderDrawRect(ren, &r);
+        char dbuf[8];
+        snprintf(dbuf, sizeof(dbuf), "%d", m[i].dist);
+        fill(ren, sx + 1, sy + 1, (int)strlen(dbuf) * font_char_w_s(1) + 1,
+             font_line_h_s(1), 0, 0, 0);
+        font_draw_str_s(ren, dbuf, sx + 2, sy + 1, NCOL, 1);
+    }
+}
+
 /* ── Status bar ───────────────────────────────────────────────── */
+/* Compressed size of the pattern table under the cursor, or of the
+   whole sheet: "CHR RLE 3310 LZ 2912 PRED 2700/8192", '*' while a bank is
+   still being recompressed.                                        */
+static void size_label(const EditorState *s, char *buf, size_t n) {
+    ChrSizeReport r;
+    chrsize_report(&s->chrsize, &r);
+    buf[0] = '\0';
+    if (r.nbanks == 0) return;
+
+    const long *size = r.total;
+    long raw = r.raw_total;
+    int  len = 0;
+    int  tile = usage_tile_r(s);
+    if (tile >= 0 && tile / CHRSIZE_BANK_TILES < r.nbanks) {
+        int b = tile / CHRSIZE_BANK_TILES;
+        size  = r.size[b];
+        raw   = r.raw[b];
+        len   = snprintf(buf, n, "PT%d", b);
+    } else {
+        len   = snprintf(buf, n, "CHR");
+    }
+    for (int c = 0; c < CHRSIZE_CODECS && len < (int)n; c++) {
+        if (size[c] < 0) len += snprintf(buf + len, n - len, " %s -", chrsize_codec_name(c));
+        else             len += snprintf(buf + len, n - len, " %s %ld", chrsize_codec_name(c), size[c]);
+    }
+    if (len < (int)n)
+        snprintf(buf + len, n - len, "/%ld%s", raw, r.pending ? "*" : "");
+}
+
+/* "MEM 4.9M", or "MEM 4.9/16M" under a cap; *hot when within 10%. */
+static void mem_label(const EditorState *s, char *buf, size_t n, bool *hot) {
+    double mb = s->mem.total / (1024.0 * 1024.0);
+    if (s->mem_cap) {
+        snprintf(buf, n, "MEM %.1f/%.0fM", mb, s->mem_cap / (1024.0 * 1024.0));
+        *hot = s->mem.total * 10 >= s->mem_cap * 9;
+    } else {
+        snprintf(buf, n, "MEM %.1fM", mb);
+        *hot = false;
+    }
+}
+
+/* What the shared clipboard holds, e.g. "CLIP 32X8"; "" if empty. */
+static void clip_label(char *buf, size_t n) {
+    const ClipData *d = clip_get();
+    if (!d || d->kind == CLIP_EMPTY)
+        buf[0] = '\0';
+    else
+        snprintf(buf, n, "CLIP %dX%d%s", d->w, d->h, d->kind == CLIP_CELLS ? " CELLS" : "");
+}
+
 static void render_status(SDL_Renderer *ren, const EditorState *s) {
     const int STATUS_Y = s->win_h - STATUS_H;
     fill(ren, 0, STATUS_Y, s->win_w, STATUS_H, 12, 12, 12);
@@ -445,6 +582,19 @@ static void render_status(SDL_Renderer *ren, const EditorState *s) {
         }
     }
 
+    /* Where-used summary for the tile under the cursor (or selected) */
+    if (s->show_usage) {
+        int tile = usage_tile_r(s);
+        if (tile >= 0) {
+            char ubuf[48];
+            usage_label(s, tile, ubuf, sizeof(ubuf));
+            int ux = 96 + (s->show_addr ? 25 * font_char_w() : 0);
+            int ty_use = STATUS_Y + (STATUS_H - font_line_h()) / 2 + 1;
+            static const SDL_Color USEC = {255, 230, 40, 255};
+            font_draw_str(ren, ubuf, ux, ty_use, USEC);
+        }
+    }
+
     /* Zoom and sprite-mode indicators — right-aligned so they always fit. */
     {
         int ty_ind = STATUS_Y + (STATUS_H - font_line_h()) / 2 + 1;
@@ -475,6 +625,43 @@ static void render_status(SDL_Renderer *ren, const EditorState *s) {
             static const SDL_Color ANIMCOL = {0, 200, 255, 255};
             font_draw_str(ren, "ANIM", ind_x, ty_ind, ANIMCOL);
         }
+        if (s->dup_view) {
+            int ntiles = s->chr_cols * s->chr_rows;
+            if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+            int16_t rep[CHR_MAX_TILES];
+            int dups = tilehash_clusters(&s->tilehash, ntiles,
+                                         s->dup_view == 2, rep, NULL);
+            char dbuf[24];
+            snprintf(dbuf, sizeof(dbuf), "%s %d",
+                     s->dup_view == 2 ? "DUP+FLIP" : "DUP", dups);
+            ind_x -= (int)strlen(dbuf) * cw + 4;
+            static const SDL_Color DUPCOL = {255, 140, 40, 255};
+            font_draw_str(ren, dbuf, ind_x, ty_ind, DUPCOL);
+        }
+
+        char sbuf[64];
+        size_label(s, sbuf, sizeof(sbuf));
+        if (sbuf[0]) {
+            ind_x -= (int)strlen(sbuf) * cw + 8;
+            static const SDL_Color SIZECOL = {150, 150, 175, 255};
+            font_draw_str(ren, sbuf, ind_x, ty_ind, SIZECOL);
+        }
+
+        char mbuf[32];
+        bool hot;
+        mem_label(s, mbuf, sizeof(mbuf), &hot);
+        ind_x -= (int)strlen(mbuf) * cw + 8;
+        static const SDL_Color MEMCOL = {110, 130, 110, 255};
+        static const SDL_Color HOTCOL = {230,  90,  70, 255};
+        font_draw_str(ren, mbuf, ind_x, ty_ind, hot ? HOTCOL : MEMCOL);
+
+        char cbuf[32];
+        clip_label(cbuf, sizeof(cbuf));
+        if (cbuf[0]) {
+            ind_x -= (int)strlen(cbuf) * cw + 8;
+            static const SDL_Color CLIPCOL = {150, 170, 210, 255};
+            font_draw_str(ren, cbuf, ind_x, ty_ind, CLIPCOL);
+        }
     }
 }
 
@@ -584,11 +771,6 @@ static void render_anim_section(SDL_Renderer *ren, const EditorState *s,
 }
 
 /* Index of the top-left tile of the currently selected tile/sprite (render-side). */
-static int sel_tile_idx_r(const EditorState *s) {
-    if (s->sprite_mode == SPRITE_16 && s->chr_cols >= 2)
-        return ((s->sel_tile_y / 2) * (s->chr_cols / 2) + (s->sel_tile_x / 2)) * 4;
-    return s->sel_tile_y * s->chr_cols + s->sel_tile_x;
-}
 
 /* ── Tile edit panel (enlarged tile view for drawing) ─────────── */
 
@@ -765,7 +947,7 @@ static void render_panel(SDL_Renderer *ren, const EditorState *s) {
 
         for (int j = 0; j < 4; j++) {
             int sx = BX + PANEL_PAL_X0 + j * (PANEL_PAL_SW + PANEL_PAL_XGAP);
-            SDL_Color c = NES_MASTER_PALETTE[s->pal.sub[pal_idx].idx[j] & 0x3F];
+            SDL_Color c = nes_rgb(s->pal.sub[pal_idx].idx[j]);
             fill(ren, sx, ry, PANEL_PAL_SW, PANEL_PAL_SH, c.r, c.g, c.b);
         }
 
@@ -798,7 +980,7 @@ static void render_panel(SDL_Renderer *ren, const EditorState *s) {
                  60, 60, 70);
 
         uint8_t idx_j = s->pal.sub[s->active_sub_pal].idx[j] & 0x3F;
-        SDL_Color c = NES_MASTER_PALETTE[idx_j];
+        SDL_Color c = nes_rgb(idx_j);
         fill(ren, sx, PANEL_ACT_Y0, PANEL_ACT_SW, PANEL_ACT_SH,
              c.r, c.g, c.b);
 
@@ -821,7 +1003,7 @@ static void render_panel(SDL_Renderer *ren, const EditorState *s) {
             int  idx = row * PANEL_NES_COLS + col;
             int  sx  = BX + nes_x0 + col * nes_step;
             int  sy  =      PANEL_NES_Y0 + row * nes_step;
-            SDL_Color c = NES_MASTER_PALETTE[idx];
+            SDL_Color c = nes_rgb(idx);
 
             if ((uint8_t)idx == cur)
                 fill(ren, sx-1, sy-1, nes_cell+2, nes_cell+2, 255, 255, 255);
@@ -889,6 +1071,7 @@ static void render_help_overlay(SDL_Renderer *ren, const EditorState *s) {
 
     font_draw_str(ren, "TILE MODE",                       x, y, CYN); y += lh;
     font_draw_str(ren, " T      SELECT TILE",             x, y, WHT); y += lh;
+    font_draw_str(ren, " SHFT+T EXTEND SELECTION",        x, y, WHT); y += lh;
     font_draw_str(ren, " W      CYCLE WRAP MODE",         x, y, WHT); y += lh;
     font_draw_str(ren, " E      TILE EDIT (PANEL)",       x, y, WHT); y += lh;
     font_draw_str(ren, " [/]    CYCLE TILE PALETTE",      x, y, WHT); y += lh;
@@ -899,7 +1082,17 @@ static void render_help_overlay(SDL_Renderer *ren, const EditorState *s) {
     font_draw_str(ren, " G      TILE GRID",               x, y, WHT); y += lh;
     font_draw_str(ren, " P      PIXEL GRID",              x, y, WHT); y += lh;
     font_draw_str(ren, " M      SPRITE 16 MODE",          x, y, WHT); y += lh;
-    font_draw_str(ren, " N      SHOW TILE ADDRESS",       x, y, WHT); y += lh + hg;
+    font_draw_str(ren, " N      SHOW TILE ADDRESS",       x, y, WHT); y += lh;
+    font_draw_str(ren, " U      WHERE USED (ALL SCENES)", x, y, WHT); y += lh;
+    font_draw_str(ren, " D      DUPLICATES: OFF/SAME/FLIP",x, y, WHT); y += lh;
+    font_draw_str(ren, " SHFT+D NEAREST TILES (PX DIFF)", x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+D NEAR-DUP REPORT .NEAR.TXT",x, y, WHT); y += lh;
+    font_draw_str(ren, " C      SCENE PREVIEW DOCK",      x, y, WHT); y += lh + hg;
+
+    font_draw_str(ren, "SCROLL PREVIEW (DOCK OPEN)",      x, y, CYN); y += lh;
+    font_draw_str(ren, " K      PLAY/STOP CAMERA SCROLL", x, y, WHT); y += lh;
+    font_draw_str(ren, " SHFT+K SIDE BY SIDE / STACKED",  x, y, WHT); y += lh;
+    font_draw_str(ren, " J / L  SLOWER/FASTER (PX/FRAME)",x, y, WHT); y += lh + hg;
 
     font_draw_str(ren, "ANIMATION",                       x, y, CYN); y += lh;
     font_draw_str(ren, " A      START/STOP ANIM MODE",    x, y, WHT); y += lh;
@@ -911,7 +1104,7 @@ static void render_help_overlay(SDL_Renderer *ren, const EditorState *s) {
     font_draw_str(ren, "EDIT",                             x, y, CYN); y += lh;
     font_draw_str(ren, " CTRL+Z  UNDO",                   x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+Z REDO (OR CTRL+Y)",   x, y, WHT); y += lh;
-    font_draw_str(ren, " CTRL+C/V/X  COPY/PASTE/CUT TILE",x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+C/V/X  COPY/PASTE/CUT SEL", x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+C COPY PAL AS .DB",    x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+V PASTE PAL FROM .DB", x, y, WHT); y += lh;
     font_draw_str(ren, " WHEEL ON PANEL SCROLLS PALETTES",x, y, WHT); y += lh + hg;
@@ -920,7 +1113,12 @@ static void render_help_overlay(SDL_Renderer *ren, const EditorState *s) {
     font_draw_str(ren, " CTRL+S      SAVE",               x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+S SAVE AS",            x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+O      OPEN",               x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+I      IMPORT IMAGE",       x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+SHFT+I IMPORT, BEST PALETTES",x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+R      RESIZE CANVAS",      x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+SHFT+R COMPACT USED TILES", x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+H      FIND/REPLACE TILE",  x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+SHFT+H ... + FLIPPED TILES",x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+P SAVE PALETTE",       x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+P      LOAD PALETTE",       x, y, WHT); y += lh;
     font_draw_str(ren, " DROP FILE   OPEN",               x, y, WHT); y += lh;
@@ -972,6 +1170,9 @@ static void render_input_overlay(SDL_Renderer *ren, const EditorState *s) {
     if      (s->input_type == INPUT_SAVE_AS)  title = "SAVE AS:";
     else if (s->input_type == INPUT_OPEN)     title = "OPEN FILE:";
     else if (s->input_type == INPUT_OPEN_PAL) title = "OPEN PALETTE:";
+    else if (s->input_type == INPUT_IMPORT)   title = "IMPORT IMAGE:";
+    else if (s->input_type == INPUT_REPLACE)
+        title = s->replace_flips ? "REPLACE TILE +FLIPS (FROM TO):" : "REPLACE TILE (FROM TO):";
     else                                      title = "RESIZE (COLSxROWS):";
     font_draw_str(ren, title, tx, ty, YLW);
     ty += lh;
@@ -983,7 +1184,7 @@ static void render_input_overlay(SDL_Renderer *ren, const EditorState *s) {
     int  start = (s->input_len > max_chars - 1) ? (s->input_len - max_chars + 1) : 0;
     int  dlen  = s->input_len - start;
     memcpy(display, s->input_buf + start, (size_t)dlen);
-    bool cursor_on = (SDL_GetTicks() % 1000) < 500;
+    bool cursor_on = (s->ticks % 1000) < 500;
     display[dlen]     = cursor_on ? '_' : ' ';
     display[dlen + 1] = '\0';
     font_draw_str(ren, display, tx, ty, WHT);
@@ -996,101 +1197,34 @@ static void render_input_overlay(SDL_Renderer *ren, const EditorState *s) {
 
 static SDL_Color compose_get_bg_color(const EditorState *s, int pal_idx, int val) {
     uint8_t master = s->pal.sub[pal_idx & 3].idx[val & 3] & 0x3F;
-    return NES_MASTER_PALETTE[master];
-}
-
-static SDL_Color compose_get_spr_color(const EditorState *s, int pal_idx, int val) {
-    uint8_t master = s->pal.sub[pal_idx & 7].idx[val & 3] & 0x3F;
-    return NES_MASTER_PALETTE[master];
+    return nes_rgb(master);
 }
 
 static void render_compose_canvas(const EditorState *s) {
     if (!compose_tex) return;
 
-    void *pixels; int pitch;
-    if (SDL_LockTexture(compose_tex, NULL, &pixels, &pitch) != 0) return;
-
-    uint32_t *dst    = (uint32_t *)pixels;
-    int       stride = pitch / 4;
-
-    const ComposeScene *sc = &s->compose.scenes[s->compose.active_scene];
-
-    /* Universal background color: palette 0, color 0 */
-    SDL_Color bg = compose_get_bg_color(s, 0, 0);
-    uint32_t bg_px = (0xFFu << 24) | ((uint32_t)bg.r << 16) |
-                     ((uint32_t)bg.g << 8) | bg.b;
-    for (int y = 0; y < 240; y++)
-        for (int x = 0; x < 256; x++)
-            dst[y * stride + x] = bg_px;
-
-    /* Draw nametable (BG tiles) */
-    for (int ty = 0; ty < COMPOSE_NT_H; ty++) {
-        for (int tx = 0; tx < COMPOSE_NT_W; tx++) {
-            uint16_t tile_idx = sc->nametable[ty][tx];
-            if (tile_idx >= CHR_MAX_TILES) continue;
-            int pal_idx = sc->attr[ty / 2][tx / 2] & 3;
-
-            for (int row = 0; row < TILE_H; row++) {
-                for (int col = 0; col < TILE_W; col++) {
-                    int px_x = tx * TILE_W + col;
-                    int px_y = ty * TILE_H + row;
-                    if (px_x >= 256 || px_y >= 240) continue;
-                    uint8_t val = s->chr.px[tile_idx][row][col] & 3;
-                    if (tile_idx == 0 && val == 0) continue; /* transparent BG */
-                    SDL_Color c = compose_get_bg_color(s, pal_idx, val);
-                    dst[px_y * stride + px_x] =
-                        (0xFFu << 24) | ((uint32_t)c.r << 16) |
-                        ((uint32_t)c.g << 8) | c.b;
-                }
-            }
-        }
+    int active = s->compose.active_scene;
+    if (cmp_tex_valid && cmp_tex_scene == active && cmp_tex_rev == s->edit_rev) {
+        if (cmp_tex_chr_rev == s->chr_rev) return;
+        bool hit = false;
+        for (int t = 0; t < CHR_MAX_TILES && !hit; t++)
+            hit = s->tile_rev[t] > cmp_tex_chr_rev &&
+                  usage_scene_refs(&s->usage, active, t) > 0;
+        cmp_tex_chr_rev = s->chr_rev;
+        if (!hit) return;
     }
 
-    /* Draw sprites (front to back — later sprites draw on top) */
-    for (int i = 0; i < sc->sprite_count; i++) {
-        const ComposeSprite *sp = &sc->sprites[i];
-        bool s16 = sp->s16;
-        int spr_w = s16 ? 16 : 8;
-        int spr_h = s16 ? 16 : 8;
-
-        for (int row = 0; row < spr_h; row++) {
-            for (int col = 0; col < spr_w; col++) {
-                int src_col = sp->hflip ? (spr_w - 1 - col) : col;
-                int src_row = sp->vflip ? (spr_h - 1 - row) : row;
-
-                int tile;
-                int lr, lc;
-                if (s16) {
-                    /* Column-major layout: [0][2] / [1][3] */
-                    int sub_x = src_col / TILE_W;
-                    int sub_y = src_row / TILE_H;
-                    int p = sub_x * 2 + sub_y;
-                    tile = sp->tile + p;
-                    lr = src_row % TILE_H;
-                    lc = src_col % TILE_W;
-                } else {
-                    tile = sp->tile;
-                    lr = src_row;
-                    lc = src_col;
-                }
-
-                if (tile >= CHR_MAX_TILES) continue;
-                uint8_t val = s->chr.px[tile][lr][lc] & 3;
-                if (val == 0) continue; /* transparent */
+    void *pixels; int pitch;
+    if (SDL_LockTexture(compose_tex, NULL, &pixels, &pitch) != 0) return;
 
-                int px_x = sp->x + col;
-                int px_y = sp->y + row;
-                if (px_x >= 256 || px_y >= 240) continue;
-
-                SDL_Color c = compose_get_spr_color(s, sp->palette, val);
-                dst[px_y * stride + px_x] =
-                    (0xFFu << 24) | ((uint32_t)c.r << 16) |
-                    ((uint32_t)c.g << 8) | c.b;
-            }
-        }
-    }
+    swr_scene(&s->chr, &s->pal, compose_active(&s->compose), 0, 0, 256, 240,
+              (uint32_t *)pixels, pitch / 4);
 
     SDL_UnlockTexture(compose_tex);
+    cmp_tex_valid   = true;
+    cmp_tex_scene   = active;
+    cmp_tex_rev     = s->edit_rev;
+    cmp_tex_chr_rev = s->chr_rev;
 }
 
 /* Effective compose scale (incl. focus zoom). */
@@ -1104,7 +1238,7 @@ static void render_compose_attr_grid(SDL_Renderer *ren, const EditorState *s) {
 
     int z = cmp_fzs(s);
     SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(ren, 100, 60, 60, 80);
+    set_grid_color(ren, SWR_GRID_ATTR);
 
     /* Vertical lines every 16px (2 tiles) */
     for (int i = 1; i < 16; i++) {
@@ -1158,7 +1292,7 @@ static void render_compose_hover(SDL_Renderer *ren, const EditorState *s) {
 /* ── Compose: selected sprite highlight ──────────────────────── */
 static void render_compose_spr_highlight(SDL_Renderer *ren, const EditorState *s) {
     if (s->compose_spr_sel < 0) return;
-    const ComposeScene *sc = &s->compose.scenes[s->compose.active_scene];
+    const ComposeScene *sc = compose_active(&s->compose);
     if (s->compose_spr_sel >= sc->sprite_count) return;
 
     const ComposeSprite *sp = &sc->sprites[s->compose_spr_sel];
@@ -1172,6 +1306,54 @@ static void render_compose_spr_highlight(SDL_Renderer *ren, const EditorState *s
     SDL_RenderDrawRect(ren, &border);
 }
 
+/* ── Compose: cell selection (amber, as in paint mode) ───────── */
+static void render_compose_cell_sel(SDL_Renderer *ren, const EditorState *s) {
+    if (s->cmp_sel_w <= 0) return;
+    int z = cmp_fzs(s);
+    SDL_SetRenderDrawColor(ren, 255, 210, 40, 255);
+    SDL_Rect border = { (s->cmp_sel_x * TILE_W - s->pan_x) * z,
+                        (s->cmp_sel_y * TILE_H - s->pan_y) * z,
+                        s->cmp_sel_w * TILE_W * z, s->cmp_sel_h * TILE_H * z };
+    SDL_RenderDrawRect(ren, &border);
+}
+
+/* ── Where-used overlay ───────────────────────────────────────────
+   Outlines every cell and sprite quadrant of the active scene that
+   references tile, walking the usage list rather than the scene.
+   (ox, oy) is the screen position of scene pixel (pan_x, pan_y).  */
+static void render_usage_outlines(SDL_Renderer *ren, const EditorState *s,
+                                  int tile, int ox, int oy,
+                                  int pan_x, int pan_y, int z) {
+    const ComposeScene *sc = compose_active(&s->compose);
+    int active = s->compose.active_scene;
+    if (usage_scene_refs(&s->usage, active, tile) == 0) return;
+
+    for (int nd = usage_first(&s->usage, tile); nd != USAGE_NONE;
+         nd = usage_next(&s->usage, nd)) {
+        UsageRef r;
+        usage_decode(nd, &r);
+        if (r.scene != active) continue;
+        int px, py;
+        if (r.sprite) {
+            if (r.spr >= sc->sprite_count) continue;
+            const ComposeSprite *sp = &sc->sprites[r.spr];
+            int qx = r.part / 2, qy = r.part % 2;   /* column-major */
+            if (sp->hflip && sp->s16) qx = 1 - qx;
+            if (sp->vflip && sp->s16) qy = 1 - qy;
+            px = sp->x + qx * TILE_W;
+            py = sp->y + qy * TILE_H;
+            SDL_SetRenderDrawColor(ren, 255, 90, 200, 255);
+        } else {
+            px = r.x * TILE_W;
+            py = r.y * TILE_H;
+            SDL_SetRenderDrawColor(ren, 255, 230, 40, 255);
+        }
+        SDL_Rect box = { ox + (px - pan_x) * z, oy + (py - pan_y) * z,
+                         TILE_W * z, TILE_H * z };
+        SDL_RenderDrawRect(ren, &box);
+    }
+}
+
 /* ── Compose panel ───────────────────────────────────────────── */
 static void render_compose_panel(SDL_Renderer *ren, const EditorState *s) {
     const int BX = s->compose_canvas_w;
@@ -1283,7 +1465,7 @@ static void render_compose_panel(SDL_Renderer *ren, const EditorState *s) {
 
         for (int j = 0; j < 4; j++) {
             int sx = ctrl_x + j * 12;
-            SDL_Color c = NES_MASTER_PALETTE[s->pal.sub[pal_idx].idx[j] & 0x3F];
+            SDL_Color c = nes_rgb(s->pal.sub[pal_idx].idx[j]);
             fill(ren, sx, ry, 10, 10, c.r, c.g, c.b);
         }
 
@@ -1318,7 +1500,7 @@ static void render_compose_panel(SDL_Renderer *ren, const EditorState *s) {
 
     /* Sprite counter */
     {
-        const ComposeScene *sc = &s->compose.scenes[s->compose.active_scene];
+        const ComposeScene *sc = compose_active(&s->compose);
         char sbuf[24];
         snprintf(sbuf, sizeof(sbuf), "SPR %d/%d", sc->sprite_count, COMPOSE_MAX_SPR);
         SDL_Color sc_col = (sc->sprite_count >= COMPOSE_MAX_SPR)
@@ -1338,6 +1520,26 @@ static void render_compose_panel(SDL_Renderer *ren, const EditorState *s) {
     vline(ren, BX, 0, s->win_h - STATUS_H, 55, 55, 80);
 }
 
+/* ── Compressed nametable size (compose status) ───────────────────
+   Recompressed only when the active scene's PPU nametable image
+   actually changes, so idle frames cost one export + memcmp.      */
+static const int *packed_sizes(const EditorState *s) {
+    static uint8_t last[NES_NAMETABLE_BYTES];
+    static int     sizes[CODEC_COUNT];
+    static bool    valid = false;
+
+    uint8_t nt[NES_NAMETABLE_BYTES];
+    export_nametable(compose_active(&s->compose), nt);
+    if (valid && memcmp(nt, last, sizeof(nt)) == 0) return sizes;
+
+    uint8_t out[CODEC_BOUND(NES_NAMETABLE_BYTES)];
+    for (int c = 0; c < CODEC_COUNT; c++)
+        sizes[c] = (int)codec_compress((Codec)c, nt, sizeof(nt), out);
+    memcpy(last, nt, sizeof(nt));
+    valid = true;
+    return sizes;
+}
+
 /* ── Compose status bar ──────────────────────────────────────── */
 static void render_compose_status(SDL_Renderer *ren, const EditorState *s) {
     const int STATUS_Y = s->win_h - STATUS_H;
@@ -1373,6 +1575,14 @@ static void render_compose_status(SDL_Renderer *ren, const EditorState *s) {
         font_draw_str(ren, cbuf, lx + 8 * cw, ty, POS);
     }
 
+    /* Where-used summary for the brush tile */
+    if (s->show_usage) {
+        char ubuf[48];
+        usage_label(s, s->brush_tile, ubuf, sizeof(ubuf));
+        static const SDL_Color USEC = {255, 230, 40, 255};
+        font_draw_str(ren, ubuf, lx + 16 * cw, ty, USEC);
+    }
+
     /* Zoom — right-aligned (append focus zoom when >1) */
     char zbuf[16];
     if (s->focus_zoom > 1)
@@ -1382,6 +1592,40 @@ static void render_compose_status(SDL_Renderer *ren, const EditorState *s) {
     int zx = s->win_w - (int)strlen(zbuf) * cw - 4;
     static const SDL_Color ZCOL = {140, 160, 200, 255};
     font_draw_str(ren, zbuf, zx, ty, ZCOL);
+
+    /* Compressed nametable size per codec, left of the zoom label. */
+    {
+        const int *sz = packed_sizes(s);
+        char pbuf[48];
+        int  n = 0;
+        for (int c = 0; c < CODEC_COUNT; c++) {
+            if (sz[c] >= 0)
+                n += snprintf(pbuf + n, sizeof(pbuf) - n, "%s%s %d",
+                              c ? " " : "", codec_name((Codec)c), sz[c]);
+            else
+                n += snprintf(pbuf + n, sizeof(pbuf) - n, "%s%s -",
+                              c ? " " : "", codec_name((Codec)c));
+        }
+        int px = zx - ((int)strlen(pbuf) + 2) * cw;
+        static const SDL_Color PKC = {200, 170, 110, 255};
+        font_draw_str(ren, pbuf, px, ty, PKC);
+
+        char mbuf[32];
+        bool hot;
+        mem_label(s, mbuf, sizeof(mbuf), &hot);
+        px -= ((int)strlen(mbuf) + 2) * cw;
+        static const SDL_Color MEMCOL = {110, 130, 110, 255};
+        static const SDL_Color HOTCOL = {230,  90,  70, 255};
+        font_draw_str(ren, mbuf, px, ty, hot ? HOTCOL : MEMCOL);
+
+        char cbuf[32];
+        clip_label(cbuf, sizeof(cbuf));
+        if (cbuf[0]) {
+            px -= ((int)strlen(cbuf) + 2) * cw;
+            static const SDL_Color CLIPCOL = {150, 170, 210, 255};
+            font_draw_str(ren, cbuf, px, ty, CLIPCOL);
+        }
+    }
 }
 
 /* ── Compose help overlay ─────────────────────────────────────── */
@@ -1438,6 +1682,8 @@ static void render_compose_help(SDL_Renderer *ren, const EditorState *s) {
     font_draw_str(ren, "EDIT",                             x, y, CYN); y += lh;
     font_draw_str(ren, " CTRL+Z  UNDO",                   x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+Z REDO",               x, y, WHT); y += lh;
+    font_draw_str(ren, " T/SHFT+T SELECT CELLS",          x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+C/V/X  COPY/PASTE/CUT CELLS",x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+C COPY PAL AS .DB",    x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+SHFT+V PASTE PAL FROM .DB", x, y, WHT); y += lh;
     font_draw_str(ren, " WHEEL ON PANEL SCROLLS PALETTES",x, y, WHT); y += lh;
@@ -1445,10 +1691,17 @@ static void render_compose_help(SDL_Renderer *ren, const EditorState *s) {
 
     font_draw_str(ren, "VIEW & SCENES",                   x, y, CYN); y += lh;
     font_draw_str(ren, " G       TOGGLE ATTR GRID",       x, y, WHT); y += lh;
+    font_draw_str(ren, " U       WHERE BRUSH TILE USED",  x, y, WHT); y += lh;
     font_draw_str(ren, " =/-     ZOOM IN/OUT",            x, y, WHT); y += lh;
     font_draw_str(ren, " PGUP/DN SWITCH SCENE",           x, y, WHT); y += lh;
     font_draw_str(ren, " CTRL+N  ADD NEW SCENE",          x, y, WHT); y += lh;
-    font_draw_str(ren, " CTRL+S  SAVE SCENE FILE",        x, y, WHT); y += lh + hg;
+    font_draw_str(ren, " CTRL+S  SAVE SCENE FILE",        x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+I  IMPORT IMAGE TO SCENE",  x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+SHFT+I SLOWER, BEST PALETTES",x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+H  FIND/REPLACE TILE",      x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+SHFT+H ... + FLIPPED TILES",x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+E  EXPORT .NAM + .OAM",     x, y, WHT); y += lh;
+    font_draw_str(ren, " CTRL+SHFT+E EXPORT RLE/LZ NAMS", x, y, WHT); y += lh + hg;
 
     font_draw_str(ren, "FOCUS ZOOM (CANVAS-ONLY)",        x, y, CYN); y += lh;
     font_draw_str(ren, " WHEEL ON CANVAS  FOCUS ZOOM",    x, y, WHT); y += lh;
@@ -1633,6 +1886,104 @@ static void render_compose_scrollbars(SDL_Renderer *ren, const EditorState *s) {
 }
 
 /* ── Compose preview dock (paint mode) ────────────────────────── */
+
+/* Bring every ring slot under the camera up to date.  A strip is
+   one 8-px column (or row) of the scene strip; scenes that aren't
+   resident are decoded through compose_peek once per strip; one
+   that can't be read shows as a black strip.                      */
+static void scroll_ring_update(const EditorState *s) {
+    int  n    = s->compose.scene_count;
+    bool vert = s->scroll_vertical;
+    if (!ring_valid || ring_rev != s->edit_rev ||
+        ring_count != n || ring_vertical != vert) {
+        for (int i = 0; i < RING_SLOTS; i++) ring_tag[i] = -1;
+        ring_valid    = true;
+        ring_rev      = s->edit_rev;
+        ring_chr_rev  = s->chr_rev;
+        ring_count    = n;
+        ring_vertical = vert;
+    }
+
+    int per   = (vert ? 240 : 256) / 8;          /* strips per scene   */
+    int total = n * per;
+
+    /* Repainted tiles: drop only the strips that show them.  BG cells
+       map to one strip; a sprite's scene is redrawn whole.          */
+    if (ring_chr_rev != s->chr_rev) {
+        memset(ring_dirty, 0, (size_t)total);
+        for (int t = 0; t < CHR_MAX_TILES; t++) {
+            if (s->tile_rev[t] <= ring_chr_rev) continue;
+            for (int nd = usage_first(&s->usage, t); nd != USAGE_NONE;
+                 nd = usage_next(&s->usage, nd)) {
+                UsageRef r;
+                usage_decode(nd, &r);
+                if (r.scene >= n) continue;
+                if (r.sprite)
+                    memset(ring_dirty + r.scene * per, 1, (size_t)per);
+                else
+                    ring_dirty[r.scene * per + (vert ? r.y : r.x)] = 1;
+            }
+        }
+        for (int i = 0; i < RING_SLOTS; i++)
+            if (ring_tag[i] >= 0 && ring_dirty[ring_tag[i] % total])
+                ring_tag[i] = -1;
+        ring_chr_rev = s->chr_rev;
+    }
+    int slots = vert ? RING_H / 8 : RING_W / 8;
+    int first = s->scroll_pos / 8;
+    int span  = per + 1;                         /* partially visible  */
+
+    for (int k = 0; k < span; k++) {
+        int u    = first + k;
+        int slot = u % slots;
+        if (ring_tag[slot] == u) continue;
+
+        int w   = u % total;
+        int sci = w / per;
+        int off = (w % per) * 8;
+        SDL_Rect r = vert ? (SDL_Rect){ 0, slot * 8, 256, 8 }
+                          : (SDL_Rect){ slot * 8, 0, 8, 240 };
+        void *pixels; int pitch;
+        if (SDL_LockTexture(ring_tex, &r, &pixels, &pitch) != 0) return;
+        ComposeScene tmp;
+        const ComposeScene *sc = compose_peek(&s->compose, sci, &tmp);
+        if (!sc) {
+            /* Unreadable chunk (corrupt, or the file is being rewritten
+               and not yet reloaded): a black strip until the next edit. */
+            for (int y = 0; y < r.h; y++)
+                for (int x = 0; x < r.w; x++)
+                    ((uint32_t *)((uint8_t *)pixels + y * pitch))[x] = 0xFF000000u;
+        } else if (vert) {
+            swr_scene(&s->chr, &s->pal, sc, 0, off, 256, 8, (uint32_t *)pixels, pitch / 4);
+        } else {
+            swr_scene(&s->chr, &s->pal, sc, off, 0, 8, 240, (uint32_t *)pixels, pitch / 4);
+        }
+        SDL_UnlockTexture(ring_tex);
+        ring_tag[slot] = u;
+    }
+}
+
+/* Copy the ring rectangle (rx, ry, w, h) to (dx, dy) at zoom z,
+   splitting it where it wraps past the ring's right/bottom edge. */
+static void ring_blit(SDL_Renderer *ren, int rx, int ry, int w, int h,
+                      int dx, int dy, int z) {
+    rx %= RING_W; ry %= RING_H;
+    int w0 = (rx + w > RING_W) ? RING_W - rx : w;
+    int h0 = (ry + h > RING_H) ? RING_H - ry : h;
+    for (int py = 0; py < 2; py++) {
+        int sy = py ? 0 : ry, sh = py ? h - h0 : h0;
+        if (sh <= 0) continue;
+        for (int px = 0; px < 2; px++) {
+            int sx = px ? 0 : rx, sw = px ? w - w0 : w0;
+            if (sw <= 0) continue;
+            SDL_Rect src = { sx, sy, sw, sh };
+            SDL_Rect dst = { dx + (px ? w0 : 0) * z, dy + (py ? h0 : 0) * z,
+                             sw * z, sh * z };
+            SDL_RenderCopy(ren, ring_tex, &src, &dst);
+        }
+    }
+}
+
 static void render_preview(SDL_Renderer *ren, const EditorState *s) {
     if (!s->show_preview || !compose_tex) return;
 
@@ -1646,9 +1997,6 @@ static void render_preview(SDL_Renderer *ren, const EditorState *s) {
     fill(ren, x0, y0, pw, ph, 18, 18, 30);
     vline(ren, x0, y0, ph, 55, 55, 80);
 
-    /* Keep compose_tex fresh — CHR pixels may have changed this frame. */
-    render_compose_canvas(s);
-
     /* Source sub-rect (NES-px). Clamp to 256×240. */
     int sw = pw / z; if (sw > 256 - s->preview_pan_x) sw = 256 - s->preview_pan_x;
     int sh = ph / z; if (sh > 240 - s->preview_pan_y) sh = 240 - s->preview_pan_y;
@@ -1657,9 +2005,35 @@ static void render_preview(SDL_Renderer *ren, const EditorState *s) {
     SDL_Rect clip = { x0, y0, pw, ph };
     SDL_RenderSetClipRect(ren, &clip);
 
-    SDL_Rect src = { s->preview_pan_x, s->preview_pan_y, sw, sh };
-    SDL_Rect dst = { x0, y0, sw * z, sh * z };
-    SDL_RenderCopy(ren, compose_tex, &src, &dst);
+    if (s->scroll_play && ring_tex) {
+        /* Camera view out of the ring; pan/zoom apply within it. */
+        scroll_ring_update(s);
+        int cam = s->scroll_pos;
+        int rx  = s->preview_pan_x + (s->scroll_vertical ? 0 : cam % RING_W);
+        int ry  = s->preview_pan_y + (s->scroll_vertical ? cam % RING_H : 0);
+        ring_blit(ren, rx, ry, sw, sh, x0, y0, z);
+
+        int per = s->scroll_vertical ? 240 : 256;
+        char buf[40];
+        snprintf(buf, sizeof(buf), "SCROLL %c %dPX SCN %d",
+                 s->scroll_vertical ? 'V' : 'H', s->scroll_speed,
+                 cam / per);
+        font_draw_str(ren, buf, x0 + 4, y0 + 4, (SDL_Color){ 150, 150, 190, 255 });
+    } else {
+        /* Keep compose_tex fresh — CHR pixels may have changed this frame. */
+        render_compose_canvas(s);
+
+        SDL_Rect src = { s->preview_pan_x, s->preview_pan_y, sw, sh };
+        SDL_Rect dst = { x0, y0, sw * z, sh * z };
+        SDL_RenderCopy(ren, compose_tex, &src, &dst);
+
+        if (s->show_usage) {
+            int tile = usage_tile_r(s);
+            if (tile >= 0)
+                render_usage_outlines(ren, s, tile, x0, y0,
+                                      s->preview_pan_x, s->preview_pan_y, z);
+        }
+    }
 
     SDL_RenderSetClipRect(ren, NULL);
 }
@@ -1670,7 +2044,10 @@ void render_frame(SDL_Renderer *ren, const EditorState *s) {
     SDL_RenderClear(ren);
 
     if (s->compose_mode) {
+        TraceZone z = trace_begin("render compose canvas");
         render_compose_canvas(s);
+        trace_end(z);
+        z = trace_begin("render compose overlays");
 
         /* Clip so focus-zoomed content doesn't bleed into the side panel.
            Scrollbars draw on top after clip reset. */
@@ -1688,18 +2065,30 @@ void render_frame(SDL_Renderer *ren, const EditorState *s) {
 
         render_compose_attr_grid(ren, s);
         render_compose_hover(ren, s);
+        render_compose_cell_sel(ren, s);
         render_compose_spr_highlight(ren, s);
+        if (s->show_usage)
+            render_usage_outlines(ren, s, s->brush_tile, 0, 0,
+                                  s->pan_x, s->pan_y, czs);
 
         SDL_RenderSetClipRect(ren, NULL);
         render_compose_scrollbars(ren, s);
+        trace_end(z);
+        z = trace_begin("render compose panel");
         render_compose_panel(ren, s);
         render_compose_status(ren, s);
         render_compose_help(ren, s);
+        trace_end(z);
+        z = trace_begin("present");
         SDL_RenderPresent(ren);
+        trace_end(z);
         return;
     }
 
+    TraceZone z = trace_begin("render canvas");
     render_canvas(s);
+    trace_end(z);
+    z = trace_begin("render overlays");
 
     /* Clip canvas-space drawing so focus-zoomed content doesn't bleed
        into the palette panel. Scrollbars draw on top after clip reset. */
@@ -1722,19 +2111,26 @@ void render_frame(SDL_Renderer *ren, const EditorState *s) {
     if (s->show_pixel_grid) render_pixel_grid(ren, s);
     if (s->show_tile_grid)  render_tile_grid(ren, s);
 
+    render_dup_overlay(ren, s);
+    render_nearest_overlay(ren, s);
     render_tile_highlight(ren, s);
     render_anim_frame_highlight(ren, s);
     render_anim_ghosts(ren, s);
 
     SDL_RenderSetClipRect(ren, NULL);
     render_scrollbars(ren, s);
+    trace_end(z);
+    z = trace_begin("render panel");
     if (s->tile_edit)
         render_tile_edit_panel(ren, s);
     else
         render_panel(ren, s);
     render_status(ren, s);
+    trace_end(z);
 
+    z = trace_begin("render preview");
     render_preview(ren, s);
+    trace_end(z);
 
     vline(ren, s->canvas_w, 0,                   s->win_h - STATUS_H, 55, 55, 80);
     hline(ren, 0,           s->win_h - STATUS_H, s->win_w,            55, 55, 80);
@@ -1742,5 +2138,7 @@ void render_frame(SDL_Renderer *ren, const EditorState *s) {
     render_help_overlay(ren, s);
     render_input_overlay(ren, s);
 
+    z = trace_begin("present");
     SDL_RenderPresent(ren);
+    trace_end(z);
 }
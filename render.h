@@ -8,6 +8,9 @@ void render_init(SDL_Renderer *ren, const EditorState *s);
 /* Recreate the canvas texture after a dimension change. */
 void render_resize(SDL_Renderer *ren, const EditorState *s);
 
+/* Pixel bytes of the streaming textures. */
+size_t render_mem(void);
+
 /* Call before SDL_DestroyRenderer. */
 void render_destroy(void);
 
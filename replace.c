@@ -0,0 +1,160 @@
+#include "replace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int sprite_flip(const ComposeSprite *sp) {
+    return (sp->hflip ? TH_FLIP_H : 0) | (sp->vflip ? TH_FLIP_V : 0);
+}
+
+static int log_push(ReplaceLog *log, int scene, int slot,
+                    int t0, int t1, int f0, int f1) {
+    if (log->count == log->cap) {
+        int cap = log->cap ? log->cap * 2 : 256;
+        ReplaceEdit *e = realloc(log->edit, (size_t)cap * sizeof(*e));
+        if (!e) return -1;
+        log->edit = e;
+        log->cap  = cap;
+    }
+    log->edit[log->count++] = (ReplaceEdit){
+        (uint16_t)scene, (uint16_t)slot,
+        { (uint16_t)t0, (uint16_t)t1 }, { (uint8_t)f0, (uint8_t)f1 }
+    };
+    return 0;
+}
+
+/* match[t]: TH_FLIP_* mask taking find to t, or -1 if t isn't replaced. */
+static int scene_replace(ComposeScene *sc, int i, const int8_t match[],
+                         int with, ReplaceLog *log) {
+    int n = 0;
+    for (int y = 0; y < COMPOSE_NT_H; y++)
+        for (int x = 0; x < COMPOSE_NT_W; x++) {
+            int t = sc->nametable[y][x];
+            if (t >= CHR_MAX_TILES || match[t] < 0) continue;
+            if (match[t] != 0) { log->skipped++; continue; }
+            if (log_push(log, i, y * COMPOSE_NT_W + x, t, with, 0, 0) != 0) return -1;
+            sc->nametable[y][x] = (uint16_t)with;
+            log->cells++;
+            n++;
+        }
+
+    for (int k = 0; k < sc->sprite_count; k++) {
+        ComposeSprite *sp = &sc->sprites[k];
+        if (sp->s16) {
+            for (int p = 0; p < 4; p++)
+                if (sp->tile + p < CHR_MAX_TILES && match[sp->tile + p] >= 0)
+                    log->skipped++;
+            continue;
+        }
+        if (sp->tile >= CHR_MAX_TILES || match[sp->tile] < 0) continue;
+        /* The sprite shows flip f of find ^ match; give with the same. */
+        int f0 = sprite_flip(sp), f1 = f0 ^ match[sp->tile];
+        if (log_push(log, i, USAGE_CELLS + k, sp->tile, with, f0, f1) != 0) return -1;
+        sp->tile  = (uint16_t)with;
+        sp->hflip = (f1 & TH_FLIP_H) != 0;
+        sp->vflip = (f1 & TH_FLIP_V) != 0;
+        log->sprites++;
+        n++;
+    }
+    return n;
+}
+
+int replace_tiles(ComposeData *d, const UsageIndex *u, const TileHash *th,
+                  int find, int with, bool flips, ReplaceLog *log) {
+    memset(log, 0, sizeof(*log));
+    if (find < 0 || find >= CHR_MAX_TILES || with < 0 || with >= CHR_MAX_TILES)
+        return -1;
+
+    int8_t   match[CHR_MAX_TILES];
+    uint16_t list[CHR_MAX_TILES];
+    int      nlist = 0;
+    for (int t = 0; t < CHR_MAX_TILES; t++) {
+        match[t] = -1;
+        if (t == with || u->count[t] == 0) continue;
+        if (t == find)
+            match[t] = 0;
+        else if (flips && tilehash_equal(th, t, find, true))
+            match[t] = (int8_t)tilehash_flip_between(th, find, t);
+        if (match[t] >= 0) list[nlist++] = (uint16_t)t;
+    }
+    if (nlist == 0) return 0;
+
+    ComposeScene *tmp = malloc(sizeof(*tmp));
+    if (!tmp) return -1;
+    for (int i = 0; i < d->scene_count; i++) {
+        bool hit = false;
+        for (int k = 0; k < nlist && !hit; k++)
+            hit = usage_scene_refs(u, i, list[k]) > 0;
+        if (!hit) continue;
+
+        const ComposeScene *sc = compose_peek(d, i, tmp);
+        if (!sc) continue;   /* unreadable chunk: usage_rebuild skips it too */
+        if (sc != tmp) *tmp = *sc;
+        int n = scene_replace(tmp, i, match, with, log);
+        if (n < 0) {
+            free(tmp);
+            replace_apply(d, log, false);
+            replace_log_free(log);
+            return -1;
+        }
+        if (n > 0) {
+            *compose_scene(d, i) = *tmp;
+            log->scenes++;
+        }
+    }
+    free(tmp);
+    return log->cells + log->sprites;
+}
+
+void replace_apply(ComposeData *d, const ReplaceLog *log, bool redo) {
+    ComposeScene *sc = NULL;
+    int cur = -1;
+    for (int k = 0; k < log->count; k++) {
+        const ReplaceEdit *e = &log->edit[k];
+        if (e->scene != cur) {
+            cur = e->scene;
+            sc  = compose_scene(d, cur);
+        }
+        if (e->slot < USAGE_CELLS) {
+            sc->nametable[e->slot / COMPOSE_NT_W][e->slot % COMPOSE_NT_W] = e->tile[redo];
+        } else {
+            ComposeSprite *sp = &sc->sprites[e->slot - USAGE_CELLS];
+            sp->tile  = e->tile[redo];
+            sp->hflip = (e->flip[redo] & TH_FLIP_H) != 0;
+            sp->vflip = (e->flip[redo] & TH_FLIP_V) != 0;
+        }
+    }
+}
+
+void replace_log_free(ReplaceLog *log) {
+    free(log->edit);
+    memset(log, 0, sizeof(*log));
+}
+
+int replace_dedupe(ComposeData *d, UsageIndex *u, const TileHash *th, int ntiles,
+                   bool flips, int *refs, int *skipped) {
+    int16_t rep[CHR_MAX_TILES], size[CHR_MAX_TILES];
+    ComposeScene tmp;
+    int dups = tilehash_clusters(th, ntiles, flips, rep, size);
+    *refs = *skipped = 0;
+    for (int t = 0; t < ntiles && t < CHR_MAX_TILES; t++) {
+        /* With flips, one call per group from its representative
+           catches every orientation; exact matches go one by one. */
+        int find, with;
+        if (flips) { if (rep[t] != t || size[t] < 2) continue; find = with = t; }
+        else       { if (rep[t] == t) continue; find = t; with = rep[t]; }
+
+        ReplaceLog log;
+        int r = replace_tiles(d, u, th, find, with, flips, &log);
+        if (r < 0) return -1;
+        for (int k = 0, cur = -1; k < log.count; k++)
+            if (log.edit[k].scene != cur) {
+                cur = log.edit[k].scene;
+                const ComposeScene *sc = compose_peek(d, cur, &tmp);
+                if (sc) usage_sync_scene(u, cur, sc);
+            }
+        *refs    += r;
+        *skipped += log.skipped;
+        replace_log_free(&log);
+    }
+    return dups;
+}
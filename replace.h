@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "chr.h"
+#include "compose.h"
+#include "usage.h"
+#include "tilehash.h"
+
+/* ── Tile find-and-replace ───────────────────────────────────────
+   Rewrites every reference to one tile — in nametables and sprite
+   tables of all scenes — to another.  With flips, tiles that are an
+   H/V flip of the found one match too: sprites showing them keep
+   their on-screen look by taking the replacement with the flip bits
+   adjusted, while BG cells (which can't flip) are left alone and
+   counted as skipped, as are quadrants of 16×16 sprites, whose four
+   tiles move as a group.
+
+   Every change is logged, so the whole operation can be undone and
+   redone as one step regardless of how many scenes it touched.    */
+
+typedef struct {
+    uint16_t scene;
+    uint16_t slot;       /* y * COMPOSE_NT_W + x, or USAGE_CELLS + sprite */
+    uint16_t tile[2];    /* before, after                               */
+    uint8_t  flip[2];    /* TH_FLIP_* before, after (sprites only)      */
+} ReplaceEdit;
+
+typedef struct {
+    ReplaceEdit *edit;
+    int          count, cap;
+    int          cells;      /* nametable cells rewritten         */
+    int          sprites;    /* sprites rewritten                 */
+    int          skipped;    /* flipped BG cells, 16×16 quadrants */
+    int          scenes;     /* scenes with at least one edit     */
+} ReplaceLog;
+
+/* Replace tile find with tile with across all scenes of d and log
+   the edits in *log (which starts empty).  u must be in sync with d;
+   th is only consulted when flips is set.  Returns the number of
+   references rewritten, or -1 on bad tile numbers or out of memory
+   (in which case d is left as it was).                            */
+int  replace_tiles(ComposeData *d, const UsageIndex *u, const TileHash *th,
+                   int find, int with, bool flips, ReplaceLog *log);
+
+/* Replay a log: redo = false puts the old references back, true
+   applies the new ones again.                                     */
+void replace_apply(ComposeData *d, const ReplaceLog *log, bool redo);
+
+void replace_log_free(ReplaceLog *log);
+
+/* Point every reference at the lowest-numbered copy of its tile
+   among tiles 0..ntiles-1 (with flips, of its tile up to a flip),
+   keeping u in sync.  Duplicates stay in the sheet, unreferenced,
+   until compaction.  Not logged.  Returns the number of duplicate
+   tiles, with *refs rewritten and *skipped left alone as for
+   replace_tiles, or -1 if out of memory (some groups may be done). */
+int  replace_dedupe(ComposeData *d, UsageIndex *u, const TileHash *th, int ntiles,
+                    bool flips, int *refs, int *skipped);
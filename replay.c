@@ -0,0 +1,277 @@
+#define _POSIX_C_SOURCE 200809L
+#include "replay.h"
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ── Recording ───────────────────────────────────────────────── */
+
+int rec_open(EventRecorder *r, const char *path) {
+    r->f = fopen(path, "w");
+    if (!r->f) return -1;
+    fprintf(r->f, "%s\n", REC_MAGIC);
+    return 0;
+}
+
+void rec_frame(EventRecorder *r, uint32_t ticks) {
+    if (r->f) fprintf(r->f, "f %u\n", (unsigned)ticks);
+}
+
+void rec_event(EventRecorder *r, const SDL_Event *e) {
+    if (!r->f) return;
+    unsigned mods = (unsigned)SDL_GetModState();
+    switch (e->type) {
+        case SDL_QUIT:
+            fprintf(r->f, "quit %04x\n", mods);
+            break;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            fprintf(r->f, "%s %04x %d %d %04x %d\n", e->type == SDL_KEYDOWN ? "kd" : "ku",
+                    mods, (int)e->key.keysym.scancode, (int)e->key.keysym.sym,
+                    (unsigned)e->key.keysym.mod, (int)e->key.repeat);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            fprintf(r->f, "%s %04x %d %d %d %d\n", e->type == SDL_MOUSEBUTTONDOWN ? "bd" : "bu",
+                    mods, e->button.x, e->button.y, (int)e->button.button,
+                    (int)e->button.clicks);
+            break;
+        case SDL_MOUSEMOTION:
+            fprintf(r->f, "mm %04x %d %d %d %d %u\n", mods, e->motion.x, e->motion.y,
+                    e->motion.xrel, e->motion.yrel, (unsigned)e->motion.state);
+            break;
+        case SDL_MOUSEWHEEL:
+            fprintf(r->f, "wh %04x %d %d %u\n", mods, e->wheel.x, e->wheel.y,
+                    (unsigned)e->wheel.direction);
+            break;
+        /* Text runs to the end of the line; one with a newline can't be kept. */
+        case SDL_TEXTINPUT:
+            if (!strchr(e->text.text, '\n'))
+                fprintf(r->f, "tx %04x %s\n", mods, e->text.text);
+            break;
+        case SDL_DROPFILE:
+            if (e->drop.file && !strchr(e->drop.file, '\n'))
+                fprintf(r->f, "drop %04x %s\n", mods, e->drop.file);
+            break;
+        default:
+            break;
+    }
+}
+
+void rec_close(EventRecorder *r) {
+    if (r->f) fclose(r->f);
+    r->f = NULL;
+}
+
+/* ── Replay ──────────────────────────────────────────────────── */
+
+/* Read the next non-blank line into p->next ("" at end of file). */
+static void advance(EventReplay *p) {
+    p->next[0] = '\0';
+    while (fgets(p->next, sizeof(p->next), p->f)) {
+        p->line++;
+        p->next[strcspn(p->next, "\r\n")] = '\0';
+        if (p->next[0]) return;
+    }
+    p->next[0] = '\0';
+}
+
+static int bad_line(EventReplay *p) {
+    fprintf(stderr, "%s:%d: bad event line: %s\n", p->path, p->line, p->next);
+    return -1;
+}
+
+int replay_open(EventReplay *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+    p->path = path;
+    p->f = fopen(path, "r");
+    if (!p->f) {
+        fprintf(stderr, "can't open recording %s\n", path);
+        return -1;
+    }
+    advance(p);
+    if (strcmp(p->next, REC_MAGIC) != 0) {
+        fprintf(stderr, "%s: not a chrmaker recording\n", path);
+        replay_close(p);
+        return -1;
+    }
+    advance(p);
+    return 0;
+}
+
+int replay_frame(EventReplay *p, uint32_t *ticks) {
+    if (!p->next[0]) return 0;
+    unsigned t;
+    char end;
+    if (sscanf(p->next, "f %u %c", &t, &end) != 1) return bad_line(p);
+    *ticks = (uint32_t)t;
+    advance(p);
+    return 1;
+}
+
+int replay_event(EventReplay *p, SDL_Event *e) {
+    const char *l = p->next;
+    if (!l[0] || (l[0] == 'f' && l[1] == ' ')) return 0;
+
+    char name[8];
+    unsigned mods;
+    int used = 0;
+    if (sscanf(l, "%7s %x%n", name, &mods, &used) != 2) return bad_line(p);
+    /* Exactly one space follows the mods, so text and drop paths keep
+       any leading spaces of their own.                               */
+    const char *rest = l + used;
+    if (*rest == ' ') rest++;
+    int a, b, c, d, n = 0;
+    unsigned u;
+
+    memset(e, 0, sizeof(*e));
+    if (!strcmp(name, "quit")) {
+        e->type = SDL_QUIT;
+    } else if (!strcmp(name, "kd") || !strcmp(name, "ku")) {
+        if (sscanf(rest, "%d %d %x %d%n", &a, &b, &u, &c, &n) != 4 || rest[n])
+            return bad_line(p);
+        e->type = name[1] == 'd' ? SDL_KEYDOWN : SDL_KEYUP;
+        e->key.state          = name[1] == 'd' ? SDL_PRESSED : SDL_RELEASED;
+        e->key.keysym.scancode = (SDL_Scancode)a;
+        e->key.keysym.sym      = (SDL_Keycode)b;
+        e->key.keysym.mod      = (Uint16)u;
+        e->key.repeat          = (Uint8)c;
+    } else if (!strcmp(name, "bd") || !strcmp(name, "bu")) {
+        if (sscanf(rest, "%d %d %d %d%n", &a, &b, &c, &d, &n) != 4 || rest[n])
+            return bad_line(p);
+        e->type = name[1] == 'd' ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+        e->button.state  = name[1] == 'd' ? SDL_PRESSED : SDL_RELEASED;
+        e->button.x      = a;
+        e->button.y      = b;
+        e->button.button = (Uint8)c;
+        e->button.clicks = (Uint8)d;
+    } else if (!strcmp(name, "mm")) {
+        if (sscanf(rest, "%d %d %d %d %u%n", &a, &b, &c, &d, &u, &n) != 5 || rest[n])
+            return bad_line(p);
+        e->type = SDL_MOUSEMOTION;
+        e->motion.x     = a;
+        e->motion.y     = b;
+        e->motion.xrel  = c;
+        e->motion.yrel  = d;
+        e->motion.state = u;
+    } else if (!strcmp(name, "wh")) {
+        if (sscanf(rest, "%d %d %u%n", &a, &b, &u, &n) != 3 || rest[n])
+            return bad_line(p);
+        e->type = SDL_MOUSEWHEEL;
+        e->wheel.x         = a;
+        e->wheel.y         = b;
+        e->wheel.direction = u;
+    } else if (!strcmp(name, "tx")) {
+        e->type = SDL_TEXTINPUT;
+        snprintf(e->text.text, sizeof(e->text.text), "%s", rest);
+    } else if (!strcmp(name, "drop")) {
+        e->type = SDL_DROPFILE;
+        e->drop.file = SDL_strdup(rest);
+        if (!e->drop.file) return bad_line(p);
+    } else {
+        return bad_line(p);
+    }
+    SDL_SetModState((SDL_Keymod)mods);
+    advance(p);
+    return 1;
+}
+
+/* The whole path, '/' → '%', names the copy, so files with the same
+   name in different directories stay apart.                       */
+const char *replay_file(EventReplay *p, const char *path, bool write,
+                        char *buf, size_t cap) {
+    if (!p) return path;
+    if (!p->scratch[0]) {
+        if (!write) return path;        /* nothing written yet */
+        const char *tmp = getenv("TMPDIR");
+        snprintf(p->scratch, sizeof(p->scratch), "%s/chrmaker-replay-XXXXXX",
+                 tmp && tmp[0] ? tmp : "/tmp");
+        if (!mkdtemp(p->scratch))       /* writes then fail on the missing directory */
+            fprintf(stderr, "can't create %s; replayed saves will fail\n", p->scratch);
+    }
+    int n = snprintf(buf, cap, "%s/", p->scratch);
+    for (const char *c = path; *c && n + 1 < (int)cap; c++) buf[n++] = *c == '/' ? '%' : *c;
+    buf[n < (int)cap ? n : (int)cap - 1] = '\0';
+    if (write) return buf;
+    FILE *probe = fopen(buf, "rb");
+    if (!probe) return path;
+    fclose(probe);
+    return buf;
+}
+
+void replay_close(EventReplay *p) {
+    if (p->f) fclose(p->f);
+    p->f = NULL;
+    if (!p->scratch[0]) return;
+    DIR *d = opendir(p->scratch);
+    if (d) {
+        char f[512];
+        for (struct dirent *de; (de = readdir(d)); ) {
+            if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) continue;
+            snprintf(f, sizeof(f), "%s/%s", p->scratch, de->d_name);
+            unlink(f);
+        }
+        closedir(d);
+        rmdir(p->scratch);
+    }
+    p->scratch[0] = '\0';
+}
+
+/* ── Frame times ─────────────────────────────────────────────── */
+
+void frametimes_add(FrameTimes *ft, double ms) {
+    if (ft->n == ft->cap) {
+        int cap = ft->cap ? ft->cap * 2 : 1024;
+        double *m = realloc(ft->ms, (size_t)cap * sizeof(*m));
+        if (!m) return;             /* keep what we have */
+        ft->ms  = m;
+        ft->cap = cap;
+    }
+    ft->ms[ft->n++] = ms;
+}
+
+void frametimes_free(FrameTimes *ft) {
+    free(ft->ms);
+    memset(ft, 0, sizeof(*ft));
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+double frametimes_pct(const FrameTimes *ft, double p) {
+    if (ft->n == 0) return 0;
+    double *s = malloc((size_t)ft->n * sizeof(*s));
+    if (!s) return 0;
+    memcpy(s, ft->ms, (size_t)ft->n * sizeof(*s));
+    qsort(s, (size_t)ft->n, sizeof(*s), cmp_double);
+    int k = (int)(p / 100.0 * ft->n + 0.999999);   /* nearest rank */
+    if (k < 1) k = 1;
+    if (k > ft->n) k = ft->n;
+    double v = s[k - 1];
+    free(s);
+    return v;
+}
+
+int frametimes_report(const FrameTimes *ft, FILE *out, const char *csv_path) {
+    double sum = 0;
+    int worst = 0;
+    for (int i = 0; i < ft->n; i++) {
+        sum += ft->ms[i];
+        if (ft->ms[i] > ft->ms[worst]) worst = i;
+    }
+    fprintf(out, "replay: %d frame(s), mean %.3f ms, p50 %.3f, p95 %.3f, p99 %.3f, "
+                 "max %.3f ms (frame %d)\n",
+            ft->n, ft->n ? sum / ft->n : 0.0, frametimes_pct(ft, 50),
+            frametimes_pct(ft, 95), frametimes_pct(ft, 99),
+            ft->n ? ft->ms[worst] : 0.0, worst);
+    if (!csv_path) return 0;
+
+    FILE *f = fopen(csv_path, "w");
+    if (!f) return -1;
+    fprintf(f, "frame,ms\n");
+    for (int i = 0; i < ft->n; i++) fprintf(f, "%d,%.4f\n", i, ft->ms[i]);
+    return fclose(f) == 0 ? 0 : -1;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* ── Event recording and replay ──────────────────────────────────
+   --record=FILE writes every event handed to input_handle, grouped
+   by main-loop frame, as text:
+
+       chrmaker-events 1
+       f 1840                      frame, with its clock (ms)
+       mm 0000 312 140 2 -1 0      mouse motion: mods x y xrel yrel state
+       bd 0000 312 140 1 1         button down:  mods x y button clicks
+       kd 0040 22 115 0040 0       key down:     mods scancode sym mod repeat
+       f 1857
+       ...
+
+   Every event line carries the keyboard modifier state when it was
+   handled (SDL_GetModState, which the mouse handlers consult).
+   --replay=FILE feeds a recording back: each frame gets the recorded
+   clock and its events in order, with the modifier state restored,
+   so a session drives the editor the same way on any machine.
+   Recorded saves and exports run in full but write into a scratch
+   directory (replay_file), so a replay never changes the files the
+   next one starts from.                                            */
+
+#define REC_MAGIC "chrmaker-events 1"
+
+typedef struct {
+    FILE *f;
+} EventRecorder;
+
+/* 0, or -1 if path can't be created. */
+int  rec_open(EventRecorder *r, const char *path);
+void rec_frame(EventRecorder *r, uint32_t ticks);
+/* Call before input_handle, which frees drop-file paths.  Events the
+   editor ignores are not written.                                 */
+void rec_event(EventRecorder *r, const SDL_Event *e);
+void rec_close(EventRecorder *r);
+
+typedef struct {
+    FILE       *f;
+    const char *path;
+    int         line;        /* of next[]                          */
+    char        next[1024];  /* look-ahead line, "" at end of file */
+    char        scratch[256];   /* directory for writes, made on the first */
+} EventReplay;
+
+/* 0, or -1 (message on stderr) if path is missing or not a recording. */
+int  replay_open(EventReplay *p, const char *path);
+
+/* Start the next frame: 1 and its clock, 0 at the end of the file,
+   -1 on a malformed line (message on stderr).                     */
+int  replay_frame(EventReplay *p, uint32_t *ticks);
+
+/* The current frame's next event: 1, or 0 when the frame has no more,
+   -1 on a malformed line.  Sets SDL's modifier state to the recorded
+   one.  Drop events carry an SDL_malloc'd path, as SDL's own do.  */
+int  replay_event(EventReplay *p, SDL_Event *e);
+
+/* The file a file operation on path should use: path itself unless
+   p is a replay (non-NULL).  A replay writes to a copy in its scratch
+   directory instead, and reads that copy once one has been written,
+   so a replayed save followed by a load still sees the saved data.
+   buf (cap bytes) holds the result when it isn't path.            */
+const char *replay_file(EventReplay *p, const char *path, bool write,
+                        char *buf, size_t cap);
+
+/* Also deletes the scratch directory and everything written to it. */
+void replay_close(EventReplay *p);
+
+/* ── Frame times ── */
+
+typedef struct {
+    double *ms;
+    int     n, cap;
+} FrameTimes;
+
+void frametimes_add(FrameTimes *ft, double ms);
+void frametimes_free(FrameTimes *ft);
+
+/* Percentile p (0-100) of the samples, nearest rank; 0 if none. */
+double frametimes_pct(const FrameTimes *ft, double p);
+
+/* One summary line (frames, mean, p50/p95/p99, worst frame) on out,
+   and if csv_path is set, "frame,ms" for every frame.  0, or -1 if
+   the CSV can't be written.                                       */
+int  frametimes_report(const FrameTimes *ft, FILE *out, const char *csv_path);
@@ -0,0 +1,164 @@
+#include "swrender.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SCREEN_W (COMPOSE_NT_W * TILE_W)     /* 256 */
+#define SCREEN_H (COMPOSE_NT_H * TILE_H)     /* 240 */
+
+static const uint8_t GRAY_RAMP[4] = { 0, 85, 170, 255 };
+
+uint32_t swr_master(int idx) {
+    const uint8_t *c = NES_MASTER_RGB[idx & 0x3F];
+    return SWR_ARGB(255, c[0], c[1], c[2]);
+}
+
+static void sub_lut(const SubPalette *sp, uint32_t lut[4]) {
+    for (int v = 0; v < 4; v++) lut[v] = swr_master(sp->idx[v]);
+}
+
+/* ── Sheet ───────────────────────────────────────────────────── */
+
+static void tile_opaque(const uint8_t px[TILE_H][TILE_W], const uint32_t lut[4],
+                        uint32_t *dst, int stride) {
+    for (int row = 0; row < TILE_H; row++, dst += stride)
+        for (int col = 0; col < TILE_W; col++)
+            dst[col] = lut[px[row][col] & 3];
+}
+
+void swr_sheet(const ChrPage *chr, const PaletteState *pal, int cols, int rows,
+               bool gray, bool s16, uint32_t *dst, int stride) {
+    uint32_t gray_lut[4], lut[PAL_COUNT][4];
+    for (int v = 0; v < 4; v++)
+        gray_lut[v] = SWR_ARGB(255, GRAY_RAMP[v], GRAY_RAMP[v], GRAY_RAMP[v]);
+    if (!gray)
+        for (int p = 0; p < PAL_COUNT; p++) sub_lut(&pal->sub[p], lut[p]);
+
+    int ntiles = cols * rows;
+    if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+    s16 = s16 && cols >= 2;
+    for (int t = 0; t < ntiles; t++) {
+        int tx, ty;
+        if (s16) {
+            /* p = 0 top-left, 1 bottom-left, 2 top-right, 3 bottom-right */
+            int p = t % 4, S = t / 4, sc = cols / 2;
+            tx = (S % sc) * 2 + (p >> 1);
+            ty = (S / sc) * 2 + (p & 1);
+            if (tx >= cols || ty >= rows) continue;
+        } else {
+            tx = t % cols;
+            ty = t / cols;
+        }
+        const uint32_t *l = gray ? gray_lut : lut[pal->tile_pal[t] & (PAL_COUNT - 1)];
+        tile_opaque(chr->px[t], l, dst + (ty * TILE_H) * stride + tx * TILE_W, stride);
+    }
+}
+
+/* ── Scene ───────────────────────────────────────────────────── */
+
+void swr_scene(const ChrPage *chr, const PaletteState *pal, const ComposeScene *sc,
+               int x0, int y0, int w, int h, uint32_t *dst, int stride) {
+    int x1 = x0 + w, y1 = y0 + h;
+    uint32_t lut[8][4];
+    for (int p = 0; p < 8; p++) sub_lut(&pal->sub[p], lut[p]);
+
+    uint32_t backdrop = lut[0][0];
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            dst[y * stride + x] = backdrop;
+
+    /* BG: per tile, only the rows and columns inside the rectangle. */
+    for (int ty = y0 / TILE_H; ty <= (y1 - 1) / TILE_H && ty < COMPOSE_NT_H; ty++) {
+        int r0 = y0 > ty * TILE_H ? y0 - ty * TILE_H : 0;
+        int r1 = y1 < (ty + 1) * TILE_H ? y1 - ty * TILE_H : TILE_H;
+        for (int tx = x0 / TILE_W; tx <= (x1 - 1) / TILE_W && tx < COMPOSE_NT_W; tx++) {
+            int tile = sc->nametable[ty][tx];
+            if (tile >= CHR_MAX_TILES) continue;
+            const uint32_t *l = lut[sc->attr[ty / 2][tx / 2] & 3];
+            int c0 = x0 > tx * TILE_W ? x0 - tx * TILE_W : 0;
+            int c1 = x1 < (tx + 1) * TILE_W ? x1 - tx * TILE_W : TILE_W;
+            uint32_t *d = dst + (ty * TILE_H - y0) * stride + (tx * TILE_W - x0);
+            for (int row = r0; row < r1; row++)
+                for (int col = c0; col < c1; col++) {
+                    int v = chr->px[tile][row][col] & 3;
+                    if (tile == 0 && v == 0) continue;   /* transparent BG */
+                    d[row * stride + col] = l[v];
+                }
+        }
+    }
+
+    /* Sprites, later ones on top. */
+    for (int i = 0; i < sc->sprite_count; i++) {
+        const ComposeSprite *sp = &sc->sprites[i];
+        int size = sp->s16 ? 16 : 8;
+        if (sp->x >= x1 || sp->x + size <= x0 || sp->y >= y1 || sp->y + size <= y0)
+            continue;
+        const uint32_t *l = lut[sp->palette & 7];
+        for (int row = 0; row < size; row++) {
+            int y = sp->y + row;
+            if (y < y0 || y >= y1 || y >= SCREEN_H) continue;
+            int sr = sp->vflip ? size - 1 - row : row;
+            for (int col = 0; col < size; col++) {
+                int x = sp->x + col;
+                if (x < x0 || x >= x1 || x >= SCREEN_W) continue;
+                int sc_ = sp->hflip ? size - 1 - col : col;
+                /* 16×16: column-major quadrants [0][2] / [1][3] */
+                int tile = sp->tile + (sp->s16 ? (sc_ / TILE_W) * 2 + sr / TILE_H : 0);
+                if (tile >= CHR_MAX_TILES) continue;
+                int v = chr->px[tile][sr % TILE_H][sc_ % TILE_W] & 3;
+                if (v == 0) continue;                    /* transparent */
+                dst[(y - y0) * stride + (x - x0)] = l[v];
+            }
+        }
+    }
+}
+
+/* ── Scaling, grids, export ──────────────────────────────────── */
+
+void swr_upscale(const uint32_t *src, int w, int h, int src_stride, int zoom,
+                 uint32_t *dst, int dst_stride) {
+    for (int y = 0; y < h; y++) {
+        uint32_t *d = dst + (size_t)y * zoom * dst_stride;
+        const uint32_t *s = src + (size_t)y * src_stride;
+        for (int x = 0; x < w; x++)
+            for (int k = 0; k < zoom; k++) d[x * zoom + k] = s[x];
+        for (int k = 1; k < zoom; k++)
+            memcpy(d + (size_t)k * dst_stride, d, (size_t)w * zoom * sizeof(*d));
+    }
+}
+
+static inline uint32_t blend(uint32_t under, uint32_t over) {
+    uint32_t a = over >> 24, r = 0;
+    for (int sh = 0; sh < 24; sh += 8) {
+        uint32_t u = (under >> sh) & 0xFF, o = (over >> sh) & 0xFF;
+        r |= ((o * a + u * (255 - a) + 127) / 255) << sh;
+    }
+    return r | (under & 0xFF000000u);
+}
+
+void swr_grid(uint32_t *dst, int stride, int w, int h, int step, uint32_t colour) {
+    if (step < 1) return;
+    for (int y = step; y < h; y += step)
+        for (int x = 0; x < w; x++)
+            dst[y * stride + x] = blend(dst[y * stride + x], colour);
+    for (int y = 0; y < h; y++) {
+        if (y % step == 0 && y > 0) continue;   /* crossings blend once */
+        for (int x = step; x < w; x += step)
+            dst[y * stride + x] = blend(dst[y * stride + x], colour);
+    }
+}
+
+int swr_to_image(const uint32_t *src, int w, int h, int stride, Image *img) {
+    img->rgb = malloc((size_t)w * h * 3);
+    if (!img->rgb) return -1;
+    img->w = w;
+    img->h = h;
+    uint8_t *d = img->rgb;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++, d += 3) {
+            uint32_t p = src[(size_t)y * stride + x];
+            d[0] = (uint8_t)(p >> 16);
+            d[1] = (uint8_t)(p >> 8);
+            d[2] = (uint8_t)p;
+        }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "chr.h"
+#include "compose.h"
+#include "image.h"
+
+/* ── Software renderer ───────────────────────────────────────────
+   Pixel kernels shared by the editor's streaming textures and by
+   headless output (batch mode, thumbnails, benchmarks).  Everything
+   draws 0xAARRGGBB pixels into a caller-provided buffer whose stride
+   is in pixels; nothing here knows about windows or SDL.  Colours
+   are resolved once per call into small lookup tables, so the inner
+   loops are a table read and a store per pixel.                   */
+
+#define SWR_ARGB(a, r, g, b) \
+    (((uint32_t)(a) << 24) | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+/* Grid colours, with the alpha they are blended at. */
+#define SWR_GRID_TILE  SWR_ARGB(130,  60, 100, 200)
+#define SWR_GRID_PIXEL SWR_ARGB( 55,  80,  80, 110)
+#define SWR_GRID_ATTR  SWR_ARGB( 80, 100,  60,  60)
+
+/* NES master colour idx ($00-$3F) as an opaque pixel. */
+uint32_t swr_master(int idx);
+
+/* The sheet's cols × rows tiles at 1×: (cols*8) × (rows*8) pixels.
+   Each tile uses its tile_pal sub-palette, or the grey ramp.  With
+   s16 (and cols >= 2) tiles follow the Sprite-16 layout: every four
+   consecutive tiles form one 16×16 block, [0][2] over [1][3].      */
+void swr_sheet(const ChrPage *chr, const PaletteState *pal, int cols, int rows,
+               bool gray, bool s16, uint32_t *dst, int stride);
+
+/* The rectangle [x0,x0+w) × [y0,y0+h) of a 256×240 scene, with dst
+   pointing at its top-left pixel: the backdrop (sub-palette 0
+   colour 0), BG tiles in their attribute palettes (tile 0's colour 0
+   is transparent), then sprites in index order with colour 0
+   transparent.                                                    */
+void swr_scene(const ChrPage *chr, const PaletteState *pal, const ComposeScene *sc,
+               int x0, int y0, int w, int h, uint32_t *dst, int stride);
+
+/* Nearest-neighbour scale of a w × h image by zoom into dst, which
+   must hold (w*zoom) × (h*zoom) pixels.                           */
+void swr_upscale(const uint32_t *src, int w, int h, int src_stride, int zoom,
+                 uint32_t *dst, int dst_stride);
+
+/* Blend lines in colour (its alpha used as opacity) at every
+   multiple of step inside a w × h image, borders excluded.        */
+void swr_grid(uint32_t *dst, int stride, int w, int h, int step, uint32_t colour);
+
+/* Copy a w × h pixel buffer into a new RGB Image.  0, or -1 if out
+   of memory.                                                      */
+int  swr_to_image(const uint32_t *src, int w, int h, int stride, Image *img);
@@ -0,0 +1,277 @@
+#include "tilehash.h"
+#include "export.h"
+#include <string.h>
+
+/* ── Planar helpers ──────────────────────────────────────────── */
+
+static uint64_t load_le64(const uint8_t *b) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | b[i];
+    return v;
+}
+
+/* Mirror each row: reverse the bits of every byte. */
+static uint64_t flip_h(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+    return v;
+}
+
+/* Mirror vertically: reverse the row (byte) order. */
+static uint64_t flip_v(uint64_t v) {
+    v = ((v >> 8)  & 0x00FF00FF00FF00FFull) | ((v & 0x00FF00FF00FF00FFull) << 8);
+    v = ((v >> 16) & 0x0000FFFF0000FFFFull) | ((v & 0x0000FFFF0000FFFFull) << 16);
+    return (v >> 32) | (v << 32);
+}
+
+/* splitmix64 finaliser */
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t hash_planes(const uint64_t p[2]) {
+    return mix64(p[0] ^ mix64(p[1] + 0x9E3779B97F4A7C15ull));
+}
+
+static bool planes_less(const uint64_t a[2], const uint64_t b[2]) {
+    return a[1] != b[1] ? a[1] < b[1] : a[0] < b[0];
+}
+
+/* ── Keys ────────────────────────────────────────────────────── */
+
+void tilehash_pack(const uint8_t raw[16], uint64_t plane[2]) {
+    plane[0] = load_le64(raw);
+    plane[1] = load_le64(raw + 8);
+}
+
+int tilehash_canon(const uint64_t plane[2], uint64_t canon[2]) {
+    int orient = 0;
+    canon[0] = plane[0]; canon[1] = plane[1];
+    for (int f = 1; f < 4; f++) {
+        uint64_t v[2];
+        for (int k = 0; k < 2; k++) {
+            v[k] = plane[k];
+            if (f & TH_FLIP_H) v[k] = flip_h(v[k]);
+            if (f & TH_FLIP_V) v[k] = flip_v(v[k]);
+        }
+        if (planes_less(v, canon)) {
+            canon[0] = v[0]; canon[1] = v[1];
+            orient = f;
+        }
+    }
+    return orient;
+}
+
+uint64_t tilehash_key(const uint64_t plane[2]) { return hash_planes(plane); }
+
+/* ── Index maintenance ───────────────────────────────────────── */
+
+void tilehash_update(TileHash *th, const ChrPage *chr, int tile) {
+    if (tile < 0 || tile >= CHR_MAX_TILES) return;
+
+    uint8_t raw[16];
+    export_encode_tile(chr->px[tile], raw);
+    tilehash_pack(raw, th->plane[tile]);
+    th->hash[tile]       = hash_planes(th->plane[tile]);
+    th->orient[tile]     = (uint8_t)tilehash_canon(th->plane[tile], th->canon[tile]);
+    th->canon_hash[tile] = hash_planes(th->canon[tile]);
+}
+
+void tilehash_rebuild(TileHash *th, const ChrPage *chr) {
+    for (int t = 0; t < CHR_MAX_TILES; t++) tilehash_update(th, chr, t);
+}
+
+/* ── Clustering ──────────────────────────────────────────────── */
+
+#define TH_TABLE 2048   /* power of two, >= 2 × CHR_MAX_TILES */
+
+int tilehash_clusters(const TileHash *th, int ntiles, bool flips,
+                      int16_t rep[], int16_t size[]) {
+    if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+    const uint64_t *h = flips ? th->canon_hash : th->hash;
+
+    int16_t table[TH_TABLE];   /* group representative, -1 = empty */
+    memset(table, 0xFF, sizeof(table));
+
+    int dups = 0;
+    for (int t = 0; t < ntiles; t++) {
+        unsigned slot = (unsigned)h[t] & (TH_TABLE - 1);
+        for (;;) {
+            int r = table[slot];
+            if (r < 0) { table[slot] = (int16_t)t; rep[t] = (int16_t)t; break; }
+            if (h[r] == h[t] && tilehash_equal(th, r, t, flips)) {
+                rep[t] = (int16_t)r;
+                dups++;
+                break;
+            }
+            slot = (slot + 1) & (TH_TABLE - 1);
+        }
+    }
+
+    if (size) {
+        for (int t = 0; t < ntiles; t++) size[t] = 0;
+        for (int t = 0; t < ntiles; t++) size[rep[t]]++;
+        for (int t = 0; t < ntiles; t++) size[t] = size[rep[t]];
+    }
+    return dups;
+}
+
+/* ── Near-duplicate search ───────────────────────────────────── */
+
+/* Hardware popcount when the target has it; otherwise a SWAR count
+   made only of shifts, adds and masks, which vectorises on plain
+   SSE2 (no 64-bit multiply).                                      */
+#if defined(__GNUC__) && defined(__POPCNT__)
+#define popcount64(x) __builtin_popcountll(x)
+#else
+static inline int popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x += x >> 8;
+    x += x >> 16;
+    x += x >> 32;
+    return (int)(x & 0x7F);
+}
+#endif
+
+/* All four orientations of tile a (copies of a itself without flips). */
+static void orientations(const TileHash *th, int a, bool flips, uint64_t v[4][2]) {
+    for (int f = 0; f < 4; f++)
+        for (int k = 0; k < 2; k++) {
+            v[f][k] = th->plane[a][k];
+            if (flips && (f & TH_FLIP_H)) v[f][k] = flip_h(v[f][k]);
+            if (flips && (f & TH_FLIP_V)) v[f][k] = flip_v(v[f][k]);
+        }
+}
+
+/* Distance from orientations v[0..3] to tile b, and the best flip. */
+static inline int min_dist4(const uint64_t v[4][2], uint64_t b0, uint64_t b1,
+                            int *flip) {
+    int best = 65;
+    for (int f = 0; f < 4; f++) {
+        int d = popcount64((b0 ^ v[f][0]) | (b1 ^ v[f][1]));
+        if (d < best) { best = d; *flip = f; }
+    }
+    return best;
+}
+
+#if defined(__GNUC__)
+/* Two tiles per step with GCC vector extensions.  The min is a plain
+   lane-wise op (SSE2/NEON and up); the popcount is the hardware one
+   per lane when the target has it, else the SWAR count lane-wise.  */
+typedef uint64_t u64x2 __attribute__((vector_size(16)));
+
+static inline u64x2 popcount_x2(u64x2 x) {
+#if defined(__POPCNT__)
+    return (u64x2){ (uint64_t)popcount64(x[0]), (uint64_t)popcount64(x[1]) };
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x += x >> 8;
+    x += x >> 16;
+    x += x >> 32;
+    return x & 0x7F;
+#endif
+}
+
+static inline u64x2 min_x2(u64x2 a, u64x2 b) {
+    u64x2 lt = (u64x2)(a < b);
+    return (a & lt) | (b & ~lt);
+}
+#endif
+
+/* Distances from orientations v to tiles b0..n-1, whose planes come
+   split into two flat arrays.                                     */
+static void distance_row(const uint64_t *p0, const uint64_t *p1,
+                         const uint64_t v[4][2], int b0, int n, uint8_t dist[]) {
+    int b = b0;
+#if defined(__GNUC__)
+    for (; b + 2 <= n; b += 2) {
+        u64x2 x0, x1;
+        memcpy(&x0, p0 + b, sizeof(x0));
+        memcpy(&x1, p1 + b, sizeof(x1));
+        u64x2 d =     popcount_x2((x0 ^ v[0][0]) | (x1 ^ v[0][1]));
+        d = min_x2(d, popcount_x2((x0 ^ v[1][0]) | (x1 ^ v[1][1])));
+        d = min_x2(d, popcount_x2((x0 ^ v[2][0]) | (x1 ^ v[2][1])));
+        d = min_x2(d, popcount_x2((x0 ^ v[3][0]) | (x1 ^ v[3][1])));
+        dist[b]     = (uint8_t)d[0];
+        dist[b + 1] = (uint8_t)d[1];
+    }
+#endif
+    int f;
+    for (; b < n; b++) dist[b] = (uint8_t)min_dist4(v, p0[b], p1[b], &f);
+}
+
+static void split_planes(const TileHash *th, int n, uint64_t p0[], uint64_t p1[]) {
+    for (int t = 0; t < n; t++) { p0[t] = th->plane[t][0]; p1[t] = th->plane[t][1]; }
+}
+
+int tilehash_distance(const TileHash *th, int a, int b, bool flips, int *flip) {
+    uint64_t v[4][2];
+    int f = 0;
+    orientations(th, a, flips, v);
+    int d = min_dist4(v, th->plane[b][0], th->plane[b][1], &f);
+    if (flip) *flip = f;
+    return d;
+}
+
+int tilehash_nearest(const TileHash *th, int ntiles, int tile, bool flips,
+                     int k, TileMatch out[]) {
+    if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+    if (ntiles <= 0 || tile < 0 || tile >= ntiles || k <= 0) return 0;
+
+    uint64_t p0[CHR_MAX_TILES], p1[CHR_MAX_TILES], v[4][2];
+    uint8_t  dist[CHR_MAX_TILES];
+    split_planes(th, ntiles, p0, p1);
+    orientations(th, tile, flips, v);
+    distance_row(p0, p1, v, 0, ntiles, dist);
+
+    /* Insertion into a sorted top-k; scanning b upward keeps ties
+       in tile order.                                              */
+    int n = 0;
+    for (int b = 0; b < ntiles; b++) {
+        if (b == tile) continue;
+        if (n == k && dist[b] >= out[n - 1].dist) continue;
+        int i = (n < k) ? n++ : n - 1;
+        while (i > 0 && out[i - 1].dist > dist[b]) { out[i] = out[i - 1]; i--; }
+        out[i] = (TileMatch){ (int16_t)tile, (int16_t)b, dist[b], 0 };
+    }
+    for (int i = 0; i < n; i++) {
+        int f = 0, b = out[i].b;
+        min_dist4(v, p0[b], p1[b], &f);
+        out[i].flip = (uint8_t)f;
+    }
+    return n;
+}
+
+int tilehash_near_pairs(const TileHash *th, int ntiles, int max_dist,
+                        bool flips, TileMatch out[], int cap) {
+    if (ntiles > CHR_MAX_TILES) ntiles = CHR_MAX_TILES;
+    if (ntiles <= 0) return 0;
+
+    uint64_t p0[CHR_MAX_TILES], p1[CHR_MAX_TILES];
+    uint8_t  dist[CHR_MAX_TILES];
+    split_planes(th, ntiles, p0, p1);
+
+    int found = 0;
+    for (int a = 0; a + 1 < ntiles; a++) {
+        uint64_t v[4][2];
+        orientations(th, a, flips, v);
+        distance_row(p0, p1, v, a + 1, ntiles, dist);
+        for (int b = a + 1; b < ntiles; b++) {
+            if (dist[b] == 0 || dist[b] > max_dist) continue;
+            if (found < cap) {
+                int f = 0;
+                min_dist4(v, p0[b], p1[b], &f);
+                out[found] = (TileMatch){ (int16_t)a, (int16_t)b, dist[b], (uint8_t)f };
+            }
+            found++;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "chr.h"
+
+/* ── Tile hash index ─────────────────────────────────────────────
+   Per tile: its 16 planar bytes packed as two 64-bit words (plane 0,
+   plane 1; row r in byte r), a 64-bit hash of them, and the same for
+   the tile's canonical orientation — the smallest of its four H/V
+   flip variants — so flip-equivalent tiles share canon/canon_hash.
+   Updated one tile at a time as pixels are painted; equality tests
+   compare the packed words, so hash collisions never merge tiles. */
+
+#define TH_FLIP_H 1
+#define TH_FLIP_V 2
+
+typedef struct {
+    uint64_t plane[CHR_MAX_TILES][2];
+    uint64_t canon[CHR_MAX_TILES][2];
+    uint64_t hash[CHR_MAX_TILES];
+    uint64_t canon_hash[CHR_MAX_TILES];
+    uint8_t  orient[CHR_MAX_TILES];   /* TH_FLIP_* taking tile → canon */
+} TileHash;
+
+void tilehash_rebuild(TileHash *th, const ChrPage *chr);
+void tilehash_update(TileHash *th, const ChrPage *chr, int tile);
+
+/* The index's keys for a tile that isn't on a ChrPage: its 16 planar
+   bytes (export_encode_tile layout) packed into plane, the canonical
+   orientation of plane and the TH_FLIP_* mask taking plane there
+   (the return value), and the hash of either.                     */
+void     tilehash_pack(const uint8_t raw[16], uint64_t plane[2]);
+int      tilehash_canon(const uint64_t plane[2], uint64_t canon[2]);
+uint64_t tilehash_key(const uint64_t plane[2]);
+
+/* Same pixels (flips = false) or same up to an H/V flip. */
+static inline bool tilehash_equal(const TileHash *th, int a, int b, bool flips) {
+    const uint64_t (*k)[2] = flips ? th->canon : th->plane;
+    return k[a][0] == k[b][0] && k[a][1] == k[b][1];
+}
+
+/* For flip-equivalent a and b: the TH_FLIP_* mask that turns a into b. */
+static inline int tilehash_flip_between(const TileHash *th, int a, int b) {
+    return th->orient[a] ^ th->orient[b];
+}
+
+/* Group tiles 0..ntiles-1 by content (exact, or up to flips) in one
+   O(n) pass.  rep[t] is the lowest-numbered tile of t's group and
+   size[t] (optional) the group's member count.  Returns how many
+   tiles duplicate a lower-numbered one.                           */
+int tilehash_clusters(const TileHash *th, int ntiles, bool flips,
+                      int16_t rep[], int16_t size[]);
+
+/* ── Near-duplicate search ───────────────────────────────────────
+   Distance = number of pixels whose 2-bit value differs, computed as
+   popcount((a0 ^ b0) | (a1 ^ b1)) on the packed bitplanes.  With
+   flips, the smallest distance over the four orientations of a;
+   flip is then the TH_FLIP_* mask that takes a closest to b.      */
+
+#define TH_NEAR_DIST 4   /* default merge-candidate threshold (px) */
+
+typedef struct {
+    int16_t a, b;
+    uint8_t dist;       /* 0-64 differing pixels */
+    uint8_t flip;
+} TileMatch;
+
+int tilehash_distance(const TileHash *th, int a, int b, bool flips, int *flip);
+
+/* The k tiles of 0..ntiles-1 nearest to tile (itself excluded),
+   closest first, ties by tile number.  Returns the number written. */
+int tilehash_nearest(const TileHash *th, int ntiles, int tile, bool flips,
+                     int k, TileMatch out[]);
+
+/* All pairs a < b with 0 < dist <= max_dist — exact duplicates are
+   tilehash_clusters' job.  Writes at most cap matches in (a, b) order
+   and returns how many exist, which may exceed cap.               */
+int tilehash_near_pairs(const TileHash *th, int ntiles, int max_dist,
+                        bool flips, TileMatch out[], int cap);
@@ -0,0 +1,91 @@
+#define _POSIX_C_SOURCE 200809L
+#include "trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+bool trace_enabled = false;
+
+static FILE           *trace_f;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t        trace_base;          /* clock at trace_open (ns) */
+static atomic_int      next_tid = 1;
+static _Thread_local int my_tid;            /* 0 until first event      */
+
+/* Monotonic, so zones never run backwards when the wall clock is set. */
+static uint64_t clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t trace_now_ns(void) {
+    return clock_ns() - trace_base;
+}
+
+static int tid(void) {
+    if (!my_tid) my_tid = atomic_fetch_add(&next_tid, 1);
+    return my_tid;
+}
+
+/* Write s as a JSON string body. */
+static void put_escaped(FILE *f, const char *s) {
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20)         fprintf(f, "\\u%04x", c);
+        else                       fputc(c, f);
+    }
+}
+
+int trace_open(const char *path) {
+    trace_f = fopen(path, "w");
+    if (!trace_f) return -1;
+    trace_base = clock_ns();
+    fputs("[\n", trace_f);
+    fprintf(trace_f, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\","
+                     "\"args\":{\"name\":\"chrmaker\"}}");
+    trace_enabled = true;
+    return 0;
+}
+
+void trace_close(void) {
+    if (!trace_f) return;
+    pthread_mutex_lock(&trace_lock);
+    trace_enabled = false;
+    fputs("\n]\n", trace_f);
+    fclose(trace_f);
+    trace_f = NULL;
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_thread_name(const char *name) {
+    if (!trace_enabled) return;
+    int t = tid();
+    pthread_mutex_lock(&trace_lock);
+    if (trace_f) {
+        fprintf(trace_f, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+                         "\"args\":{\"name\":\"", t);
+        put_escaped(trace_f, name);
+        fputs("\"}}", trace_f);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_emit(const TraceZone *z, uint64_t t1) {
+    int t = tid();
+    pthread_mutex_lock(&trace_lock);
+    if (trace_f) {
+        fprintf(trace_f, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\","
+                         "\"ts\":%.3f,\"dur\":%.3f",
+                t, z->name, (double)z->t0 / 1000.0, (double)(t1 - z->t0) / 1000.0);
+        if (z->detail) {
+            fputs(",\"args\":{\"detail\":\"", trace_f);
+            put_escaped(trace_f, z->detail);
+            fputs("\"}", trace_f);
+        }
+        fputc('}', trace_f);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
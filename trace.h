@@ -0,0 +1,56 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ── Trace zones ─────────────────────────────────────────────────
+   Timed zones written as Chrome trace-event JSON, for chrome://tracing
+   or Perfetto.  A zone is opened and closed in the same scope:
+
+       TraceZone z = trace_begin("save");
+       ...
+       trace_end(z);
+
+   Each closed zone becomes one complete ("X") event on the calling
+   thread's track.  Names must be string literals (they are written
+   unescaped); set z.detail to attach a string such as a file path.
+   With tracing off, trace_begin is one test of a global flag and
+   trace_end one test of a field.
+
+   The file uses the JSON array format, which the viewers accept even
+   when the run dies before trace_close writes the closing bracket.
+   Events are written under a lock as they close.                  */
+
+typedef struct {
+    const char *name;
+    const char *detail;     /* optional; escaped on output */
+    uint64_t    t0;         /* ns since trace_open          */
+    bool        on;
+} TraceZone;
+
+/* Set by trace_open; read-only while other threads run. */
+extern bool trace_enabled;
+
+/* Start writing to path: 0, or -1 if it can't be created.  Call
+   before starting any threads that trace.                          */
+int  trace_open(const char *path);
+void trace_close(void);
+
+/* Name the calling thread's track, e.g. "main" or "par worker". */
+void trace_thread_name(const char *name);
+
+uint64_t trace_now_ns(void);
+void     trace_emit(const TraceZone *z, uint64_t t1);
+
+static inline TraceZone trace_begin(const char *name) {
+    TraceZone z = { name, NULL, 0, false };
+    if (trace_enabled) {
+        z.t0 = trace_now_ns();
+        z.on = true;
+    }
+    return z;
+}
+
+static inline void trace_end(TraceZone z) {
+    if (z.on) trace_emit(&z, trace_now_ns());
+}
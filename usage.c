@@ -0,0 +1,126 @@
+#include "usage.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ── List maintenance ────────────────────────────────────────── */
+
+static inline int32_t *next_of(UsageIndex *u, int node) {
+    return &u->scene[node / USAGE_SLOTS]->next[node % USAGE_SLOTS];
+}
+static inline int32_t *prev_of(UsageIndex *u, int node) {
+    return &u->scene[node / USAGE_SLOTS]->prev[node % USAGE_SLOTS];
+}
+
+static void unlink_slot(UsageIndex *u, int i, int slot) {
+    UsageScene *us = u->scene[i];
+    int t = us->tile[slot];
+    int p = us->prev[slot];
+    int n = us->next[slot];
+    if (p == USAGE_NONE) u->head[t] = n; else *next_of(u, p) = n;
+    if (n != USAGE_NONE) *prev_of(u, n) = p;
+    us->tile[slot] = USAGE_NO_TILE;
+    us->refs[t]--;
+    u->count[t]--;
+    if (slot >= USAGE_CELLS) u->spr[t]--;
+}
+
+static void link_slot(UsageIndex *u, int i, int slot, int t) {
+    UsageScene *us = u->scene[i];
+    int node = i * USAGE_SLOTS + slot;
+    int h    = u->head[t];
+    us->tile[slot] = (uint16_t)t;
+    us->prev[slot] = USAGE_NONE;
+    us->next[slot] = h;
+    if (h != USAGE_NONE) *prev_of(u, h) = node;
+    u->head[t] = node;
+    us->refs[t]++;
+    u->count[t]++;
+    if (slot >= USAGE_CELLS) u->spr[t]++;
+}
+
+static void set_slot(UsageIndex *u, int i, int slot, int t) {
+    if (t >= CHR_MAX_TILES) t = USAGE_NO_TILE;
+    if (u->scene[i]->tile[slot] == t) return;
+    if (u->scene[i]->tile[slot] != USAGE_NO_TILE) unlink_slot(u, i, slot);
+    if (t != USAGE_NO_TILE) link_slot(u, i, slot, t);
+}
+
+/* ── Public API ──────────────────────────────────────────────── */
+
+void usage_init(UsageIndex *u) {
+    memset(u, 0, sizeof(*u));
+    for (int t = 0; t < CHR_MAX_TILES; t++) u->head[t] = USAGE_NONE;
+}
+
+void usage_free(UsageIndex *u) {
+    for (int i = 0; i < COMPOSE_MAX_SCENES; i++) free(u->scene[i]);
+    usage_init(u);
+}
+
+int usage_sync_scene(UsageIndex *u, int i, const ComposeScene *sc) {
+    if (i < 0 || i >= COMPOSE_MAX_SCENES) return -1;
+    if (!u->scene[i]) {
+        UsageScene *us = calloc(1, sizeof(*us));
+        if (!us) return -1;
+        for (int k = 0; k < USAGE_SLOTS; k++) us->tile[k] = USAGE_NO_TILE;
+        u->scene[i] = us;
+    }
+
+    for (int y = 0; y < COMPOSE_NT_H; y++)
+        for (int x = 0; x < COMPOSE_NT_W; x++)
+            set_slot(u, i, y * COMPOSE_NT_W + x, sc->nametable[y][x]);
+
+    for (int k = 0; k < COMPOSE_MAX_SPR; k++) {
+        const ComposeSprite *sp = &sc->sprites[k];
+        bool live = k < sc->sprite_count;
+        for (int p = 0; p < 4; p++) {
+            int t = (live && (p == 0 || sp->s16)) ? sp->tile + p : USAGE_NO_TILE;
+            set_slot(u, i, USAGE_CELLS + k * 4 + p, t);
+        }
+    }
+    return 0;
+}
+
+int usage_rebuild(UsageIndex *u, const ComposeData *d) {
+    usage_free(u);
+    ComposeScene *tmp = malloc(sizeof(*tmp));
+    if (!tmp) return -1;
+    int rc = 0;
+    for (int i = 0; i < d->scene_count && rc == 0; i++) {
+        const ComposeScene *sc = compose_peek(d, i, tmp);
+        if (!sc) continue;   /* unreadable chunk: nothing to index */
+        rc = usage_sync_scene(u, i, sc);
+    }
+    free(tmp);
+    return rc;
+}
+
+void usage_decode(int node, UsageRef *out) {
+    int slot = node % USAGE_SLOTS;
+    out->scene = node / USAGE_SLOTS;
+    if (slot < USAGE_CELLS) {
+        out->sprite = false;
+        out->x = slot % COMPOSE_NT_W;
+        out->y = slot / COMPOSE_NT_W;
+        out->spr = out->part = -1;
+    } else {
+        out->sprite = true;
+        out->x = out->y = -1;
+        out->spr  = (slot - USAGE_CELLS) / 4;
+        out->part = (slot - USAGE_CELLS) % 4;
+    }
+}
+
+void usage_summary(const UsageIndex *u, int tile,
+                   int *bg, int *spr, int *scenes) {
+    int nb = 0, ns = 0, nsc = 0;
+    if (tile >= 0 && tile < CHR_MAX_TILES && u->count[tile] > 0) {
+        ns = (int)u->spr[tile];
+        nb = (int)u->count[tile] - ns;
+        for (int i = 0; i < COMPOSE_MAX_SCENES; i++)
+            if (usage_scene_refs(u, i, tile) > 0) nsc++;
+    }
+    if (bg)     *bg     = nb;
+    if (spr)    *spr    = ns;
+    if (scenes) *scenes = nsc;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "chr.h"
+#include "compose.h"
+
+/* ── Reverse tile-usage index ────────────────────────────────────
+   For every CHR tile, an intrusive doubly linked list of the
+   nametable cells and sprite quadrants (in any scene) that reference
+   it.  Each scene owns a fixed block of slots — 960 cells followed by
+   4 quadrants per sprite — and a node id is scene * USAGE_SLOTS +
+   slot.  Re-syncing a scene only relinks the slots whose tile
+   changed, and walking a list costs O(uses).                      */
+
+#define USAGE_CELLS   (COMPOSE_NT_W * COMPOSE_NT_H)         /* 960  */
+#define USAGE_SLOTS   (USAGE_CELLS + COMPOSE_MAX_SPR * 4)    /* 1216 */
+#define USAGE_NONE    (-1)
+#define USAGE_NO_TILE 0xFFFF
+
+typedef struct {
+    int32_t  next[USAGE_SLOTS];      /* node ids, USAGE_NONE = end       */
+    int32_t  prev[USAGE_SLOTS];
+    uint16_t tile[USAGE_SLOTS];      /* referenced tile or USAGE_NO_TILE */
+    uint16_t refs[CHR_MAX_TILES];    /* references per tile, this scene  */
+} UsageScene;
+
+typedef struct {
+    int32_t     head[CHR_MAX_TILES];     /* first node per tile         */
+    uint32_t    count[CHR_MAX_TILES];    /* references across scenes    */
+    uint32_t    spr[CHR_MAX_TILES];      /* ... of which sprite quadrants */
+    UsageScene *scene[COMPOSE_MAX_SCENES];
+} UsageIndex;
+
+/* A decoded node. */
+typedef struct {
+    int  scene;
+    bool sprite;
+    int  x, y;          /* BG: nametable cell                       */
+    int  spr, part;     /* sprite: index and quadrant (0-3, s16)    */
+} UsageRef;
+
+/* usage_init expects uninitialised (or freed) memory. */
+void usage_init(UsageIndex *u);
+void usage_free(UsageIndex *u);
+
+/* Bring scene i's entries in line with *sc.  Returns -1 only if the
+   per-scene block can't be allocated.                             */
+int  usage_sync_scene(UsageIndex *u, int i, const ComposeScene *sc);
+
+/* Drop everything and index all scenes of d (non-resident scenes are
+   decoded through compose_peek).  Call after loading scenes.       */
+int  usage_rebuild(UsageIndex *u, const ComposeData *d);
+
+static inline int usage_first(const UsageIndex *u, int tile) {
+    return (tile >= 0 && tile < CHR_MAX_TILES) ? u->head[tile] : USAGE_NONE;
+}
+static inline int usage_next(const UsageIndex *u, int node) {
+    return u->scene[node / USAGE_SLOTS]->next[node % USAGE_SLOTS];
+}
+static inline int usage_scene_refs(const UsageIndex *u, int i, int tile) {
+    return u->scene[i] ? u->scene[i]->refs[tile] : 0;
+}
+
+void usage_decode(int node, UsageRef *out);
+
+/* Totals for tile: BG cells, sprite quadrants, and scenes touched. */
+void usage_summary(const UsageIndex *u, int tile,
+                   int *bg, int *spr, int *scenes);
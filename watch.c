@@ -0,0 +1,326 @@
+#define _POSIX_C_SOURCE 200809L
+#include "watch.h"
+#include "chrfmt.h"
+#include "input.h"
+#include "trace.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static int  ino_fd = -1;
+static int  ino_wd = -1;
+static char dir[256];                   /* watched directory             */
+static char name[3][260];               /* basenames of .chr, .pal, .scn */
+static int      pending;                /* WATCH_* bits with events      */
+static uint32_t last_event;             /* ticks of the latest event     */
+
+static ChrPage      *base_chr;
+static PaletteState  base_pal;
+static uint64_t     *base_scene;        /* content hash per scene        */
+static int           base_scenes;
+
+int watch_open(void) {
+    base_chr   = calloc(1, sizeof(*base_chr));
+    base_scene = calloc(COMPOSE_MAX_SCENES, sizeof(*base_scene));
+    ino_fd     = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (!base_chr || !base_scene || ino_fd < 0) {
+        fprintf(stderr, "can't watch files for changes: %s\n",
+                ino_fd < 0 ? strerror(errno) : "out of memory");
+        watch_close();
+        return -1;
+    }
+    return 0;
+}
+
+void watch_close(void) {
+    if (ino_fd >= 0) close(ino_fd);
+    ino_fd = ino_wd = -1;
+    dir[0] = '\0';
+    free(base_chr);
+    free(base_scene);
+    base_chr   = NULL;
+    base_scene = NULL;
+}
+
+size_t watch_mem(void) {
+    if (ino_fd < 0) return 0;
+    return sizeof(*base_chr) + sizeof(base_pal) + COMPOSE_MAX_SCENES * sizeof(*base_scene);
+}
+
+/* ── Paths ───────────────────────────────────────────────────── */
+
+static const char *base_name(const char *path) {
+    const char *b = strrchr(path, '/');
+    return b ? b + 1 : path;
+}
+
+/* Watch the directory of chr_path, if that isn't the one watched. */
+static void follow(const char *chr_path) {
+    static const char *const EXT[3] = { NULL, ".pal", ".scn" };
+    char d[256], p[260];
+    const char *b = base_name(chr_path);
+    if (b == chr_path)          snprintf(d, sizeof(d), ".");
+    else if (b == chr_path + 1) snprintf(d, sizeof(d), "/");
+    else                        snprintf(d, sizeof(d), "%.*s", (int)(b - chr_path - 1), chr_path);
+
+    for (int k = 0; k < 3; k++) {
+        if (EXT[k]) chr_sidecar_path(p, sizeof(p), chr_path, EXT[k]);
+        else        snprintf(p, sizeof(p), "%s", chr_path);
+        snprintf(name[k], sizeof(name[k]), "%s", base_name(p));
+    }
+    if (ino_wd >= 0 && !strcmp(d, dir)) return;
+
+    if (ino_wd >= 0) inotify_rm_watch(ino_fd, ino_wd);
+    /* Writers that replace a file by renaming a temp over it show up
+       as IN_MOVED_TO, ones that rewrite it in place as IN_CLOSE_WRITE. */
+    ino_wd = inotify_add_watch(ino_fd, d, IN_CLOSE_WRITE | IN_MOVED_TO);
+    snprintf(dir, sizeof(dir), "%s", d);
+    pending = 0;
+}
+
+/* ── Content hashes ──────────────────────────────────────────── */
+
+static uint64_t fnv(uint64_t h, const void *p, size_t n) {
+    const uint8_t *b = p;
+    for (size_t i = 0; i < n; i++) h = (h ^ b[i]) * 0x100000001B3ull;
+    return h;
+}
+
+/* Field by field, so struct padding never counts. */
+static uint64_t scene_hash(const ComposeScene *sc) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    h = fnv(h, sc->nametable, sizeof(sc->nametable));
+    h = fnv(h, sc->attr, sizeof(sc->attr));
+    h = fnv(h, &sc->sprite_count, sizeof(sc->sprite_count));
+    for (int i = 0; i < sc->sprite_count && i < COMPOSE_MAX_SPR; i++) {
+        const ComposeSprite *p = &sc->sprites[i];
+        uint8_t f[8] = { p->x, p->y, (uint8_t)p->tile, (uint8_t)(p->tile >> 8),
+                         p->palette, (uint8_t)(p->hflip | p->vflip << 1 |
+                                               p->behind_bg << 2 | p->s16 << 3) };
+        h = fnv(h, f, sizeof(f));
+    }
+    return h;
+}
+
+void watch_base(const EditorState *s, int what) {
+    if (ino_fd < 0) return;
+    follow(s->current_path);
+    if (what & WATCH_CHR) *base_chr = s->chr;
+    if (what & WATCH_PAL) base_pal  = s->pal;
+    if (what & WATCH_SCN) {
+        static ComposeScene tmp;
+        for (int i = 0; i < s->compose.scene_count; i++) {
+            const ComposeScene *sc = compose_peek(&s->compose, i, &tmp);
+            base_scene[i] = sc ? scene_hash(sc) : 0;
+        }
+        base_scenes = s->compose.scene_count;
+    }
+}
+
+/* ── Merging ─────────────────────────────────────────────────── */
+
+enum { KEEP, TAKE, CONFLICT };
+
+/* One item of the three-way merge; base moves to the disk version. */
+static int merge3(const void *local, void *base, const void *disk, size_t n) {
+    int r = KEEP;
+    if (memcmp(disk, base, n) != 0 && memcmp(disk, local, n) != 0)
+        r = memcmp(local, base, n) == 0 ? TAKE : CONFLICT;
+    memcpy(base, disk, n);
+    return r;
+}
+
+typedef struct {
+    int  tiles, pals, scenes, conflicts;
+    bool checkpointed;
+} Merge;
+
+/* One undo step for the whole reload, pushed before the first change. */
+static void will_change(EditorState *s, Merge *m) {
+    if (!m->checkpointed) input_checkpoint(s);
+    m->checkpointed = true;
+}
+
+static int reload_chr(EditorState *s, Merge *m) {
+    ChrPage *disk = malloc(sizeof(*disk));
+    if (!disk) return -1;
+    ChrFormat fmt = s->chr_format >= 0 ? (ChrFormat)s->chr_format
+                                       : chrfmt_from_path(s->current_path);
+    int n = chrfmt_load(disk, s->current_path, fmt);
+    if (n < 0) { free(disk); return -1; }
+
+    for (int t = 0; t < CHR_MAX_TILES; t++) {
+        int r = merge3(s->chr.px[t], base_chr->px[t], disk->px[t], sizeof(disk->px[t]));
+        if (r == CONFLICT) m->conflicts++;
+        if (r != TAKE) continue;
+        will_change(s, m);
+        memcpy(s->chr.px[t], disk->px[t], sizeof(disk->px[t]));
+        input_mark_tile(s, t);
+        m->tiles++;
+    }
+    free(disk);
+
+    /* Grow the sheet to show tiles the file gained (as import does). */
+    int rows = (n + s->chr_cols - 1) / s->chr_cols;
+    if (rows > s->chr_rows && rows <= 64) {
+        s->chr_rows    = rows;
+        s->want_resize = true;
+    }
+    return 0;
+}
+
+static int reload_pal(EditorState *s, Merge *m) {
+    static PaletteState disk;
+    char pp[260];
+    chr_sidecar_path(pp, sizeof(pp), s->current_path, ".pal");
+    if (palette_load(&disk, pp) != 0) return -1;
+
+    int taken = m->pals;
+    for (int i = 0; i < PAL_COUNT; i++) {
+        int r = merge3(&s->pal.sub[i], &base_pal.sub[i], &disk.sub[i], sizeof(disk.sub[i]));
+        if (r == CONFLICT) m->conflicts++;
+        if (r != TAKE) continue;
+        will_change(s, m);
+        s->pal.sub[i] = disk.sub[i];
+        m->pals++;
+    }
+    for (int t = 0; t < CHR_MAX_TILES; t++) {
+        int r = merge3(&s->pal.tile_pal[t], &base_pal.tile_pal[t], &disk.tile_pal[t], 1);
+        if (r == CONFLICT) m->conflicts++;
+        if (r != TAKE) continue;
+        will_change(s, m);
+        s->pal.tile_pal[t] = disk.tile_pal[t];
+        m->pals++;
+    }
+    if (m->pals != taken) s->edit_rev++;
+    return 0;
+}
+
+/* Scenes merge whole.  The result is built on the freshly loaded file
+   (so scenes not yet resident are read from the new version) with
+   this side's changed scenes copied over it.  A scene counts as
+   changed here only if it is dirty — handed out for writing since the
+   last save or load — and its content differs from the base.  Every
+   scene the merge replaces, adds or drops goes into the undo step, so
+   undo restores the whole scene set (and with it the ground older
+   steps' remap and replace logs were recorded on).                 */
+static int reload_scn(EditorState *s, Merge *m) {
+    static ComposeScene dtmp, ltmp;
+    static uint64_t     hash[COMPOSE_MAX_SCENES];  /* the file's, before merging */
+    static bool         taken[COMPOSE_MAX_SCENES]; /* differs from the local scene */
+    char sp[260];
+    chr_sidecar_path(sp, sizeof(sp), s->current_path, ".scn");
+    ComposeData *disk = malloc(sizeof(*disk));
+    if (!disk) return -1;
+    compose_init(disk);
+    if (compose_load(disk, sp) != 0) {
+        compose_free(disk);
+        free(disk);
+        return -1;
+    }
+
+    ComposeData *local = &s->compose;
+    int  dn = disk->scene_count, ln = local->scene_count;
+    int  n  = dn > ln ? dn : ln;
+    bool changed = false;
+    for (int i = 0; i < n; i++) {
+        uint64_t dh = 0;
+        if (i < dn) {
+            const ComposeScene *sc = compose_peek(disk, i, &dtmp);
+            dh = hash[i] = sc ? scene_hash(sc) : 0;
+        }
+        /* Past the end of the file: changed if the disk dropped it. */
+        bool disk_changed = i < dn ? i >= base_scenes || dh != base_scene[i]
+                                   : i < base_scenes;
+        changed |= disk_changed;
+        taken[i] = disk_changed;
+        if (i >= ln) { m->scenes++; taken[i] = true; continue; }   /* new on disk */
+
+        const ComposeScene *lsc = NULL;
+        bool local_changed = i >= base_scenes;
+        if (local_changed || local->dirty[i]) {
+            lsc = compose_peek(local, i, &ltmp);
+            if (lsc && !local_changed) local_changed = scene_hash(lsc) != base_scene[i];
+        }
+        if (!lsc || !local_changed) {
+            if (disk_changed) m->scenes++;
+            continue;                                   /* disk's stands */
+        }
+        if (disk_changed && (i < dn ? dh != scene_hash(lsc) : true))
+            m->conflicts++;
+        /* Kept past the file's end: pad so it keeps its number. */
+        while (disk->scene_count <= i && compose_add_scene(disk) >= 0) {}
+        if (i >= disk->scene_count) continue;
+        *compose_scene(disk, i) = *lsc;
+        taken[i] = false;
+    }
+    memcpy(base_scene, hash, (size_t)dn * sizeof(hash[0]));
+    base_scenes = dn;
+
+    if (!changed) {
+        compose_free(disk);
+        free(disk);
+        return 0;
+    }
+    will_change(s, m);
+    /* Before local's source file is closed: scenes not resident are
+       read from it.  Out of memory, a scene just can't be undone.   */
+    for (int i = 0; i < n; i++)
+        if (taken[i] || i >= disk->scene_count) input_checkpoint_scene(s, i);
+    int active = local->active_scene;
+    compose_free(local);
+    *local = *disk;
+    free(disk);
+    compose_set_active(local, active);
+    usage_rebuild(&s->usage, local);
+    s->edit_rev++;
+    return 0;
+}
+
+int watch_poll(EditorState *s, char *msg, int msglen) {
+    if (ino_fd < 0) return 0;
+
+    /* Drain the queue; only the names of the watched files count. */
+    _Alignas(struct inotify_event) char buf[4096];
+    ssize_t len;
+    while ((len = read(ino_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            p += sizeof(*ev) + ev->len;
+            if (ev->wd != ino_wd || ev->len == 0) continue;
+            for (int k = 0; k < 3; k++)
+                if (!strcmp(ev->name, name[k])) {
+                    pending   |= 1 << k;
+                    last_event = s->ticks;
+                }
+        }
+    }
+    if (!pending || s->ticks - last_event < WATCH_SETTLE_MS) return 0;
+
+    int what = pending;
+    pending  = 0;
+    TraceZone z = trace_begin("hot reload");
+    Merge m = { 0 };
+    const char *failed = NULL;
+    if ((what & WATCH_CHR) && reload_chr(s, &m) != 0) failed = name[0];
+    if ((what & WATCH_PAL) && reload_pal(s, &m) != 0) failed = name[1];
+    if ((what & WATCH_SCN) && reload_scn(s, &m) != 0) failed = name[2];
+    trace_end(z);
+
+    if (failed) {
+        snprintf(msg, (size_t)msglen, "ERROR reloading %s", failed);
+        return 1;
+    }
+    if (!m.checkpointed && !m.conflicts) return 0;
+    snprintf(msg, (size_t)msglen, "reloaded %s: %d tile(s), %d palette value(s), %d scene(s)",
+             name[0], m.tiles, m.pals, m.scenes);
+    if (m.conflicts) {
+        size_t n = strlen(msg);
+        snprintf(msg + n, (size_t)msglen - n,
+                 "; %d conflict(s) kept local edits (save to overwrite)", m.conflicts);
+    }
+    return 1;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stddef.h>
+#include "main.h"
+
+/* ── Hot reload ──────────────────────────────────────────────────
+   Watches the directory of the open sheet (inotify) for new versions
+   of its .chr, .pal and .scn, and merges them into the document
+   without reopening it: view, zoom, selection and undo history stay.
+
+   The merge is three-way against a base, the files as last loaded
+   or saved.  Per tile, sub-palette, tile palette entry and scene:
+   changed only on disk → the disk version is taken; changed only
+   here → kept; changed on both sides to different values → kept
+   (a conflict: the next save overwrites the disk version).  Taken
+   tiles are marked changed for the renderer and ctl subscribers,
+   and all of one reload is a single undo step.
+
+   Events are acted on once the directory has been quiet for
+   WATCH_SETTLE_MS, so a build writing several files is one reload. */
+
+#define WATCH_SETTLE_MS 50
+
+enum { WATCH_CHR = 1, WATCH_PAL = 2, WATCH_SCN = 4, WATCH_ALL = 7 };
+
+/* Start watching: 0, or -1 with a message on stderr (reload is then
+   off).  The directory is picked up by the first watch_base.       */
+int  watch_open(void);
+void watch_close(void);
+
+/* Record the given WATCH_* parts of the document as matching their
+   files on disk; call after loading or saving them.  Also follows
+   current_path to a new directory.                                */
+void watch_base(const EditorState *s, int what);
+
+/* Merge files that changed on disk.  Returns 1 and a status line in
+   msg when the document changed or a file could not be read, else 0. */
+int  watch_poll(EditorState *s, char *msg, int msglen);
+
+/* Bytes held by the base copies. */
+size_t watch_mem(void);